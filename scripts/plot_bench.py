@@ -5,6 +5,26 @@ from pathlib import Path
 
 import matplotlib.pyplot as plt
 
+# Hardware counter columns written by graph_cli when perf counters are enabled.
+COUNTERS = ["cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"]
+
+LABELS = {
+    "time_ms": "Time, ms",
+    "cycles": "CPU cycles",
+    "instructions": "Instructions",
+    "l1d_misses": "L1D read misses",
+    "llc_misses": "LLC misses",
+    "branch_misses": "Branch misses",
+    "dtlb_misses": "dTLB read misses",
+    "ipc": "Instructions per cycle",
+}
+
+
+def parse_counter(value):
+    if value is None or value == "":
+        return None
+    return float(value)
+
 
 def load(paths):
     data = []
@@ -13,25 +33,59 @@ def load(paths):
             reader = csv.DictReader(f)
             for row in reader:
                 try:
-                    data.append(
-                        {
-                            "n": int(row["n"]),
-                            "m": int(row["m"]),
-                            "directed": row.get("directed", "0") in ("1", "true", "True"),
-                            "algo": row["algo"],
-                            "time_ms": float(row["time_us"]) / 1000.0,
-                            "source": Path(path).name,
-                        }
-                    )
+                    item = {
+                        "n": int(row["n"]),
+                        "m": int(row["m"]),
+                        "directed": row.get("directed", "0") in ("1", "true", "True"),
+                        "algo": row["algo"],
+                        "time_ms": float(row["time_us"]) / 1000.0,
+                        "source": Path(path).name,
+                    }
+                    for counter in COUNTERS:
+                        item[counter] = parse_counter(row.get(counter))
                 except (KeyError, ValueError):
                     continue
+                if item["cycles"] and item["instructions"] is not None:
+                    item["ipc"] = item["instructions"] / item["cycles"]
+                else:
+                    item["ipc"] = None
+                data.append(item)
     return data
 
 
+def plot_metric(ax, series, metric, per_edge):
+    plotted = False
+    for (algo, directed), rows in series.items():
+        rows = sorted((r for r in rows if r[metric] is not None), key=lambda r: r["n"])
+        if not rows:
+            continue
+        xs = [r["n"] for r in rows]
+        ys = [r[metric] / r["m"] if per_edge and r["m"] else r[metric] for r in rows]
+        label = f"{algo} ({'dir' if directed else 'undir'})"
+        ax.plot(xs, ys, marker="o", label=label)
+        plotted = True
+    ax.set_xlabel("Vertices (n)")
+    ax.set_ylabel(LABELS[metric] + (" per edge" if per_edge else ""))
+    ax.grid(True, linestyle="--", alpha=0.4)
+    if plotted:
+        ax.legend()
+    else:
+        ax.set_title(f"no {metric} data")
+    return plotted
+
+
 def main():
     parser = argparse.ArgumentParser(description="Plot shortest-path benchmarks (CSV from graph_cli).")
     parser.add_argument("csv", nargs="+", help="One or more bench.csv files")
     parser.add_argument("--out", help="Save plot to file instead of showing")
+    parser.add_argument(
+        "--metric",
+        nargs="+",
+        default=["time_ms"],
+        choices=list(LABELS) + ["all"],
+        help="Metrics to plot, one subplot each; 'all' plots time and every counter",
+    )
+    parser.add_argument("--per-edge", action="store_true", help="Divide counters by the edge count m")
     args = parser.parse_args()
 
     data = load(args.csv)
@@ -39,24 +93,18 @@ def main():
         print("No data to plot")
         return
 
+    metrics = ["time_ms"] + COUNTERS + ["ipc"] if "all" in args.metric else args.metric
+
     series = defaultdict(list)  # key: (algo, directed)
     for row in data:
         key = (row["algo"], row["directed"])
         series[key].append(row)
 
-    fig, ax = plt.subplots()
-    for (algo, directed), rows in series.items():
-        rows = sorted(rows, key=lambda r: r["n"])
-        xs = [r["n"] for r in rows]
-        ys = [r["time_ms"] for r in rows]
-        label = f"{algo} ({'dir' if directed else 'undir'})"
-        ax.plot(xs, ys, marker="o", label=label)
-
-    ax.set_xlabel("Vertices (n)")
-    ax.set_ylabel("Time, ms")
-    ax.set_title("Shortest path benchmark")
-    ax.grid(True, linestyle="--", alpha=0.4)
-    ax.legend()
+    fig, axes = plt.subplots(len(metrics), 1, figsize=(6.4, 4.0 * len(metrics)), squeeze=False)
+    for ax, metric in zip(axes[:, 0], metrics):
+        # time_ms keeps its absolute scale, per-edge normalization is meant for counters.
+        plot_metric(ax, series, metric, args.per_edge and metric not in ("time_ms", "ipc"))
+    axes[0, 0].set_title("Shortest path benchmark")
     plt.tight_layout()
 
     if args.out:
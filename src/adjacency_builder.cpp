@@ -0,0 +1,77 @@
+#include "adjacency_builder.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "parallel.hpp"
+
+// Arc references in the buckets: edge id times two, plus one for the backward arc.
+static size_t ArcRef(size_t edge_id, bool backward) {
+    return edge_id * 2 + (backward ? 1 : 0);
+}
+
+std::shared_ptr<ArraySequence<EdgeArcs>> BuildAdjacency(const Sequence<VertexPtr>& vertices,
+                                                        const ArraySequence<Edge>& edges, bool directed,
+                                                        size_t threads) {
+    const size_t n = vertices.GetLength();
+    const size_t m = edges.GetLength();
+    auto edge_arcs = std::make_shared<ArraySequence<EdgeArcs>>(m);
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, n));
+    const Edge* edge_data = edges.begin();
+    EdgeArcs* arcs = edge_arcs->begin();
+    auto part_of = [&](size_t v) { return v * threads / n; };
+    auto for_each_arc = [&](size_t chunk, auto&& fn) {
+        for (size_t id = m * chunk / threads; id < m * (chunk + 1) / threads; ++id) {
+            const Edge& edge = edge_data[id];
+            // Forward before backward, as AddEdge appends them; matters for self loops.
+            fn(part_of(edge.u), ArcRef(id, false));
+            if (!directed) {
+                fn(part_of(edge.v), ArcRef(id, true));
+            }
+        }
+    };
+
+    // counts[chunk * threads + part]: arcs of an edge chunk whose tail lies in a vertex range.
+    ArraySequence<size_t> counts(threads * threads, 0);
+    size_t* count_data = counts.begin();
+    ParallelFor(threads, threads, [&](size_t chunk, size_t) {
+        for_each_arc(chunk, [&](size_t part, size_t) { ++count_data[chunk * threads + part]; });
+    });
+
+    // Buckets are laid out by vertex range, and within one by edge chunk, so they stay in edge order.
+    // part_begin[part] is the first slot of a vertex range, the last one ends at part_begin[threads].
+    ArraySequence<size_t> offsets(threads * threads);
+    ArraySequence<size_t> part_begin(threads + 1);
+    size_t* offset_data = offsets.begin();
+    size_t total = 0;
+    for (size_t part = 0; part < threads; ++part) {
+        part_begin.Set(total, part);
+        for (size_t chunk = 0; chunk < threads; ++chunk) {
+            offset_data[chunk * threads + part] = total;
+            total += count_data[chunk * threads + part];
+        }
+    }
+    part_begin.Set(total, threads);
+
+    ArraySequence<size_t> bucketed(total);
+    size_t* bucket_data = bucketed.begin();
+    ParallelFor(threads, threads, [&](size_t chunk, size_t) {
+        for_each_arc(chunk, [&](size_t part, size_t ref) { bucket_data[offset_data[chunk * threads + part]++] = ref; });
+    });
+
+    ParallelFor(threads, threads, [&](size_t part, size_t) {
+        for (size_t i = part_begin.Get(part); i < part_begin.Get(part + 1); ++i) {
+            const size_t id = bucket_data[i] / 2;
+            const bool backward = bucket_data[i] % 2 == 1;
+            const Edge& edge = edge_data[id];
+            VertexPtr from = vertices.Get(backward ? edge.v : edge.u);
+            VertexPtr to = vertices.Get(backward ? edge.u : edge.v);
+            ListNodePtr<Arc> node = from->arcs->AppendNode({from, to, edge.weight, id, edge.modes});
+            (backward ? arcs[id].backward : arcs[id].forward) = std::move(node);
+        }
+    });
+    return edge_arcs;
+}
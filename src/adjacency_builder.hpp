@@ -0,0 +1,15 @@
+#pragma once
+
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "igraph.hpp"
+
+// Appends the arcs of `edges` to the adjacency lists of `vertices` and returns them by edge id.
+// Directed graphs get only forward arcs. Every list ends up exactly as sequential AddEdge calls
+// would leave it. One counting pass buckets the arcs by the vertex range of their tail, so each of
+// the `threads` workers (0 means hardware concurrency) appends only its own bucket and the total
+// work stays O(m). Endpoints must already be validated.
+std::shared_ptr<ArraySequence<EdgeArcs>> BuildAdjacency(const Sequence<VertexPtr>& vertices,
+                                                        const ArraySequence<Edge>& edges, bool directed,
+                                                        size_t threads);
@@ -186,6 +186,23 @@ public:
         return std::make_shared<ArraySequenceIterator<T>>(data_.GetBegin(), size_);
     }
 
+    // Contiguous storage, so plain pointers are random access iterators.
+    T* begin() {
+        return data_.GetBegin();
+    }
+
+    T* end() {
+        return data_.GetBegin() + size_;
+    }
+
+    const T* begin() const {
+        return data_.GetBegin();
+    }
+
+    const T* end() const {
+        return data_.GetBegin() + size_;
+    }
+
 private:
     size_t capacity_;
     size_t size_;
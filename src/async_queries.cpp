@@ -0,0 +1,102 @@
+#include "async_queries.hpp"
+
+#include <memory>
+#include <utility>
+
+#include "transport_state.hpp"
+
+QueryAwaitable::QueryAwaitable(AsyncQueryEngine& engine, size_t from, ArraySequence<size_t> targets,
+                               AsyncQueryOptions options)
+    : engine_(engine), from_(from), targets_(std::move(targets)), options_(std::move(options)) {
+}
+
+void QueryAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    engine_.Submit(from_, std::move(targets_), std::move(options_), [this, handle](AsyncQueryResult result) {
+        result_ = std::move(result);
+        handle.resume();
+    });
+}
+
+AsyncQueryResult QueryAwaitable::await_resume() {
+    if (result_.error != nullptr) {
+        std::rethrow_exception(result_.error);
+    }
+    return std::move(result_);
+}
+
+AsyncQueryEngine::AsyncQueryEngine(IGraphPtr graph, size_t threads, size_t cache_bytes)
+    : cache_(std::move(graph), cache_bytes), pool_(threads) {
+}
+
+std::future<AsyncQueryResult> AsyncQueryEngine::Submit(size_t from, ArraySequence<size_t> targets,
+                                                       AsyncQueryOptions options) {
+    auto promise = std::make_shared<std::promise<AsyncQueryResult>>();
+    std::future<AsyncQueryResult> future = promise->get_future();
+    Submit(from, std::move(targets), std::move(options), [promise](AsyncQueryResult result) {
+        if (result.error != nullptr) {
+            promise->set_exception(result.error);
+        } else {
+            promise->set_value(std::move(result));
+        }
+    });
+    return future;
+}
+
+void AsyncQueryEngine::Submit(size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options,
+                              std::function<void(AsyncQueryResult)> done) {
+    // std::function needs a copyable task, so the arguments live behind a shared_ptr.
+    struct Task {
+        size_t from;
+        ArraySequence<size_t> targets;
+        AsyncQueryOptions options;
+        std::function<void(AsyncQueryResult)> done;
+    };
+    auto task = std::make_shared<Task>(Task{from, std::move(targets), std::move(options), std::move(done)});
+    pool_.Post([this, task] {
+        AsyncQueryResult result;
+        try {
+            result = Run(task->from, task->targets, task->options);
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+        task->done(std::move(result));
+    });
+}
+
+QueryAwaitable AsyncQueryEngine::Query(size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options) {
+    return QueryAwaitable(*this, from, std::move(targets), std::move(options));
+}
+
+CacheStats AsyncQueryEngine::GetCacheStats() const {
+    return cache_.GetStats();
+}
+
+AsyncQueryResult AsyncQueryEngine::Run(size_t from, const ArraySequence<size_t>& targets,
+                                       const AsyncQueryOptions& options) {
+    AsyncQueryResult result;
+    result.stopped = options.cancel.Check();
+    if (result.stopped != StopReason::None || targets.GetLength() == 0) {
+        return result;
+    }
+    const std::shared_ptr<StateShortestPaths> finder = cache_.Get(from, options.algorithm, options.cancel);
+    result.stopped = finder->GetStopReason();
+    if (result.stopped != StopReason::None) {
+        return result;
+    }
+    result.distances = ArraySequence<int64_t>(targets.GetLength(), kInf);
+    if (options.with_paths) {
+        result.paths = ArraySequence<SequencePtr<size_t>>(targets.GetLength());
+    }
+    for (size_t i = 0; i < targets.GetLength(); ++i) {
+        result.stopped = options.cancel.Check();
+        if (result.stopped != StopReason::None) {
+            return result;
+        }
+        result.distances.Set(finder->GetDistance(targets.Get(i)), i);
+        if (options.with_paths) {
+            result.paths.Set(finder->GetShortestPath(targets.Get(i)), i);
+        }
+        result.answered = i + 1;
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+
+#include "array_sequence.hpp"
+#include "cancellation.hpp"
+#include "shortest_paths_cache.hpp"
+#include "thread_pool.hpp"
+
+struct AsyncQueryOptions {
+    Algorithm algorithm = Algorithm::Dijkstra;
+    // Also extract the vertex path to every target.
+    bool with_paths = false;
+    CancellationToken cancel;
+};
+
+// distances[i] (and paths[i] when requested, nullptr if unreachable) belong to targets[i]. A stopped
+// query keeps the entries filled before it stopped: the first `answered` targets.
+struct AsyncQueryResult {
+    StopReason stopped = StopReason::None;
+    size_t answered = 0;
+    ArraySequence<int64_t> distances;
+    ArraySequence<SequencePtr<size_t>> paths;
+    // Set when the query failed, e.g. on an out of range vertex.
+    std::exception_ptr error;
+
+    bool IsComplete() const {
+        return stopped == StopReason::None && error == nullptr;
+    }
+};
+
+class AsyncQueryEngine;
+
+// co_await engine.Query(...) suspends the coroutine until the result is ready and resumes it on a
+// worker thread of the engine. A failed query rethrows its error from co_await.
+class QueryAwaitable {
+public:
+    QueryAwaitable(AsyncQueryEngine& engine, size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options);
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    AsyncQueryResult await_resume();
+
+private:
+    AsyncQueryEngine& engine_;
+    size_t from_;
+    ArraySequence<size_t> targets_;
+    AsyncQueryOptions options_;
+    AsyncQueryResult result_;
+};
+
+// Runs one-to-many queries on an internal thread pool so the caller never blocks on a solve.
+// Queries are checked against their token when they are picked up, inside the solver loop and between
+// targets, so a cancelled or expired query stops using a worker within kStopPollInterval solver steps.
+class AsyncQueryEngine {
+public:
+    // threads == 0 means hardware concurrency. Solved trees are shared through a ShortestPathsCache.
+    AsyncQueryEngine(IGraphPtr graph, size_t threads = 0, size_t cache_bytes = size_t{64} << 20);
+
+    // Waits for the queries already submitted.
+    ~AsyncQueryEngine() = default;
+
+    // Errors are stored in the future and rethrown by get().
+    std::future<AsyncQueryResult> Submit(size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options = {});
+
+    // Calls done on a worker thread, also when the query fails or stops.
+    void Submit(size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options,
+                std::function<void(AsyncQueryResult)> done);
+
+    QueryAwaitable Query(size_t from, ArraySequence<size_t> targets, AsyncQueryOptions options = {});
+
+    CacheStats GetCacheStats() const;
+
+private:
+    ShortestPathsCache cache_;
+    // Last, so the workers are joined before the cache goes away.
+    ThreadPool pool_;
+
+    AsyncQueryResult Run(size_t from, const ArraySequence<size_t>& targets, const AsyncQueryOptions& options);
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include "array_sequence.hpp"
+
+// Min-heap on top of ArraySequence. Less defines the order, the smallest element is on top.
+template <typename T, typename Less = std::less<T>>
+class BinaryHeap {
+public:
+    BinaryHeap() {
+    }
+
+    explicit BinaryHeap(Less less) : less_(std::move(less)) {
+    }
+
+    bool IsEmpty() const {
+        return data_.GetLength() == 0;
+    }
+
+    size_t GetSize() const {
+        return data_.GetLength();
+    }
+
+    size_t GetCapacity() const {
+        return data_.GetCapacity();
+    }
+
+    const T& Top() const {
+        if (IsEmpty()) {
+            throw std::out_of_range("Heap is empty");
+        }
+        return data_.GetFirst();
+    }
+
+    void Push(const T& item) {
+        data_.Append(item);
+        SiftUp(data_.GetLength() - 1);
+    }
+
+    T Pop() {
+        if (IsEmpty()) {
+            throw std::out_of_range("Heap is empty");
+        }
+        T top = data_.GetFirst();
+        const size_t last = data_.GetLength() - 1;
+        if (last != 0) {
+            data_.Set(data_.Get(last), 0);
+        }
+        data_.EraseAt(last);
+        if (!IsEmpty()) {
+            SiftDown(0);
+        }
+        return top;
+    }
+
+    // Keeps the allocated storage so the heap can be reused between searches.
+    void Clear() {
+        data_.Clear();
+    }
+
+private:
+    ArraySequence<T> data_;
+    Less less_;
+
+    void SiftUp(size_t index) {
+        T* items = data_.begin();
+        T item = std::move(items[index]);
+        while (index > 0) {
+            const size_t parent = (index - 1) / 2;
+            if (!less_(item, items[parent])) {
+                break;
+            }
+            items[index] = std::move(items[parent]);
+            index = parent;
+        }
+        items[index] = std::move(item);
+    }
+
+    void SiftDown(size_t index) {
+        T* items = data_.begin();
+        const size_t size = data_.GetLength();
+        T item = std::move(items[index]);
+        while (true) {
+            size_t child = 2 * index + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && less_(items[child + 1], items[child])) {
+                ++child;
+            }
+            if (!less_(items[child], item)) {
+                break;
+            }
+            items[index] = std::move(items[child]);
+            index = child;
+        }
+        items[index] = std::move(item);
+    }
+};
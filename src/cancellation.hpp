@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stop_token>
+#include <utility>
+
+// Why a query stopped before finishing; None means it ran to completion.
+enum class StopReason : uint8_t {
+    None = 0,
+    Cancelled = 1,
+    DeadlineExceeded = 2,
+};
+
+// Cancellation request plus an optional deadline. The default token never stops; copies share the
+// stop state of the std::stop_source the token came from.
+struct CancellationToken {
+    using Clock = std::chrono::steady_clock;
+
+    std::stop_token stop;
+    Clock::time_point deadline = Clock::time_point::max();
+
+    static CancellationToken WithTimeout(Clock::duration timeout, std::stop_token stop = {}) {
+        return {std::move(stop), Clock::now() + timeout};
+    }
+
+    bool CanStop() const {
+        return stop.stop_possible() || deadline != Clock::time_point::max();
+    }
+
+    StopReason Check() const {
+        if (stop.stop_requested()) {
+            return StopReason::Cancelled;
+        }
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline) {
+            return StopReason::DeadlineExceeded;
+        }
+        return StopReason::None;
+    }
+};
+
+constexpr size_t kStopPollInterval = 4096;
+
+// Checks a token on the first call and then once per `interval` units of work, so a solver loop pays a
+// counter update per step and reads the clock a bounded number of times. Free for tokens that can never
+// stop.
+class StopPoller {
+public:
+    explicit StopPoller(const CancellationToken& token, size_t interval = kStopPollInterval)
+        : token_(token), active_(token.CanStop()), interval_(interval), budget_(0) {
+    }
+
+    bool ShouldStop(size_t work = 1) {
+        if (!active_) {
+            return false;
+        }
+        if (work < budget_) {
+            budget_ -= work;
+            return false;
+        }
+        budget_ = interval_;
+        reason_ = token_.Check();
+        return reason_ != StopReason::None;
+    }
+
+    StopReason GetReason() const {
+        return reason_;
+    }
+
+private:
+    CancellationToken token_;
+    bool active_;
+    size_t interval_;
+    size_t budget_;
+    StopReason reason_ = StopReason::None;
+};
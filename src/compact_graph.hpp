@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "igraph.hpp"
+
+// Packed arc record: 8 bytes for 32-bit weights, 12 bytes for 64-bit weights.
+#pragma pack(push, 4)
+template <typename Id, typename Weight>
+struct CompactArc {
+    Id vertex;
+    Weight weight;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CompactArc<uint32_t, int32_t>) == 8);
+static_assert(sizeof(CompactArc<uint32_t, int64_t>) == 12);
+
+// Immutable adjacency in CSR form: the arcs of vertex v are arcs_[offsets_[v], offsets_[v + 1]).
+// Transfer matrices are deduplicated into a small palette, vertices only store an index into it.
+template <typename Id, typename Weight>
+class CompactGraph {
+public:
+    using IdType = Id;
+    using WeightType = Weight;
+    using ArcType = CompactArc<Id, Weight>;
+
+    CompactGraph(size_t n, const Sequence<Edge>& edges, bool directed) : CompactGraph(n) {
+        for (auto it = edges.GetIterator(); it->HasNext(); it->Next()) {
+            const Edge& edge = it->GetCurrentItem();
+            CheckEdge(edge);
+            Count(edge.u);
+            if (!directed) {
+                Count(edge.v);
+            }
+        }
+        StartFilling();
+        for (auto it = edges.GetIterator(); it->HasNext(); it->Next()) {
+            const Edge& edge = it->GetCurrentItem();
+            Put(edge.u, edge.v, edge.weight);
+            if (!directed) {
+                Put(edge.v, edge.u, edge.weight);
+            }
+        }
+        FinishFilling();
+        edge_count_ = edges.GetLength();
+    }
+
+    static CompactGraph FromGraph(const IGraph& graph) {
+        CompactGraph res(graph.GetVertexCount());
+        for (size_t v = 0; v < res.vertex_count_; ++v) {
+            for (const Arc& arc : *graph.GetArcs(v)) {
+                res.CheckEdge({v, arc.vertex->id, arc.weight, arc.modes});
+                res.Count(v);
+            }
+        }
+        res.StartFilling();
+        std::map<decltype(TransferMatrix::cost), Id> palette_index = {{res.palette_.GetFirst().cost, 0}};
+        for (size_t v = 0; v < res.vertex_count_; ++v) {
+            for (const Arc& arc : *graph.GetArcs(v)) {
+                res.Put(v, arc.vertex->id, arc.weight);
+            }
+            const TransferMatrix& transfer = graph.GetVertex(v)->transfer;
+            auto [it, inserted] = palette_index.emplace(transfer.cost, static_cast<Id>(res.palette_.GetLength()));
+            if (inserted) {
+                res.palette_.Append(transfer);
+            }
+            res.transfer_index_.Set(it->second, v);
+        }
+        res.FinishFilling();
+        res.edge_count_ = graph.GetEdgeCount();
+        return res;
+    }
+
+    size_t GetVertexCount() const {
+        return vertex_count_;
+    }
+
+    size_t GetEdgeCount() const {
+        return edge_count_;
+    }
+
+    size_t GetArcCount() const {
+        return arcs_.GetSize();
+    }
+
+    std::span<const ArcType> GetArcs(size_t v) const {
+        if (v >= vertex_count_) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+        const size_t* offsets = offsets_.GetBegin();
+        return {arcs_.GetBegin() + offsets[v], arcs_.GetBegin() + offsets[v + 1]};
+    }
+
+    const TransferMatrix& GetTransfer(size_t v) const {
+        return palette_.Get(transfer_index_.Get(v));
+    }
+
+    // Calls fn(data, bytes) for every per-vertex and per-arc array, e.g. to give it a NUMA memory policy.
+    template <typename Fn>
+    void ForEachBuffer(Fn&& fn) const {
+        fn(static_cast<const void*>(offsets_.GetBegin()), offsets_.GetSize() * sizeof(size_t));
+        fn(static_cast<const void*>(arcs_.GetBegin()), arcs_.GetSize() * sizeof(ArcType));
+        fn(static_cast<const void*>(transfer_index_.GetBegin()), transfer_index_.GetSize() * sizeof(Id));
+    }
+
+    size_t GetMemoryUsage() const {
+        return sizeof(*this) + offsets_.GetSize() * sizeof(size_t) + arcs_.GetSize() * sizeof(ArcType) +
+               transfer_index_.GetSize() * sizeof(Id) + palette_.GetCapacity() * sizeof(TransferMatrix);
+    }
+
+private:
+    size_t vertex_count_;
+    size_t edge_count_ = 0;
+    DynamicArray<size_t> offsets_;
+    DynamicArray<ArcType> arcs_;
+    DynamicArray<Id> transfer_index_;
+    ArraySequence<TransferMatrix> palette_;
+
+    explicit CompactGraph(size_t n)
+        : vertex_count_(n), offsets_(n + 1, 0), transfer_index_(n, 0), palette_(1, TransferMatrix::Diagonal(0)) {
+        // Every vertex is split into kTransportCount solver states which must be addressable by Id.
+        if (n > std::numeric_limits<Id>::max() / kTransportCount) {
+            throw std::out_of_range("Vertex count does not fit into the compact id type");
+        }
+    }
+
+    void CheckEdge(const Edge& edge) const {
+        if (edge.u >= vertex_count_ || edge.v >= vertex_count_) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+        if (edge.weight < std::numeric_limits<Weight>::min() || edge.weight > std::numeric_limits<Weight>::max()) {
+            throw std::out_of_range("Edge weight does not fit into the compact weight type: " +
+                                    std::to_string(edge.weight));
+        }
+        // CompactArc has no room for them; such graphs stay on the list-based solvers.
+        if (!edge.modes.IsDefault()) {
+            throw std::invalid_argument("Compact graph does not support per-transport arc modes");
+        }
+    }
+
+    // Counting sort: Count() collects degrees, StartFilling() turns them into write cursors,
+    // Put() places arcs and FinishFilling() restores the offsets.
+    void Count(size_t v) {
+        ++offsets_.GetBegin()[v + 1];
+    }
+
+    void StartFilling() {
+        size_t* offsets = offsets_.GetBegin();
+        for (size_t v = 0; v < vertex_count_; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        arcs_ = DynamicArray<ArcType>(offsets[vertex_count_]);
+    }
+
+    void Put(size_t from, size_t to, int64_t weight) {
+        size_t& cursor = offsets_.GetBegin()[from];
+        arcs_.GetBegin()[cursor++] = {static_cast<Id>(to), static_cast<Weight>(weight)};
+    }
+
+    void FinishFilling() {
+        size_t* offsets = offsets_.GetBegin();
+        for (size_t v = vertex_count_; v > 0; --v) {
+            offsets[v] = offsets[v - 1];
+        }
+        offsets[0] = 0;
+    }
+};
+
+template <typename Id, typename Weight>
+using CompactGraphPtr = std::shared_ptr<const CompactGraph<Id, Weight>>;
+
+using CompactGraph32 = CompactGraph<uint32_t, int32_t>;
+using CompactGraph64 = CompactGraph<uint32_t, int64_t>;
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "array_sequence.hpp"
+#include "binary_heap.hpp"
+#include "cancellation.hpp"
+#include "compact_graph.hpp"
+#include "dynamic_array.hpp"
+#include "ishortest_paths.hpp"
+#include "path_view.hpp"
+#include "transport_state.hpp"
+
+// dist/prev storage passed from one solve to the next, so a worker running many sources allocates it
+// once (and, under a NUMA policy, on its own node). See CompactShortestPaths::TakeBuffers.
+template <typename Id>
+struct CompactBuffers {
+    DynamicArray<int64_t> dist;
+    DynamicArray<Id> prev;
+};
+
+// Shortest paths over CompactGraph. Same state model and answers as Dijkstra/FordBellman,
+// but predecessors are stored as Id and the per-state footprint is sizeof(int64_t) + sizeof(Id).
+template <typename Id, typename Weight>
+class CompactShortestPaths : public IShortestPathsFinder {
+public:
+    int64_t GetDistance(size_t to) const override {
+        if (to >= vertex_count_) {
+            throw std::out_of_range("Target vertex is out of range");
+        }
+        const size_t best_state = FindBestState(to);
+        return best_state == kNoState ? kInf : dist_.Get(best_state);
+    }
+
+    SequencePtr<size_t> GetShortestPath(size_t to) const override {
+        const BasicPathView<Id> view = GetPathView(to);
+        if (view.IsEmpty()) {
+            return nullptr;
+        }
+        auto res = std::make_shared<ArraySequence<size_t>>(view.GetVertexCount());
+        view.FillVertices(res->begin(), res->GetLength());
+        return res;
+    }
+
+    PathSteps GetShortestPathWithTransfers(size_t to) const override {
+        const BasicPathView<Id> view = GetPathView(to);
+        if (view.IsEmpty()) {
+            return nullptr;
+        }
+        auto res = std::make_shared<ArraySequence<PathStep>>(view.GetLength());
+        view.FillSteps(res->begin(), res->GetLength());
+        return res;
+    }
+
+    BasicPathView<Id> GetPathView(size_t to) const {
+        if (to >= vertex_count_) {
+            throw std::out_of_range("Target vertex is out of range");
+        }
+        return BasicPathView<Id>(prev_.GetBegin(), kNoCompactState, FindBestState(to), from_state_);
+    }
+
+    // Hands the dist/prev arrays to the next solve; the finder must not be queried afterwards.
+    CompactBuffers<Id> TakeBuffers() {
+        return {std::move(dist_), std::move(prev_)};
+    }
+
+    // Same meaning as StateShortestPaths::GetStopReason.
+    StopReason GetStopReason() const {
+        return stop_reason_;
+    }
+
+    bool IsComplete() const {
+        return stop_reason_ == StopReason::None;
+    }
+
+protected:
+    static constexpr Id kNoCompactState = std::numeric_limits<Id>::max();
+
+    CompactShortestPaths(const CompactGraph<Id, Weight>& graph, size_t from, CompactBuffers<Id> buffers)
+        : dist_(std::move(buffers.dist)),
+          prev_(std::move(buffers.prev)),
+          from_state_(EncodeState(from, kSourceTransport)),
+          vertex_count_(graph.GetVertexCount()) {
+        if (from >= vertex_count_) {
+            throw std::out_of_range("Source vertex is out of range");
+        }
+        const size_t state_count = GetStateCount(vertex_count_);
+        if (dist_.GetSize() == state_count && prev_.GetSize() == state_count) {
+            std::fill(dist_.GetBegin(), dist_.GetBegin() + state_count, kInf);
+            std::fill(prev_.GetBegin(), prev_.GetBegin() + state_count, kNoCompactState);
+        } else {
+            dist_ = DynamicArray<int64_t>(state_count, kInf);
+            prev_ = DynamicArray<Id>(state_count, kNoCompactState);
+        }
+        dist_.Set(0, from_state_);
+    }
+
+    // Returns the new distance of to_state or kInf if the candidate did not improve it.
+    int64_t Relax(size_t state, size_t to_state, int64_t delta_cost) {
+        AccumulatedPath candidate;
+        if (!AccumulatedPath{dist_.GetBegin()[state]}.Combine(delta_cost, candidate)) {
+            return kInf;
+        }
+        int64_t& current = dist_.GetBegin()[to_state];
+        if (candidate.total_cost >= current) {
+            return kInf;
+        }
+        current = candidate.total_cost;
+        prev_.GetBegin()[to_state] = static_cast<Id>(state);
+        return current;
+    }
+
+    DynamicArray<int64_t> dist_;
+    DynamicArray<Id> prev_;
+    size_t from_state_;
+    size_t vertex_count_;
+    StopReason stop_reason_ = StopReason::None;
+
+private:
+    size_t FindBestState(size_t vertex) const {
+        size_t best_state = kNoState;
+        int64_t best_distance = kInf;
+        for (Transport transport : kAllTransports) {
+            const size_t state = EncodeState(vertex, transport);
+            if (dist_.Get(state) < best_distance) {
+                best_distance = dist_.Get(state);
+                best_state = state;
+            }
+        }
+        return best_state;
+    }
+};
+
+template <typename Id, typename Weight>
+class CompactDijkstra : public CompactShortestPaths<Id, Weight> {
+public:
+    CompactDijkstra(CompactGraphPtr<Id, Weight> graph, size_t from, const CancellationToken& cancel = {})
+        : CompactDijkstra(graph, from, CompactBuffers<Id>{}, cancel) {
+    }
+
+    CompactDijkstra(CompactGraphPtr<Id, Weight> graph, size_t from, CompactBuffers<Id> buffers,
+                    const CancellationToken& cancel = {})
+        : CompactShortestPaths<Id, Weight>(*graph, from, std::move(buffers)) {
+        struct Entry {
+            int64_t distance;
+            Id state;
+
+            bool operator<(const Entry& other) const {
+                return distance < other.distance;
+            }
+        };
+
+        BinaryHeap<Entry> queue;
+        queue.Push({0, static_cast<Id>(this->from_state_)});
+        StopPoller poller(cancel);
+        while (!queue.IsEmpty()) {
+            if (poller.ShouldStop()) {
+                this->stop_reason_ = poller.GetReason();
+                break;
+            }
+            const Entry top = queue.Pop();
+            const size_t state = top.state;
+            if (top.distance != this->dist_.Get(state)) {
+                continue;
+            }
+            const size_t vertex_id = DecodeVertex(state);
+            const Transport current_transport = DecodeTransport(state);
+            const TransferMatrix& transfer = graph->GetTransfer(vertex_id);
+
+            for (Transport next_transport : kAllTransports) {
+                const int64_t step_cost = transfer.GetCost(current_transport, next_transport);
+                if (step_cost >= kNoTransferCost) {
+                    continue;
+                }
+                if (step_cost < 0) {
+                    throw std::invalid_argument("Dijkstra does not support negative edge weights");
+                }
+                const size_t to_state = EncodeState(vertex_id, next_transport);
+                const int64_t relaxed = this->Relax(state, to_state, step_cost);
+                if (relaxed != kInf) {
+                    queue.Push({relaxed, static_cast<Id>(to_state)});
+                }
+            }
+
+            for (const auto& arc : graph->GetArcs(vertex_id)) {
+                const int64_t weight = arc.weight;
+                if (weight < 0) {
+                    throw std::invalid_argument("Dijkstra does not support negative edge weights");
+                }
+                const size_t to_state = EncodeState(arc.vertex, current_transport);
+                const int64_t relaxed = this->Relax(state, to_state, weight);
+                if (relaxed != kInf) {
+                    queue.Push({relaxed, static_cast<Id>(to_state)});
+                }
+            }
+        }
+    }
+};
+
+template <typename Id, typename Weight>
+class CompactFordBellman : public CompactShortestPaths<Id, Weight> {
+public:
+    CompactFordBellman(CompactGraphPtr<Id, Weight> graph, size_t from, const CancellationToken& cancel = {})
+        : CompactFordBellman(graph, from, CompactBuffers<Id>{}, cancel) {
+    }
+
+    CompactFordBellman(CompactGraphPtr<Id, Weight> graph, size_t from, CompactBuffers<Id> buffers,
+                       const CancellationToken& cancel = {})
+        : CompactShortestPaths<Id, Weight>(*graph, from, std::move(buffers)) {
+        const size_t state_count = GetStateCount(this->vertex_count_);
+        StopPoller poller(cancel);
+        for (size_t iteration = 0; iteration + 1 < state_count && this->IsComplete(); ++iteration) {
+            bool updated = false;
+            for (size_t state = 0; state < state_count; ++state) {
+                if (poller.ShouldStop()) {
+                    this->stop_reason_ = poller.GetReason();
+                    break;
+                }
+                if (this->dist_.Get(state) == kInf) {
+                    continue;
+                }
+                const size_t vertex_id = DecodeVertex(state);
+                const Transport current_transport = DecodeTransport(state);
+                const TransferMatrix& transfer = graph->GetTransfer(vertex_id);
+
+                for (Transport next_transport : kAllTransports) {
+                    const int64_t step_cost = transfer.GetCost(current_transport, next_transport);
+                    if (step_cost >= kNoTransferCost) {
+                        continue;
+                    }
+                    if (this->Relax(state, EncodeState(vertex_id, next_transport), step_cost) != kInf) {
+                        updated = true;
+                    }
+                }
+
+                for (const auto& arc : graph->GetArcs(vertex_id)) {
+                    if (this->Relax(state, EncodeState(arc.vertex, current_transport), arc.weight) != kInf) {
+                        updated = true;
+                    }
+                }
+            }
+            if (!updated) {
+                break;
+            }
+        }
+    }
+};
+
+using CompactDijkstra32 = CompactDijkstra<uint32_t, int32_t>;
+using CompactDijkstra64 = CompactDijkstra<uint32_t, int64_t>;
+using CompactFordBellman32 = CompactFordBellman<uint32_t, int32_t>;
+using CompactFordBellman64 = CompactFordBellman<uint32_t, int64_t>;
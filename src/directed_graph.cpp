@@ -1,10 +1,13 @@
 #include "directed_graph.hpp"
 
 #include <stdexcept>
+#include <string>
 
+#include "adjacency_builder.hpp"
 #include "array_sequence.hpp"
 
-DirectedGraph::DirectedGraph(size_t n) : vertices_(std::make_shared<ArraySequence<VertexPtr>>(n)) {
+DirectedGraph::DirectedGraph(size_t n)
+    : vertices_(std::make_shared<ArraySequence<VertexPtr>>(n)), edges_(std::make_shared<ArraySequence<EdgeArcs>>()) {
     for (size_t i = 0; i < n; ++i) {
         vertices_->Set(std::make_shared<Vertex>(i), i);
     }
@@ -16,6 +19,19 @@ DirectedGraph::DirectedGraph(size_t n, SequencePtr<Edge> edges) : DirectedGraph(
     }
 }
 
+std::shared_ptr<DirectedGraph> DirectedGraph::Build(size_t n, const ArraySequence<Edge>& edges, size_t threads) {
+    for (const Edge& edge : edges) {
+        if (edge.u >= n || edge.v >= n) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+    }
+    auto res = std::make_shared<DirectedGraph>(n);
+    res->edges_ = BuildAdjacency(*res->vertices_, edges, true, threads);
+    res->edge_count_ = edges.GetLength();
+    res->version_ = edges.GetLength();
+    return res;
+}
+
 size_t DirectedGraph::GetVertexCount() const {
     return vertices_->GetLength();
 }
@@ -24,14 +40,21 @@ size_t DirectedGraph::GetEdgeCount() const {
     return edge_count_;
 }
 
-void DirectedGraph::AddEdge(const Edge& edge) {
+bool DirectedGraph::IsDirected() const {
+    return true;
+}
+
+size_t DirectedGraph::AddEdge(const Edge& edge) {
     if (edge.u >= GetVertexCount() || edge.v >= GetVertexCount()) {
         throw std::out_of_range("Vertex index is out of range");
     }
     VertexPtr from = GetVertex(edge.u);
     VertexPtr to = GetVertex(edge.v);
-    from->arcs->Append({from, to, edge.weight});
+    const size_t edge_id = edges_->GetLength();
+    edges_->Append({from->arcs->AppendNode({from, to, edge.weight, edge_id, edge.modes}), nullptr});
     ++edge_count_;
+    ++version_;
+    return edge_id;
 }
 
 VertexPtr DirectedGraph::GetVertex(size_t v) const {
@@ -41,3 +64,63 @@ VertexPtr DirectedGraph::GetVertex(size_t v) const {
 Arcs DirectedGraph::GetArcs(size_t v) const {
     return GetVertex(v)->arcs;
 }
+
+bool DirectedGraph::HasEdge(size_t edge_id) const {
+    return edge_id < edges_->GetLength() && edges_->Get(edge_id).forward != nullptr;
+}
+
+Edge DirectedGraph::GetEdge(size_t edge_id) const {
+    const Arc& arc = GetEdgeArcs(edge_id).forward->value;
+    return {arc.from->id, arc.vertex->id, arc.weight, arc.modes};
+}
+
+void DirectedGraph::UpdateEdgeWeight(size_t edge_id, int64_t weight) {
+    SetWeight(edge_id, weight);
+    ++version_;
+}
+
+void DirectedGraph::RemoveEdge(size_t edge_id) {
+    Remove(edge_id);
+    ++version_;
+}
+
+void DirectedGraph::ApplyUpdates(const Sequence<EdgeUpdate>& updates) {
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        GetEdgeArcs(it->GetCurrentItem().edge_id);
+    }
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        const EdgeUpdate& update = it->GetCurrentItem();
+        if (!HasEdge(update.edge_id)) {
+            // Removed earlier in the same batch.
+            continue;
+        }
+        if (update.remove) {
+            Remove(update.edge_id);
+        } else {
+            SetWeight(update.edge_id, update.weight);
+        }
+    }
+    ++version_;
+}
+
+uint64_t DirectedGraph::GetVersion() const {
+    return version_;
+}
+
+const EdgeArcs& DirectedGraph::GetEdgeArcs(size_t edge_id) const {
+    if (!HasEdge(edge_id)) {
+        throw std::out_of_range("No edge with id " + std::to_string(edge_id));
+    }
+    return edges_->Get(edge_id);
+}
+
+void DirectedGraph::SetWeight(size_t edge_id, int64_t weight) {
+    GetEdgeArcs(edge_id).forward->value.weight = weight;
+}
+
+void DirectedGraph::Remove(size_t edge_id) {
+    const EdgeArcs& arcs = GetEdgeArcs(edge_id);
+    arcs.forward->value.from->arcs->EraseNode(arcs.forward);
+    edges_->Set({}, edge_id);
+    --edge_count_;
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+
+#include "array_sequence.hpp"
 #include "igraph.hpp"
 
 class DirectedGraph : public IGraph {
@@ -8,11 +11,30 @@ public:
 
     DirectedGraph(size_t n, SequencePtr<Edge> edges);
 
+    // Same graph as adding the edges one by one (edge ids follow their order), but adjacency
+    // lists are filled in parallel, each thread owning a range of vertices. threads == 0 means
+    // hardware concurrency.
+    static std::shared_ptr<DirectedGraph> Build(size_t n, const ArraySequence<Edge>& edges, size_t threads = 0);
+
     size_t GetVertexCount() const override;
 
     size_t GetEdgeCount() const override;
 
-    void AddEdge(const Edge& edge) override;
+    bool IsDirected() const override;
+
+    size_t AddEdge(const Edge& edge) override;
+
+    bool HasEdge(size_t edge_id) const override;
+
+    Edge GetEdge(size_t edge_id) const override;
+
+    void UpdateEdgeWeight(size_t edge_id, int64_t weight) override;
+
+    void RemoveEdge(size_t edge_id) override;
+
+    void ApplyUpdates(const Sequence<EdgeUpdate>& updates) override;
+
+    uint64_t GetVersion() const override;
 
     VertexPtr GetVertex(size_t v) const override;
 
@@ -20,5 +42,13 @@ public:
 
 private:
     SequencePtr<VertexPtr> vertices_;
+    SequencePtr<EdgeArcs> edges_;
     size_t edge_count_ = 0;
+    uint64_t version_ = 0;
+
+    const EdgeArcs& GetEdgeArcs(size_t edge_id) const;
+
+    void SetWeight(size_t edge_id, int64_t weight);
+
+    void Remove(size_t edge_id);
 };
@@ -112,6 +112,10 @@ public:
         return data_;
     }
 
+    T* GetBegin() {
+        return data_;
+    }
+
 private:
     size_t size_ = 0;
     T* data_ = nullptr;
@@ -0,0 +1,380 @@
+#include "edge_list_loader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "directed_graph.hpp"
+#include "dynamic_array.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LAB3_HAS_MMAP 1
+#endif
+
+// Below this size a chunk is not worth a thread.
+constexpr size_t kMinChunkBytes = 1 << 20;
+constexpr size_t kChunksPerThread = 4;
+constexpr size_t kReadBlockBytes = 1 << 20;
+
+enum class Section { Edges, Transfers };
+
+struct ParseState {
+    // Line numbers in errors are first_line plus the newlines between origin and the bad field.
+    const char* origin = nullptr;
+    size_t first_line = 1;
+    size_t vertex_limit = 0;
+    Section section = Section::Edges;
+    bool header_allowed = true;
+    size_t vertex_end = 0;
+    ArraySequence<VertexTransfer>* transfers = nullptr;
+};
+
+[[noreturn]] static void Fail(const ParseState& state, const char* pos, const std::string& message) {
+    const size_t line = state.first_line + static_cast<size_t>(std::count(state.origin, pos, '\n'));
+    throw std::invalid_argument("Edge list line " + std::to_string(line) + ": " + message);
+}
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* SkipBlanks(const char* p, const char* end) {
+    while (p < end && IsBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static const char* SkipSeparators(const char* p, const char* end) {
+    while (p < end && (IsBlank(*p) || *p == ',')) {
+        ++p;
+    }
+    return p;
+}
+
+static const char* FindLineEnd(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl != nullptr ? static_cast<const char*>(nl) : end;
+}
+
+// Reads one field and the separators after it; the field must end at a separator or the line end.
+template <typename T>
+static bool ParseField(const char*& p, const char* end, T& value) {
+    const char* begin = p < end && *p == '+' ? p + 1 : p;
+    const auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc() || (ptr < end && !IsBlank(*ptr) && *ptr != ',')) {
+        return false;
+    }
+    p = SkipSeparators(ptr, end);
+    return true;
+}
+
+static bool ParseCost(const char*& p, const char* end, int64_t& cost) {
+    for (std::string_view word : {std::string_view("inf"), std::string_view("-")}) {
+        const size_t size = word.size();
+        if (static_cast<size_t>(end - p) >= size && std::string_view(p, size) == word &&
+            (p + size == end || IsBlank(p[size]) || p[size] == ',')) {
+            cost = kNoTransferCost;
+            p = SkipSeparators(p + size, end);
+            return true;
+        }
+    }
+    return ParseField(p, end, cost);
+}
+
+static void CheckVertex(ParseState& state, const char* pos, size_t v) {
+    if (state.vertex_limit != 0 && v >= state.vertex_limit) {
+        Fail(state, pos, "vertex " + std::to_string(v) + " is out of range");
+    }
+    state.vertex_end = std::max(state.vertex_end, v + 1);
+}
+
+static void ParseSectionLine(ParseState& state, const char* p, const char* end) {
+    const char* close = static_cast<const char*>(std::memchr(p, ']', static_cast<size_t>(end - p)));
+    if (close == nullptr || SkipBlanks(close + 1, end) != end) {
+        Fail(state, p, "malformed section header");
+    }
+    const char* name = SkipBlanks(p + 1, close);
+    const char* name_end = close;
+    while (name_end > name && IsBlank(name_end[-1])) {
+        --name_end;
+    }
+    if (std::string_view(name, static_cast<size_t>(name_end - name)) != "transfers") {
+        Fail(state, p, "unknown section [" + std::string(name, name_end) + "]");
+    }
+    state.section = Section::Transfers;
+}
+
+static void ParseTransferLine(ParseState& state, const char* p, const char* end) {
+    VertexTransfer item;
+    const char* start = p;
+    if (!ParseField(p, end, item.vertex)) {
+        Fail(state, p, "expected vertex id");
+    }
+    CheckVertex(state, start, item.vertex);
+    for (size_t i = 0; i < kTransportCount * kTransportCount; ++i) {
+        if (!ParseCost(p, end, item.transfer.cost[i / kTransportCount][i % kTransportCount])) {
+            Fail(state, p, "expected " + std::to_string(kTransportCount * kTransportCount) + " transfer costs");
+        }
+    }
+    if (p != end) {
+        Fail(state, p, "unexpected data after transfer costs");
+    }
+    state.transfers->Append(item);
+}
+
+template <typename Sink>
+static void ParseLine(ParseState& state, const char* p, const char* end, Sink& sink) {
+    p = SkipBlanks(p, end);
+    if (p == end || *p == '#' || *p == '%') {
+        return;
+    }
+    const bool header_allowed = state.header_allowed;
+    state.header_allowed = false;
+    if (*p == '[') {
+        ParseSectionLine(state, p, end);
+        return;
+    }
+    if (state.section == Section::Transfers) {
+        ParseTransferLine(state, p, end);
+        return;
+    }
+    if (header_allowed && std::isalpha(static_cast<unsigned char>(*p))) {
+        return;
+    }
+    const char* start = p;
+    Edge edge;
+    if (!ParseField(p, end, edge.u) || !ParseField(p, end, edge.v)) {
+        Fail(state, p, "expected \"u v [w]\"");
+    }
+    if (p != end && !ParseField(p, end, edge.weight)) {
+        Fail(state, p, "malformed weight");
+    }
+    if (p != end) {
+        Fail(state, p, "unexpected data after weight");
+    }
+    CheckVertex(state, start, edge.u);
+    CheckVertex(state, start, edge.v);
+    sink(edge);
+}
+
+template <typename Sink>
+static void ParseLines(ParseState& state, const char* p, const char* end, Sink& sink) {
+    while (p < end) {
+        const char* line_end = FindLineEnd(p, end);
+        ParseLine(state, p, line_end, sink);
+        if (line_end == end) {
+            break;
+        }
+        p = line_end + 1;
+    }
+}
+
+// The transfer section starts at the first line whose first non-blank character is '['.
+static const char* FindSection(const char* begin, const char* end) {
+    for (const char* p = begin; p < end; ++p) {
+        p = static_cast<const char*>(std::memchr(p, '[', static_cast<size_t>(end - p)));
+        if (p == nullptr) {
+            return end;
+        }
+        const char* line = p;
+        while (line > begin && IsBlank(line[-1])) {
+            --line;
+        }
+        if (line == begin || line[-1] == '\n') {
+            return line;
+        }
+    }
+    return end;
+}
+
+// Skips leading blank and comment lines and a CSV header, so every parallel chunk starts at data.
+static const char* SkipPreamble(const char* p, const char* end) {
+    while (p < end) {
+        const char* line_end = FindLineEnd(p, end);
+        const char* first = SkipBlanks(p, line_end);
+        if (first != line_end && *first != '#' && *first != '%') {
+            return std::isalpha(static_cast<unsigned char>(*first)) ? std::min(line_end + 1, end) : p;
+        }
+        if (line_end == end) {
+            break;
+        }
+        p = line_end + 1;
+    }
+    return end;
+}
+
+static ArraySequence<Edge> ToSequence(DynamicArray<Edge> edges, size_t count) {
+    if (count == 0) {
+        return {};
+    }
+    edges.Resize(count);
+    return ArraySequence<Edge>(std::move(edges));
+}
+
+EdgeList ParseEdgeList(std::string_view text, const EdgeListOptions& options) {
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    const char* const section = FindSection(begin, end);
+    const char* const data = SkipPreamble(begin, section);
+
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    const size_t size = static_cast<size_t>(section - data);
+    const size_t chunk_count = std::clamp<size_t>(size / kMinChunkBytes, 1, threads * kChunksPerThread);
+    ArraySequence<const char*> bounds(chunk_count + 1, data);
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const char* split = std::max(data + size * i / chunk_count, bounds.Get(i - 1));
+        bounds.Set(std::min(FindLineEnd(split, section) + 1, section), i);
+    }
+    bounds.Set(section, chunk_count);
+
+    // Line counts bound the edge counts, so every chunk parses straight into its slice of one array.
+    ArraySequence<size_t> offsets(chunk_count + 1, 0);
+    ParallelFor(chunk_count, threads, [&](size_t i, size_t) {
+        offsets.begin()[i + 1] = static_cast<size_t>(std::count(bounds.Get(i), bounds.Get(i + 1), '\n')) + 1;
+    });
+    for (size_t i = 0; i < chunk_count; ++i) {
+        offsets.begin()[i + 1] += offsets.Get(i);
+    }
+    DynamicArray<Edge> edges(offsets.Get(chunk_count));
+    ArraySequence<size_t> counts(chunk_count, 0);
+    ArraySequence<size_t> vertex_ends(chunk_count, 0);
+    ParallelFor(chunk_count, threads, [&](size_t i, size_t) {
+        ParseState state;
+        state.origin = begin;
+        state.vertex_limit = options.vertex_count;
+        state.header_allowed = false;
+        Edge* out = edges.GetBegin() + offsets.Get(i);
+        size_t count = 0;
+        auto sink = [&](const Edge& edge) { out[count++] = edge; };
+        ParseLines(state, bounds.Get(i), bounds.Get(i + 1), sink);
+        counts.begin()[i] = count;
+        vertex_ends.begin()[i] = state.vertex_end;
+    });
+
+    size_t edge_count = 0;
+    size_t vertex_end = 0;
+    for (size_t i = 0; i < chunk_count; ++i) {
+        const Edge* chunk = edges.GetBegin() + offsets.Get(i);
+        std::copy(chunk, chunk + counts.Get(i), edges.GetBegin() + edge_count);
+        edge_count += counts.Get(i);
+        vertex_end = std::max(vertex_end, vertex_ends.Get(i));
+    }
+
+    EdgeList res;
+    ParseState state;
+    state.origin = begin;
+    state.vertex_limit = options.vertex_count;
+    state.transfers = &res.transfers;
+    auto no_edges = [&](const Edge&) {};
+    ParseLines(state, section, end, no_edges);
+
+    res.vertex_count = options.vertex_count != 0 ? options.vertex_count : std::max(vertex_end, state.vertex_end);
+    res.edges = ToSequence(std::move(edges), edge_count);
+    return res;
+}
+
+EdgeList LoadEdgeList(const std::string& path, const EdgeListOptions& options) {
+#ifdef LAB3_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        std::ifstream in(path, std::ios::binary);
+        return ReadEdgeList(in, options);
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(fd);
+        return ParseEdgeList({}, options);
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::ifstream in(path, std::ios::binary);
+        return ReadEdgeList(in, options);
+    }
+    madvise(mapped, size, MADV_WILLNEED);
+    try {
+        EdgeList res = ParseEdgeList(std::string_view(static_cast<const char*>(mapped), size), options);
+        munmap(mapped, size);
+        return res;
+    } catch (...) {
+        munmap(mapped, size);
+        throw;
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    return ReadEdgeList(in, options);
+#endif
+}
+
+EdgeList ReadEdgeList(std::istream& in, const EdgeListOptions& options) {
+    EdgeList res;
+    ParseState state;
+    state.vertex_limit = options.vertex_count;
+    state.transfers = &res.transfers;
+    auto sink = [&](const Edge& edge) { res.edges.Append(edge); };
+
+    // Complete lines of each block are parsed, the unfinished tail is carried into the next one.
+    std::string buffer;
+    bool eof = false;
+    while (!eof) {
+        const size_t carried = buffer.size();
+        buffer.resize(carried + kReadBlockBytes);
+        in.read(buffer.data() + carried, kReadBlockBytes);
+        buffer.resize(carried + static_cast<size_t>(in.gcount()));
+        eof = !in;
+        const char* begin = buffer.data();
+        const char* stop = begin + buffer.size();
+        if (!eof) {
+            const size_t last = buffer.rfind('\n');
+            if (last == std::string::npos) {
+                continue;
+            }
+            stop = begin + last + 1;
+        }
+        state.origin = begin;
+        ParseLines(state, begin, stop, sink);
+        state.first_line += static_cast<size_t>(std::count(begin, stop, '\n'));
+        buffer.erase(0, static_cast<size_t>(stop - begin));
+    }
+
+    res.vertex_count = options.vertex_count != 0 ? options.vertex_count : state.vertex_end;
+    return res;
+}
+
+IGraphPtr BuildGraph(const EdgeList& list, bool directed, size_t threads) {
+    IGraphPtr graph;
+    if (directed) {
+        graph = DirectedGraph::Build(list.vertex_count, list.edges, threads);
+    } else {
+        graph = Graph::Build(list.vertex_count, list.edges, threads);
+    }
+    for (const VertexTransfer& item : list.transfers) {
+        if (item.vertex >= list.vertex_count) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+        graph->GetVertex(item.vertex)->transfer = item.transfer;
+    }
+    return graph;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <string_view>
+
+#include "array_sequence.hpp"
+#include "igraph.hpp"
+
+// Text edge list format, one record per line:
+//   u v [w]          fields separated by whitespace or commas, w defaults to 1;
+//   # ... or % ...   comment lines, blank lines are skipped;
+//   [transfers]      starts the optional section of per-vertex transfer matrices:
+//   v c00 c01 ... c22  nine costs in row-major Bus/Car/Feet order, "inf" or "-" forbids a change.
+// A first non-comment line starting with a letter is treated as a CSV header and skipped.
+struct EdgeListOptions {
+    // 0 means max vertex id + 1; otherwise ids outside [0, vertex_count) are rejected.
+    size_t vertex_count = 0;
+    // Parsing threads, 0 means hardware concurrency.
+    size_t threads = 0;
+};
+
+struct VertexTransfer {
+    size_t vertex = 0;
+    TransferMatrix transfer;
+};
+
+// Edges keep their order in the file, so edge ids of the built graph match line order.
+struct EdgeList {
+    size_t vertex_count = 0;
+    ArraySequence<Edge> edges;
+    ArraySequence<VertexTransfer> transfers;
+};
+
+// Parses a whole in-memory text. Large inputs are split at line boundaries and parsed in parallel.
+// Malformed lines throw std::invalid_argument carrying the line number.
+EdgeList ParseEdgeList(std::string_view text, const EdgeListOptions& options = {});
+
+// Maps the file into memory where mmap is available and parses it with ParseEdgeList,
+// otherwise falls back to ReadEdgeList.
+EdgeList LoadEdgeList(const std::string& path, const EdgeListOptions& options = {});
+
+// Sequential parser reading the stream in large blocks, for pipes and other unmappable inputs.
+EdgeList ReadEdgeList(std::istream& in, const EdgeListOptions& options = {});
+
+// Bulk-builds a Graph or DirectedGraph and applies the transfer matrices.
+IGraphPtr BuildGraph(const EdgeList& list, bool directed, size_t threads = 0);
@@ -1,10 +1,13 @@
 #include "graph.hpp"
 
 #include <stdexcept>
+#include <string>
 
+#include "adjacency_builder.hpp"
 #include "array_sequence.hpp"
 
-Graph::Graph(size_t n) : vertices_(std::make_shared<ArraySequence<VertexPtr>>(n)) {
+Graph::Graph(size_t n)
+    : vertices_(std::make_shared<ArraySequence<VertexPtr>>(n)), edges_(std::make_shared<ArraySequence<EdgeArcs>>()) {
     for (size_t i = 0; i < n; ++i) {
         vertices_->Set(std::make_shared<Vertex>(i), i);
     }
@@ -16,6 +19,19 @@ Graph::Graph(size_t n, SequencePtr<Edge> edges) : Graph(n) {
     }
 }
 
+std::shared_ptr<Graph> Graph::Build(size_t n, const ArraySequence<Edge>& edges, size_t threads) {
+    for (const Edge& edge : edges) {
+        if (edge.u >= n || edge.v >= n) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+    }
+    auto res = std::make_shared<Graph>(n);
+    res->edges_ = BuildAdjacency(*res->vertices_, edges, false, threads);
+    res->edge_count_ = edges.GetLength();
+    res->version_ = edges.GetLength();
+    return res;
+}
+
 size_t Graph::GetVertexCount() const {
     return vertices_->GetLength();
 }
@@ -24,15 +40,23 @@ size_t Graph::GetEdgeCount() const {
     return edge_count_;
 }
 
-void Graph::AddEdge(const Edge& edge) {
+bool Graph::IsDirected() const {
+    return false;
+}
+
+size_t Graph::AddEdge(const Edge& edge) {
     if (edge.u >= GetVertexCount() || edge.v >= GetVertexCount()) {
         throw std::out_of_range("Vertex index is out of range");
     }
     VertexPtr from = GetVertex(edge.u);
     VertexPtr to = GetVertex(edge.v);
-    from->arcs->Append({from, to, edge.weight});
-    to->arcs->Append({to, from, edge.weight});
+    const size_t edge_id = edges_->GetLength();
+    ListNodePtr<Arc> forward = from->arcs->AppendNode({from, to, edge.weight, edge_id, edge.modes});
+    ListNodePtr<Arc> backward = to->arcs->AppendNode({to, from, edge.weight, edge_id, edge.modes});
+    edges_->Append({forward, backward});
     ++edge_count_;
+    ++version_;
+    return edge_id;
 }
 
 VertexPtr Graph::GetVertex(size_t v) const {
@@ -42,3 +66,66 @@ VertexPtr Graph::GetVertex(size_t v) const {
 Arcs Graph::GetArcs(size_t v) const {
     return GetVertex(v)->arcs;
 }
+
+bool Graph::HasEdge(size_t edge_id) const {
+    return edge_id < edges_->GetLength() && edges_->Get(edge_id).forward != nullptr;
+}
+
+Edge Graph::GetEdge(size_t edge_id) const {
+    const Arc& arc = GetEdgeArcs(edge_id).forward->value;
+    return {arc.from->id, arc.vertex->id, arc.weight, arc.modes};
+}
+
+void Graph::UpdateEdgeWeight(size_t edge_id, int64_t weight) {
+    SetWeight(edge_id, weight);
+    ++version_;
+}
+
+void Graph::RemoveEdge(size_t edge_id) {
+    Remove(edge_id);
+    ++version_;
+}
+
+void Graph::ApplyUpdates(const Sequence<EdgeUpdate>& updates) {
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        GetEdgeArcs(it->GetCurrentItem().edge_id);
+    }
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        const EdgeUpdate& update = it->GetCurrentItem();
+        if (!HasEdge(update.edge_id)) {
+            // Removed earlier in the same batch.
+            continue;
+        }
+        if (update.remove) {
+            Remove(update.edge_id);
+        } else {
+            SetWeight(update.edge_id, update.weight);
+        }
+    }
+    ++version_;
+}
+
+uint64_t Graph::GetVersion() const {
+    return version_;
+}
+
+const EdgeArcs& Graph::GetEdgeArcs(size_t edge_id) const {
+    if (!HasEdge(edge_id)) {
+        throw std::out_of_range("No edge with id " + std::to_string(edge_id));
+    }
+    return edges_->Get(edge_id);
+}
+
+void Graph::SetWeight(size_t edge_id, int64_t weight) {
+    const EdgeArcs& arcs = GetEdgeArcs(edge_id);
+    arcs.forward->value.weight = weight;
+    arcs.backward->value.weight = weight;
+}
+
+void Graph::Remove(size_t edge_id) {
+    const EdgeArcs& arcs = GetEdgeArcs(edge_id);
+    arcs.forward->value.from->arcs->EraseNode(arcs.forward);
+    arcs.backward->value.from->arcs->EraseNode(arcs.backward);
+    edges_->Set({}, edge_id);
+    --edge_count_;
+}
@@ -1,17 +1,32 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
+#include "compact_shortest_paths.hpp"
 #include "directed_graph.hpp"
+#include "edge_list_loader.hpp"
 #include "graph.hpp"
+#include "graph_generators.hpp"
+#include "graph_import.hpp"
+#include "graph_io.hpp"
 #include "list_sequence.hpp"
+#include "numa_graph.hpp"
+#include "perf_counters.hpp"
+#include "query_server.hpp"
 #include "shortest_paths.hpp"
 
 using Clock = std::chrono::steady_clock;
@@ -46,39 +61,6 @@ T AskValue(const std::string& prompt, T default_value) {
     return default_value;
 }
 
-uint64_t EdgeKey(size_t u, size_t v, size_t n, bool directed) {
-    if (!directed && u > v) {
-        std::swap(u, v);
-    }
-    return u * n + v;
-}
-
-SequencePtr<Edge> GenerateRandomEdges(size_t n, size_t m, bool directed, int min_w, int max_w, std::mt19937& rng) {
-    const size_t max_edges = directed ? n * (n - 1) : n * (n - 1) / 2;
-    if (m > max_edges) {
-        throw std::invalid_argument("Too many edges requested for given vertex count");
-    }
-    std::uniform_int_distribution<size_t> vert_dist(0, n - 1);
-    std::uniform_int_distribution<int> weight_dist(min_w, max_w);
-
-    std::unordered_set<uint64_t> used;
-    auto edges = std::make_shared<ListSequence<Edge>>();
-    while (edges->GetLength() < m) {
-        size_t u = vert_dist(rng);
-        size_t v = vert_dist(rng);
-        if (u == v) {
-            continue;
-        }
-        uint64_t key = EdgeKey(u, v, n, directed);
-        if (used.contains(key)) {
-            continue;
-        }
-        used.insert(key);
-        edges->Append({u, v, weight_dist(rng)});
-    }
-    return edges;
-}
-
 SequencePtr<Edge> ReadEdges(size_t n, size_t m) {
     auto edges = std::make_shared<ListSequence<Edge>>();
     std::cout << "Введите " << m << " ребер в формате: u v w (0-индексация)\n";
@@ -138,8 +120,17 @@ void PrintPathWithTransfers(const PathSteps& path) {
     }
 }
 
+struct Measurement {
+    int64_t time_us;
+    PerfSample perf;
+};
+
+// counters may be null; otherwise they cover exactly the timed region.
 template <typename Algo>
-int64_t MeasureUs(Algo&& make_algo, size_t target) {
+Measurement Measure(Algo&& make_algo, size_t target, PerfCounters* counters) {
+    if (counters != nullptr) {
+        counters->Start();
+    }
     auto start = Clock::now();
     auto algo = make_algo();
     auto dist = algo.GetDistance(target);
@@ -147,7 +138,11 @@ int64_t MeasureUs(Algo&& make_algo, size_t target) {
     (void)dist;
     (void)path;
     auto end = Clock::now();
-    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    Measurement res{std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), {}};
+    if (counters != nullptr) {
+        res.perf = counters->Stop();
+    }
+    return res;
 }
 
 template <typename Algo>
@@ -164,6 +159,10 @@ void RunAndReport(const std::string& name, Algo&& make_algo, size_t target) {
     std::cout << "  path: ";
     PrintPath(path);
     PrintPathWithTransfers(details);
+    if constexpr (kSolverStatsEnabled) {
+        std::cout << "  stats:\n";
+        algo.GetStats().Print(std::cout);
+    }
 }
 
 struct BenchResult {
@@ -172,8 +171,13 @@ struct BenchResult {
     bool directed;
     std::string algo;
     int64_t time_us;
+    PerfSample perf;
 };
 
+size_t CeilDiv(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
 size_t ClampEdges(size_t n, size_t edges_per_vertex, bool directed) {
     size_t max_edges = directed ? n * (n - 1) : n * (n - 1) / 2;
     size_t requested = n * edges_per_vertex;
@@ -209,9 +213,54 @@ void WriteCsv(const std::string& path, const std::vector<BenchResult>& rows) {
     if (!out.is_open()) {
         throw std::runtime_error("Не удалось открыть файл для записи: " + path);
     }
-    out << "n,m,directed,algo,time_us\n";
+    out << "n,m,directed,algo,time_us";
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        out << "," << PerfCounters::GetName(static_cast<PerfEvent>(i));
+    }
+    out << ",perf_scaled\n";
     for (const auto& r : rows) {
-        out << r.n << "," << r.m << "," << (r.directed ? 1 : 0) << "," << r.algo << "," << r.time_us << "\n";
+        out << r.n << "," << r.m << "," << (r.directed ? 1 : 0) << "," << r.algo << "," << r.time_us;
+        // Counters that were not collected or not available are left empty.
+        for (int64_t value : r.perf.values) {
+            out << ",";
+            if (value != kPerfUnavailable) {
+                out << value;
+            }
+        }
+        // Counters the PMU multiplexed hold extrapolated values; they are listed as name;name.
+        out << ",";
+        bool first = true;
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            if (r.perf.scaled[i]) {
+                out << (first ? "" : ";") << PerfCounters::GetName(static_cast<PerfEvent>(i));
+                first = false;
+            }
+        }
+        out << "\n";
+    }
+}
+
+// Vertex counts of the structured families are rounded to their natural shapes (squares, powers of two).
+EdgeList GenerateFamily(char family, size_t n, size_t edges_per_vertex, bool directed, const GeneratorOptions& options) {
+    const size_t side = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(n))));
+    switch (family) {
+        case 'g':
+            return GenerateGrid(side, CeilDiv(n, side), 0.05, options);
+        case 'r': {
+            const size_t scale = std::max<size_t>(1, std::bit_width(n - 1));
+            return GenerateRmat(scale, n * edges_per_vertex, {}, options);
+        }
+        case 'b':
+            return GenerateBarabasiAlbert(n, std::max<size_t>(1, edges_per_vertex), options);
+        case 'l': {
+            MultimodalParams params;
+            params.rows = side;
+            params.cols = CeilDiv(n, side);
+            params.bus_lines = std::max<size_t>(1, side / 4);
+            return GenerateMultimodal(params, options);
+        }
+        default:
+            return GenerateUniform(n, ClampEdges(n, edges_per_vertex, directed), directed, options);
     }
 }
 
@@ -228,36 +277,62 @@ void RunBenchmark() {
         csv_path = "bench.csv";
     }
 
+    std::unique_ptr<PerfCounters> counters;
+    if (AskChar("Собирать аппаратные счетчики perf? (y/N, Enter=N): ", 'n') == 'y') {
+        counters = std::make_unique<PerfCounters>();
+        if (!counters->IsAvailable()) {
+            std::cout << "Счетчики perf недоступны (см. /proc/sys/kernel/perf_event_paranoid)\n";
+            counters.reset();
+        }
+    }
+
+    const char family = AskChar(
+        "Семейство графов: (u)niform, (g)rid, (r)-mat, (b)arabasi-albert, (l)ayered multimodal (Enter=u): ", 'u');
     std::random_device rd;
-    std::mt19937 rng(rd());
+    GeneratorOptions options;
+    options.seed = AskValue<uint64_t>("Seed (Enter=случайный): ", rd());
+    TransferProfile profile;
+    if (AskChar("Случайные матрицы пересадок? (y/N, Enter=N): ", 'n') == 'y') {
+        profile.change_probability = 0.5;
+        profile.max_cost = 5;
+    }
     std::vector<BenchResult> results;
 
-    for (size_t n : sizes) {
-        if (n == 0) {
+    for (size_t requested_n : sizes) {
+        if (requested_n == 0) {
             continue;
         }
-        size_t m = ClampEdges(n, edges_per_vertex, directed);
-        auto edges = GenerateRandomEdges(n, m, directed, 1, 10, rng);
         IGraphPtr graph;
-        if (directed) {
-            graph = std::make_shared<DirectedGraph>(n, edges);
-        } else {
-            graph = std::make_shared<Graph>(n, edges);
+        try {
+            graph = BuildGenerated(GenerateFamily(family, requested_n, edges_per_vertex, directed, options), directed,
+                                   profile, options);
+        } catch (const std::exception& e) {
+            std::cout << "Генерация пропущена для n=" << requested_n << ": " << e.what() << "\n";
+            continue;
         }
+        const size_t n = graph->GetVertexCount();
+        const size_t m = graph->GetEdgeCount();
         size_t from = 0;
         size_t to = (n > 1) ? n - 1 : 0;
         try {
-            int64_t t = MeasureUs([&] { return Dijkstra(graph, from); }, to);
-            results.push_back({n, m, directed, "Dijkstra", t});
+            Measurement t = Measure([&] { return Dijkstra(graph, from); }, to, counters.get());
+            results.push_back({n, m, directed, "Dijkstra", t.time_us, t.perf});
         } catch (const std::exception& e) {
             std::cout << "Dijkstra пропущен для n=" << n << ": " << e.what() << "\n";
         }
         try {
-            int64_t t = MeasureUs([&] { return FordBellman(graph, from); }, to);
-            results.push_back({n, m, directed, "Bellman-Ford", t});
+            Measurement t = Measure([&] { return FordBellman(graph, from); }, to, counters.get());
+            results.push_back({n, m, directed, "Bellman-Ford", t.time_us, t.perf});
         } catch (const std::exception& e) {
             std::cout << "Bellman-Ford пропущен для n=" << n << ": " << e.what() << "\n";
         }
+        try {
+            auto compact = std::make_shared<CompactGraph64>(CompactGraph64::FromGraph(*graph));
+            Measurement t = Measure([&] { return CompactDijkstra64(compact, from); }, to, counters.get());
+            results.push_back({n, m, directed, "Dijkstra-compact", t.time_us, t.perf});
+        } catch (const std::exception& e) {
+            std::cout << "Dijkstra-compact пропущен для n=" << n << ": " << e.what() << "\n";
+        }
     }
 
     try {
@@ -268,7 +343,307 @@ void RunBenchmark() {
     }
 }
 
-int main() {
+// graph_cli convert <dimacs|osm|edges> <input> <output> [--coordinates <file.co>] [--undirected] [--scale <k>]
+int RunConvert(int argc, char** argv) {
+    if (argc < 5) {
+        std::cerr << "Использование: " << argv[0]
+                  << " convert <dimacs|osm|edges> <input> <output> [--coordinates <file.co>] [--undirected]"
+                     " [--scale <k>]\n";
+        return 2;
+    }
+    const std::string format = argv[2];
+    const std::string input = argv[3];
+    const std::string output = argv[4];
+    std::string coordinates;
+    bool directed = true;
+    ImportOptions options;
+    for (int i = 5; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--coordinates" && i + 1 < argc) {
+            coordinates = argv[++i];
+        } else if (arg == "--undirected") {
+            directed = false;
+        } else if (arg == "--scale" && i + 1 < argc) {
+            options.weight_scale = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        const auto start = Clock::now();
+        GraphData data;
+        if (format == "dimacs") {
+            data = ImportDimacs(input, coordinates, options);
+        } else if (format == "osm") {
+            data = ImportOsmEdges(input, options);
+        } else if (format == "edges") {
+            data.graph = BuildGraph(LoadEdgeList(input), directed);
+        } else {
+            std::cerr << "Неизвестный формат: " << format << "\n";
+            return 2;
+        }
+        const auto parsed = Clock::now();
+        SaveGraphBinary(data, output);
+        const auto saved = Clock::now();
+        std::cout << "n=" << data.graph->GetVertexCount() << ", m=" << data.graph->GetEdgeCount() << ", импорт "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(parsed - start).count() << " мс, запись "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(saved - parsed).count() << " мс\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка конвертации: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Parses the value of a numeric flag; prints an error for anything but a whole non-negative number.
+bool ParseFlagValue(const std::string& flag, const char* text, size_t& value) {
+    const char* end = text + std::strlen(text);
+    const auto [ptr, ec] = std::from_chars(text, end, value);
+    if (ptr == text || ec != std::errc() || ptr != end) {
+        std::cerr << "Некорректное значение " << flag << ": " << text << "\n";
+        return false;
+    }
+    return true;
+}
+
+// graph_cli serve <graph file> [--socket <path>] [--threads <k>] [--batch <b>] [--cache-mb <mb>]
+//                               [--timeout-ms <t>] [--undirected]
+// Without --socket requests are read from stdin and answered on stdout.
+int RunServe(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0]
+                  << " serve <graph file> [--socket <path>] [--threads <k>] [--batch <b>] [--cache-mb <mb>]"
+                     " [--timeout-ms <t>] [--undirected]\n";
+        return 2;
+    }
+    const std::string path = argv[2];
+    std::string socket_path;
+    bool directed = true;
+    ServerOptions options;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!ParseFlagValue(arg, argv[++i], options.threads)) {
+                return 2;
+            }
+        } else if (arg == "--batch" && i + 1 < argc) {
+            if (!ParseFlagValue(arg, argv[++i], options.max_batch)) {
+                return 2;
+            }
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            size_t megabytes = 0;
+            if (!ParseFlagValue(arg, argv[++i], megabytes)) {
+                return 2;
+            }
+            options.cache_bytes = megabytes << 20;
+        } else if (arg == "--timeout-ms" && i + 1 < argc) {
+            size_t milliseconds = 0;
+            if (!ParseFlagValue(arg, argv[++i], milliseconds)) {
+                return 2;
+            }
+            options.query_timeout = std::chrono::milliseconds(milliseconds);
+        } else if (arg == "--undirected") {
+            directed = false;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        const IGraphPtr graph = IsGraphBinary(path) ? LoadGraphBinary(path).graph : BuildGraph(LoadEdgeList(path), directed);
+        QueryServer server(graph, options);
+        if (socket_path.empty()) {
+            std::ios::sync_with_stdio(false);
+            server.Serve(std::cin, std::cout);
+        } else {
+            std::cerr << "n=" << graph->GetVertexCount() << ", m=" << graph->GetEdgeCount() << ", сокет "
+                      << socket_path << "\n";
+            server.ServeUnixSocket(socket_path);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка сервера: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// graph_cli load <socket> [--requests <n>] [--connections <c>] [--pipeline <p>] [--matrix <percent>]
+//                         [--matrix-size <k>] [--seed <s>]
+int RunLoadClient(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0]
+                  << " load <socket> [--requests <n>] [--connections <c>] [--pipeline <p>] [--matrix <percent>]"
+                     " [--matrix-size <k>] [--seed <s>]\n";
+        return 2;
+    }
+    const std::string socket_path = argv[2];
+    LoadOptions options;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 2;
+        }
+        size_t value = 0;
+        if (!ParseFlagValue(arg, argv[++i], value)) {
+            return 2;
+        }
+        if (arg == "--requests") {
+            options.requests = value;
+        } else if (arg == "--connections") {
+            options.connections = value;
+        } else if (arg == "--pipeline") {
+            options.pipeline = value;
+        } else if (arg == "--matrix") {
+            options.matrix_percent = value;
+        } else if (arg == "--matrix-size") {
+            options.matrix_size = value;
+        } else if (arg == "--seed") {
+            options.seed = value;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        const LoadReport report = RunLoad(socket_path, options);
+        std::cout << "запросов " << report.requests << " (ошибок " << report.errors << ") за " << report.seconds
+                  << " с, " << report.throughput << " запр/с\n"
+                  << "задержка, мкс: p50=" << report.p50 << " p90=" << report.p90 << " p99=" << report.p99
+                  << " max=" << report.max << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка нагрузки: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// graph_cli scaling <graph file> [--sources <n>] [--placement shared|interleave|replicate] [--no-pin]
+//                                 [--undirected]
+// Many-source CompactDijkstra throughput for 1, 2, 4, ... workers up to one per CPU. Workers fill
+// one NUMA node before spilling to the next, so rows with nodes > 1 show scaling beyond a socket.
+// With --no-pin the node column shows "-", since the scheduler decides where workers run.
+int RunScaling(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0]
+                  << " scaling <graph file> [--sources <n>] [--placement shared|interleave|replicate] [--no-pin]"
+                     " [--undirected]\n";
+        return 2;
+    }
+    const std::string path = argv[2];
+    size_t source_count = 256;
+    NumaPlacement placement = NumaPlacement::Replicate;
+    bool pin = true;
+    bool directed = true;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--sources" && i + 1 < argc) {
+            if (!ParseFlagValue(arg, argv[++i], source_count)) {
+                return 2;
+            }
+        } else if (arg == "--placement" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (value == "shared") {
+                placement = NumaPlacement::Shared;
+            } else if (value == "interleave") {
+                placement = NumaPlacement::Interleave;
+            } else if (value == "replicate") {
+                placement = NumaPlacement::Replicate;
+            } else {
+                std::cerr << "Неизвестное размещение: " << value << "\n";
+                return 2;
+            }
+        } else if (arg == "--no-pin") {
+            pin = false;
+        } else if (arg == "--undirected") {
+            directed = false;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        const IGraphPtr graph =
+            IsGraphBinary(path) ? LoadGraphBinary(path).graph : BuildGraph(LoadEdgeList(path), directed);
+        if (graph->GetVertexCount() == 0 || source_count == 0) {
+            throw std::invalid_argument("нужны хотя бы одна вершина и один источник");
+        }
+        const NumaGraphReplicas<uint32_t, int64_t> graphs(
+            std::make_shared<const CompactGraph64>(CompactGraph64::FromGraph(*graph)), placement);
+        const NumaTopology& topology = graphs.GetTopology();
+        std::cout << "n=" << graph->GetVertexCount() << ", m=" << graph->GetEdgeCount() << ", узлов NUMA "
+                  << topology.GetNodeCount() << ", CPU " << topology.GetCpuCount() << ", копий графа "
+                  << graphs.GetReplicaCount() << (graphs.IsPolicyApplied() ? "" : " (политика памяти не применена)")
+                  << "\n";
+
+        std::mt19937_64 rng(1);
+        std::uniform_int_distribution<size_t> vertex(0, graph->GetVertexCount() - 1);
+        ArraySequence<size_t> sources;
+        for (size_t i = 0; i < source_count; ++i) {
+            sources.Append(vertex(rng));
+        }
+        const size_t target = vertex(rng);
+
+        std::vector<size_t> thread_counts;
+        for (size_t t = 1; t < topology.GetCpuCount(); t *= 2) {
+            thread_counts.push_back(t);
+        }
+        thread_counts.push_back(topology.GetCpuCount());
+
+        std::cout << "потоки узлы   источн/с  ускорение  эффективность\n";
+        double base = 0;
+        for (size_t threads : thread_counts) {
+            std::atomic<int64_t> checksum = 0;
+            const auto start = Clock::now();
+            ForEachSource(graphs, sources, {.threads = threads, .pin_threads = pin},
+                          [&](size_t, const CompactDijkstra64& finder) { checksum += finder.GetDistance(target); });
+            const std::chrono::duration<double> elapsed = Clock::now() - start;
+            const double rate = static_cast<double>(source_count) / elapsed.count();
+            if (base == 0) {
+                base = rate;
+            }
+            // Unpinned workers go wherever the scheduler puts them, so their node spread is unknown.
+            std::string nodes = "-";
+            if (pin) {
+                std::vector<bool> used(topology.GetNodeCount());
+                for (size_t w = 0; w < threads; ++w) {
+                    used[topology.GetWorkerNode(w)] = true;
+                }
+                nodes = std::to_string(std::count(used.begin(), used.end(), true));
+            }
+            const double speedup = rate / base;
+            std::cout << std::setw(6) << threads << std::setw(5) << nodes << std::setw(11) << std::fixed << std::setprecision(1) << rate << std::setw(11)
+                      << std::setprecision(2) << speedup << std::setw(14) << speedup / static_cast<double>(threads)
+                      << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "convert") {
+        return RunConvert(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "serve") {
+        return RunServe(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "load") {
+        return RunLoadClient(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "scaling") {
+        return RunScaling(argc, argv);
+    }
+
     std::cout << "=== Graph shortest paths ===\n";
     char mode = AskChar("Выберите режим: (i)nteractive / (b)enchmark (Enter=i): ", 'i');
 
@@ -279,24 +654,54 @@ int main() {
 
     bool directed = AskChar("Ориентированный граф? (y/n, Enter=n): ", 'n') == 'y';
 
-    mode = AskChar("Режим: (g)enerate случайный или (m)anual ввод (Enter=g): ", 'g');
+    mode = AskChar("Режим: (g)enerate случайный, (m)anual ввод или (f)ile (список ребер или бинарный граф) (Enter=g): ",
+                   'g');
 
-    size_t n = AskValue<size_t>("Число вершин (Enter=5): ", 5);
-    size_t m = AskValue<size_t>("Число ребер (Enter=5): ", 5);
+    IGraphPtr graph;
+    size_t n = 0;
+    if (mode == 'f' || mode == 'F') {
+        std::cout << "Путь к файлу: ";
+        const std::string path = ReadLine();
+        try {
+            const auto start = Clock::now();
+            if (IsGraphBinary(path)) {
+                // Binary files store their own orientation.
+                graph = LoadGraphBinary(path).graph;
+            } else {
+                graph = BuildGraph(LoadEdgeList(path), directed);
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+            n = graph->GetVertexCount();
+            std::cout << "Загружено: n=" << n << ", m=" << graph->GetEdgeCount() << " за " << elapsed.count()
+                      << " мс\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка загрузки: " << e.what() << "\n";
+            return 1;
+        }
+    }
 
     SequencePtr<Edge> edges;
-    if (mode == 'g' || mode == 'G') {
+    if (graph != nullptr) {
+        // Loaded from file.
+    } else if (mode == 'g' || mode == 'G') {
+        n = AskValue<size_t>("Число вершин (Enter=5): ", 5);
+        size_t m = AskValue<size_t>("Число ребер (Enter=5): ", 5);
         int min_w = AskValue<int>("Минимальный вес (Enter=1): ", 1);
         int max_w = AskValue<int>("Максимальный вес (Enter=10): ", 10);
         std::random_device rd;
-        std::mt19937 rng(rd());
+        GeneratorOptions options;
+        options.seed = rd();
+        options.min_weight = min_w;
+        options.max_weight = max_w;
         try {
-            edges = GenerateRandomEdges(n, m, directed, min_w, max_w, rng);
+            edges = std::make_shared<ArraySequence<Edge>>(GenerateUniform(n, m, directed, options).edges);
         } catch (const std::exception& e) {
             std::cerr << "Ошибка генерации: " << e.what() << "\n";
             return 1;
         }
     } else {
+        n = AskValue<size_t>("Число вершин (Enter=5): ", 5);
+        size_t m = AskValue<size_t>("Число ребер (Enter=5): ", 5);
         try {
             edges = ReadEdges(n, m);
         } catch (const std::exception& e) {
@@ -305,8 +710,9 @@ int main() {
         }
     }
 
-    IGraphPtr graph;
-    if (directed) {
+    if (graph != nullptr) {
+        // Loaded from file.
+    } else if (directed) {
         graph = std::make_shared<DirectedGraph>(n, edges);
     } else {
         graph = std::make_shared<Graph>(n, edges);
@@ -0,0 +1,391 @@
+#include "graph_generators.hpp"
+
+#include <algorithm>
+#include <compare>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "directed_graph.hpp"
+#include "graph.hpp"
+#include "graph_import.hpp"
+#include "parallel.hpp"
+
+constexpr size_t kBlockSize = 1 << 16;
+
+// Independent random streams of one seed.
+enum class Stream : uint64_t {
+    Pairs = 1,
+    Weights,
+    Grid,
+    Rmat,
+    Attachment,
+    BusLines,
+    Transfers,
+};
+
+static uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// SplitMix64 stream; bounded draws use plain modulo, whose bias is negligible for 64-bit values
+// and, unlike std distributions, gives the same numbers with every standard library.
+class BlockRandom {
+public:
+    BlockRandom(uint64_t seed, Stream stream, uint64_t block)
+        : state_(Mix(seed ^ Mix(static_cast<uint64_t>(stream) ^ Mix(block)))) {
+    }
+
+    uint64_t Next() {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return Mix(state_);
+    }
+
+    uint64_t Below(uint64_t bound) {
+        return Next() % bound;
+    }
+
+    int64_t Between(int64_t min, int64_t max) {
+        return min + static_cast<int64_t>(Below(static_cast<uint64_t>(max - min) + 1));
+    }
+
+    double Unit() {
+        return static_cast<double>(Next() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t state_;
+};
+
+static void CheckOptions(const GeneratorOptions& options) {
+    if (options.min_weight > options.max_weight) {
+        throw std::invalid_argument("min_weight must not exceed max_weight");
+    }
+}
+
+static size_t CeilDiv(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+// Runs fill(block, random, out) for every block in parallel and concatenates the outputs in block order.
+template <typename T, typename Fill>
+static ArraySequence<T> GenerateBlocks(size_t block_count, Stream stream, const GeneratorOptions& options,
+                                          Fill&& fill) {
+    ArraySequence<ArraySequence<T>> parts(block_count);
+    ParallelFor(block_count, options.threads, [&](size_t block, size_t) {
+        BlockRandom random(options.seed, stream, block);
+        fill(block, random, parts.begin()[block]);
+    });
+    size_t total = 0;
+    for (const ArraySequence<T>& part : parts) {
+        total += part.GetLength();
+    }
+    if (total == 0) {
+        return {};
+    }
+    ArraySequence<T> res(total);
+    T* out = res.begin();
+    for (ArraySequence<T>& part : parts) {
+        out = std::copy(part.begin(), part.end(), out);
+        part = ArraySequence<T>();
+    }
+    return res;
+}
+
+static void AssignWeights(ArraySequence<Edge>& edges, const GeneratorOptions& options) {
+    ParallelFor(CeilDiv(edges.GetLength(), kBlockSize), options.threads, [&](size_t block, size_t) {
+        BlockRandom random(options.seed, Stream::Weights, block);
+        const size_t end = std::min(edges.GetLength(), (block + 1) * kBlockSize);
+        for (size_t i = block * kBlockSize; i < end; ++i) {
+            edges.begin()[i].weight = random.Between(options.min_weight, options.max_weight);
+        }
+    });
+}
+
+// Sorting 16-byte pairs instead of whole edges keeps duplicate removal cheap.
+struct VertexPair {
+    size_t u;
+    size_t v;
+
+    auto operator<=>(const VertexPair&) const = default;
+};
+
+static uint64_t CountPairs(size_t n, bool directed) {
+    if (n < 2) {
+        return 0;
+    }
+    uint64_t a = n;
+    uint64_t b = n - 1;
+    if (!directed) {
+        (a % 2 == 0 ? a : b) /= 2;
+    }
+    if (a > std::numeric_limits<uint64_t>::max() / b) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return a * b;
+}
+
+// Sorted distinct pairs drawn uniformly; each round draws exactly the missing count, so there is
+// no overshoot to trim and no bias toward small ids.
+static ArraySequence<VertexPair> SamplePairs(size_t n, size_t count, bool directed, const GeneratorOptions& options) {
+    ArraySequence<VertexPair> pairs;
+    for (uint64_t round = 0; pairs.GetLength() < count; ++round) {
+        const size_t need = count - pairs.GetLength();
+        GeneratorOptions round_options = options;
+        round_options.seed = Mix(options.seed ^ round);
+        const ArraySequence<VertexPair> drawn = GenerateBlocks<VertexPair>(
+            CeilDiv(need, kBlockSize), Stream::Pairs, round_options,
+            [&](size_t block, BlockRandom& random, ArraySequence<VertexPair>& out) {
+                const size_t end = std::min(need, (block + 1) * kBlockSize);
+                for (size_t i = block * kBlockSize; i < end; ++i) {
+                    size_t u = random.Below(n);
+                    size_t v = random.Below(n - 1);
+                    v += v >= u ? 1 : 0;
+                    if (!directed && u > v) {
+                        std::swap(u, v);
+                    }
+                    out.Append({u, v});
+                }
+            });
+        for (const VertexPair& pair : drawn) {
+            pairs.Append(pair);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        const size_t unique = static_cast<size_t>(std::unique(pairs.begin(), pairs.end()) - pairs.begin());
+        while (pairs.GetLength() > unique) {
+            pairs.EraseAt(pairs.GetLength() - 1);
+        }
+    }
+    return pairs;
+}
+
+EdgeList GenerateUniform(size_t n, size_t m, bool directed, const GeneratorOptions& options) {
+    CheckOptions(options);
+    const uint64_t pairs = CountPairs(n, directed);
+    if (m > pairs) {
+        throw std::invalid_argument("Too many edges requested for given vertex count");
+    }
+    EdgeList res;
+    res.vertex_count = n;
+    if (m == 0) {
+        return res;
+    }
+    // Dense graphs draw the pairs to leave out, at most half of all pairs.
+    const bool complement = m > pairs - m;
+    const ArraySequence<VertexPair> drawn = SamplePairs(n, complement ? pairs - m : m, directed, options);
+    ArraySequence<Edge> edges(m);
+    if (!complement) {
+        for (size_t i = 0; i < m; ++i) {
+            edges.begin()[i] = Edge(drawn.Get(i).u, drawn.Get(i).v);
+        }
+    } else {
+        size_t next = 0;
+        size_t skip = 0;
+        for (size_t u = 0; u < n; ++u) {
+            for (size_t v = directed ? 0 : u + 1; v < n; ++v) {
+                if (u == v) {
+                    continue;
+                }
+                if (skip < drawn.GetLength() && drawn.Get(skip) == VertexPair{u, v}) {
+                    ++skip;
+                    continue;
+                }
+                edges.begin()[next++] = Edge(u, v);
+            }
+        }
+    }
+    res.edges = std::move(edges);
+    AssignWeights(res.edges, options);
+    return res;
+}
+
+EdgeList GenerateGrid(size_t rows, size_t cols, double drop_probability, const GeneratorOptions& options) {
+    CheckOptions(options);
+    if (cols != 0 && rows > std::numeric_limits<size_t>::max() / cols) {
+        throw std::invalid_argument("Grid is too large");
+    }
+    EdgeList res;
+    res.vertex_count = rows * cols;
+    res.edges = GenerateBlocks<Edge>(CeilDiv(res.vertex_count, kBlockSize), Stream::Grid, options,
+                               [&](size_t block, BlockRandom& random, ArraySequence<Edge>& out) {
+                                   const size_t end = std::min(res.vertex_count, (block + 1) * kBlockSize);
+                                   for (size_t v = block * kBlockSize; v < end; ++v) {
+                                       const size_t row = v / cols;
+                                       const size_t col = v % cols;
+                                       if (col + 1 < cols && random.Unit() >= drop_probability) {
+                                           out.Append(Edge(v, v + 1, random.Between(options.min_weight,
+                                                                                     options.max_weight)));
+                                       }
+                                       if (row + 1 < rows && random.Unit() >= drop_probability) {
+                                           out.Append(Edge(v, v + cols, random.Between(options.min_weight,
+                                                                                        options.max_weight)));
+                                       }
+                                   }
+                               });
+    return res;
+}
+
+ArraySequence<Coordinate> GridCoordinates(size_t rows, size_t cols) {
+    ArraySequence<Coordinate> res(rows * cols);
+    for (size_t v = 0; v < rows * cols; ++v) {
+        res.begin()[v] = {static_cast<double>(v % cols), static_cast<double>(v / cols)};
+    }
+    return res;
+}
+
+EdgeList GenerateRmat(size_t scale, size_t m, const RmatParams& params, const GeneratorOptions& options) {
+    CheckOptions(options);
+    if (scale == 0 || scale >= 63) {
+        throw std::invalid_argument("R-MAT scale must be in [1, 62]");
+    }
+    if (params.a < 0 || params.b < 0 || params.c < 0 || params.a + params.b + params.c > 1) {
+        throw std::invalid_argument("R-MAT probabilities must be non-negative and sum to at most 1");
+    }
+    if (params.b + params.c <= 0) {
+        // Every level would set both bits or neither, so only self-loops could be drawn.
+        throw std::invalid_argument("R-MAT needs b + c > 0 to draw anything but self-loops");
+    }
+    EdgeList res;
+    res.vertex_count = size_t{1} << scale;
+    res.edges = GenerateBlocks<Edge>(CeilDiv(m, kBlockSize), Stream::Rmat, options,
+                               [&](size_t block, BlockRandom& random, ArraySequence<Edge>& out) {
+                                   const size_t end = std::min(m, (block + 1) * kBlockSize);
+                                   for (size_t i = block * kBlockSize; i < end; ++i) {
+                                       size_t u = 0;
+                                       size_t v = 0;
+                                       while (u == v) {
+                                           u = 0;
+                                           v = 0;
+                                           for (size_t bit = size_t{1} << (scale - 1); bit != 0; bit >>= 1) {
+                                               const double r = random.Unit();
+                                               if (r >= params.a + params.b + params.c) {
+                                                   u |= bit;
+                                                   v |= bit;
+                                               } else if (r >= params.a + params.b) {
+                                                   u |= bit;
+                                               } else if (r >= params.a) {
+                                                   v |= bit;
+                                               }
+                                           }
+                                       }
+                                       out.Append(Edge(u, v, random.Between(options.min_weight, options.max_weight)));
+                                   }
+                               });
+    return res;
+}
+
+EdgeList GenerateBarabasiAlbert(size_t n, size_t degree, const GeneratorOptions& options) {
+    CheckOptions(options);
+    if (degree == 0) {
+        throw std::invalid_argument("Barabasi-Albert degree must be positive");
+    }
+    // Endpoint list M: edge e owns slots 2e (its new vertex e / degree) and 2e + 1, a copy of a
+    // uniformly chosen earlier slot. Copies of copies are followed until they reach an even slot.
+    const uint64_t seed = Mix(options.seed ^ static_cast<uint64_t>(Stream::Attachment));
+    auto target = [&](size_t edge) {
+        size_t slot = Mix(seed ^ edge) % (2 * edge + 1);
+        while (slot % 2 == 1) {
+            const size_t copied = slot / 2;
+            slot = Mix(seed ^ copied) % (2 * copied + 1);
+        }
+        return slot / 2 / degree;
+    };
+    EdgeList res;
+    res.vertex_count = n;
+    const size_t m = n * degree;
+    res.edges = GenerateBlocks<Edge>(CeilDiv(m, kBlockSize), Stream::Attachment, options,
+                               [&](size_t block, BlockRandom& random, ArraySequence<Edge>& out) {
+                                   const size_t end = std::min(m, (block + 1) * kBlockSize);
+                                   for (size_t edge = block * kBlockSize; edge < end; ++edge) {
+                                       const size_t u = edge / degree;
+                                       const size_t v = target(edge);
+                                       const int64_t w = random.Between(options.min_weight, options.max_weight);
+                                       if (u != v) {
+                                           out.Append(Edge(u, v, w));
+                                       }
+                                   }
+                               });
+    return res;
+}
+
+EdgeList GenerateMultimodal(const MultimodalParams& params, const GeneratorOptions& options) {
+    if (params.rows == 0 || params.cols == 0 || params.stop_spacing == 0 || params.max_wait < 1 ||
+        params.walk_factor < 1) {
+        throw std::invalid_argument("Invalid multimodal generator parameters");
+    }
+    EdgeList res = GenerateGrid(params.rows, params.cols, 0, options);
+    const TransportMask streets = TransportBit(Transport::Car) | TransportBit(Transport::Feet);
+    ParallelFor(CeilDiv(res.edges.GetLength(), kBlockSize), options.threads, [&](size_t block, size_t) {
+        const size_t end = std::min(res.edges.GetLength(), (block + 1) * kBlockSize);
+        for (size_t i = block * kBlockSize; i < end; ++i) {
+            Edge& edge = res.edges.begin()[i];
+            edge.modes = ArcModes::Only(streets);
+            const int64_t walk_extra = edge.weight * (params.walk_factor - 1);
+            edge.modes.extra[ToTransportIndex(Transport::Feet)] = static_cast<int32_t>(
+                std::clamp<int64_t>(walk_extra, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
+        }
+    });
+
+    const TransferMatrix street_transfer = RoadTransferMatrix();
+    for (size_t line = 0; line < params.bus_lines; ++line) {
+        BlockRandom random(options.seed, Stream::BusLines, line);
+        const bool horizontal = random.Below(2) == 0;
+        const size_t length = horizontal ? params.cols : params.rows;
+        const size_t across = random.Below(horizontal ? params.rows : params.cols);
+        auto vertex = [&](size_t along) {
+            return horizontal ? across * params.cols + along : along * params.cols + across;
+        };
+        size_t previous = static_cast<size_t>(-1);
+        for (size_t along = random.Below(std::min(params.stop_spacing, length)); along < length;
+             along += params.stop_spacing) {
+            const size_t stop = vertex(along);
+            VertexTransfer transfer{stop, street_transfer};
+            transfer.transfer.SetCost(Transport::Feet, Transport::Bus, random.Between(1, params.max_wait));
+            transfer.transfer.SetCost(Transport::Car, Transport::Bus, kNoTransferCost);
+            transfer.transfer.SetCost(Transport::Bus, Transport::Car, kNoTransferCost);
+            res.transfers.Append(transfer);
+            if (previous != static_cast<size_t>(-1)) {
+                res.edges.Append(Edge(previous, stop, params.bus_cost * static_cast<int64_t>(params.stop_spacing),
+                                      ArcModes::Only(TransportBit(Transport::Bus))));
+            }
+            previous = stop;
+        }
+    }
+    return res;
+}
+
+IGraphPtr BuildGenerated(const EdgeList& list, bool directed, const TransferProfile& profile,
+                         const GeneratorOptions& options) {
+    if (profile.min_cost > profile.max_cost) {
+        throw std::invalid_argument("min_cost must not exceed max_cost");
+    }
+    IGraphPtr graph;
+    if (directed) {
+        graph = DirectedGraph::Build(list.vertex_count, list.edges, options.threads);
+    } else {
+        graph = Graph::Build(list.vertex_count, list.edges, options.threads);
+    }
+    ParallelFor(CeilDiv(list.vertex_count, kBlockSize), options.threads, [&](size_t block, size_t) {
+        BlockRandom random(options.seed, Stream::Transfers, block);
+        const size_t end = std::min(list.vertex_count, (block + 1) * kBlockSize);
+        for (size_t v = block * kBlockSize; v < end; ++v) {
+            TransferMatrix transfer = profile.base;
+            for (Transport from : kAllTransports) {
+                for (Transport to : kAllTransports) {
+                    if (from != to && transfer.GetCost(from, to) == kNoTransferCost &&
+                        profile.change_probability > 0 && random.Unit() < profile.change_probability) {
+                        transfer.SetCost(from, to, random.Between(profile.min_cost, profile.max_cost));
+                    }
+                }
+            }
+            graph->GetVertex(v)->transfer = transfer;
+        }
+    });
+    for (const VertexTransfer& item : list.transfers) {
+        graph->GetVertex(item.vertex)->transfer = item.transfer;
+    }
+    return graph;
+}
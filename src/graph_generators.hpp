@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+#include "array_sequence.hpp"
+#include "edge_list_loader.hpp"
+
+// Work is cut into fixed blocks, each with its own random stream derived from the seed, so the
+// output depends only on the parameters and the seed, never on the thread count.
+struct GeneratorOptions {
+    uint64_t seed = 0;
+    int64_t min_weight = 1;
+    int64_t max_weight = 10;
+    // 0 means hardware concurrency.
+    size_t threads = 0;
+};
+
+// Uniform G(n, m): m distinct pairs without self-loops, unordered pairs when !directed.
+// Dense requests sample the complement instead of rejecting duplicates.
+EdgeList GenerateUniform(size_t n, size_t m, bool directed, const GeneratorOptions& options = {});
+
+// Road-like rows x cols grid: every vertex links to its right and lower neighbour, each street is
+// dropped with drop_probability. Vertex r * cols + c lies at (c, r), see GridCoordinates.
+EdgeList GenerateGrid(size_t rows, size_t cols, double drop_probability = 0, const GeneratorOptions& options = {});
+
+ArraySequence<Coordinate> GridCoordinates(size_t rows, size_t cols);
+
+// Recursive-matrix (R-MAT / Kronecker) graph over 2^scale vertices: every edge descends `scale`
+// levels choosing a quadrant with probabilities a, b, c and 1 - a - b - c. Self-loops are redrawn,
+// duplicate edges are kept. b + c must be positive, otherwise every draw would be a self-loop.
+struct RmatParams {
+    double a = 0.57;
+    double b = 0.19;
+    double c = 0.19;
+};
+
+EdgeList GenerateRmat(size_t scale, size_t m, const RmatParams& params = {}, const GeneratorOptions& options = {});
+
+// Barabási–Albert preferential attachment, every new vertex attaching `degree` edges. Uses the
+// Batagelj–Brandes endpoint list where each edge is resolved independently by hashing (Sanders and
+// Schulz), so edges are generated in parallel. Self-loops are dropped.
+EdgeList GenerateBarabasiAlbert(size_t n, size_t degree, const GeneratorOptions& options = {});
+
+// Grid streets usable by car and on foot (walking pays walk_factor times the weight) with straight
+// bus lines on top. Bus arcs are bus-only and cost bus_cost per grid step; walking to and from a
+// bus at a stop costs a random wait in [1, max_wait]. Stops get explicit transfers in the list.
+// Every street and bus hop is listed once, so the result is meant to be built undirected.
+struct MultimodalParams {
+    size_t rows = 32;
+    size_t cols = 32;
+    size_t bus_lines = 8;
+    size_t stop_spacing = 4;
+    int64_t bus_cost = 1;
+    int32_t walk_factor = 4;
+    int64_t max_wait = 10;
+};
+
+EdgeList GenerateMultimodal(const MultimodalParams& params, const GeneratorOptions& options = {});
+
+// Per-vertex transfer matrices: every vertex starts from `base`, then each change the base forbids
+// is allowed with change_probability at a random cost in [min_cost, max_cost].
+struct TransferProfile {
+    TransferMatrix base = TransferMatrix::Diagonal(0);
+    double change_probability = 0;
+    int64_t min_cost = 0;
+    int64_t max_cost = 0;
+};
+
+// Bulk-builds the list, assigns every vertex a matrix drawn from the profile and then applies the
+// list's own transfers on top.
+IGraphPtr BuildGenerated(const EdgeList& list, bool directed, const TransferProfile& profile = {},
+                         const GeneratorOptions& options = {});
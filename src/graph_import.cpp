@@ -0,0 +1,376 @@
+#include "graph_import.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "directed_graph.hpp"
+#include "line_reader.hpp"
+
+constexpr size_t kNoColumn = static_cast<size_t>(-1);
+constexpr double kMicrodegree = 1e-6;
+constexpr size_t kMaxReservedArcs = size_t{1} << 20;
+
+TransferMatrix RoadTransferMatrix() {
+    TransferMatrix matrix = TransferMatrix::Diagonal(0);
+    for (Transport vehicle : {Transport::Bus, Transport::Car}) {
+        matrix.SetCost(Transport::Feet, vehicle, 0);
+        matrix.SetCost(vehicle, Transport::Feet, 0);
+    }
+    return matrix;
+}
+
+[[noreturn]] static void Fail(const char* format, size_t line, const std::string& message) {
+    throw std::invalid_argument(std::string(format) + " line " + std::to_string(line) + ": " + message);
+}
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static void SkipBlanks(std::string_view& rest) {
+    size_t begin = 0;
+    while (begin < rest.size() && IsBlank(rest[begin])) {
+        ++begin;
+    }
+    rest.remove_prefix(begin);
+}
+
+// Splits off the next field and the separator after it; double quotes protect separators inside it.
+// Whitespace separated fields collapse runs of blanks. In comma separated lines (`csv`) blanks only
+// pad a field and every comma ends exactly one field, so empty cells keep their column.
+// `comma` tells whether a comma followed the field.
+static std::string_view NextField(std::string_view& rest, bool csv = false, bool* comma = nullptr) {
+    SkipBlanks(rest);
+    std::string_view field;
+    if (!rest.empty() && rest.front() == '"') {
+        const size_t close = rest.find('"', 1);
+        field = rest.substr(1, close == std::string_view::npos ? close : close - 1);
+        rest.remove_prefix(close == std::string_view::npos ? rest.size() : close + 1);
+    } else {
+        size_t end = 0;
+        while (end < rest.size() && rest[end] != ',' && (csv || !IsBlank(rest[end]))) {
+            ++end;
+        }
+        field = rest.substr(0, end);
+        rest.remove_prefix(end);
+        while (!field.empty() && IsBlank(field.back())) {
+            field.remove_suffix(1);
+        }
+    }
+    SkipBlanks(rest);
+    const bool separated = !rest.empty() && rest.front() == ',';
+    if (separated) {
+        rest.remove_prefix(1);
+    }
+    if (comma != nullptr) {
+        *comma = separated;
+    }
+    return field;
+}
+
+static bool HasUnquotedComma(std::string_view line) {
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ',' && !quoted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// All fields of a line, empty cells included; a blank line has none.
+static void SplitFields(std::string_view line, ArraySequence<std::string_view>& fields) {
+    fields.Clear();
+    const bool csv = HasUnquotedComma(line);
+    SkipBlanks(line);
+    bool comma = !line.empty();
+    while (!line.empty() || comma) {
+        fields.Append(NextField(line, csv, &comma));
+    }
+}
+
+template <typename T>
+static bool ParseNumber(std::string_view field, T& value) {
+    if (!field.empty() && field.front() == '+') {
+        field.remove_prefix(1);
+    }
+    const char* end = field.data() + field.size();
+    const auto [ptr, ec] = std::from_chars(field.data(), end, value);
+    return ec == std::errc() && ptr == end && !field.empty();
+}
+
+static bool ParseWeight(std::string_view field, double scale, int64_t& weight) {
+    if (scale == 1 && ParseNumber(field, weight)) {
+        return true;
+    }
+    double value = 0;
+    if (!ParseNumber(field, value) || !std::isfinite(value * scale)) {
+        return false;
+    }
+    weight = std::llround(value * scale);
+    return true;
+}
+
+static void SetTransfers(IGraph& graph, const TransferMatrix& transfer) {
+    for (size_t v = 0; v < graph.GetVertexCount(); ++v) {
+        graph.GetVertex(v)->transfer = transfer;
+    }
+}
+
+static ArraySequence<Coordinate> ReadDimacsCoordinates(std::istream& in, size_t n) {
+    ArraySequence<Coordinate> coordinates(n);
+    ForEachLine(in, [&](std::string_view line, size_t number) {
+        if (line.empty() || line.front() == 'c') {
+            return;
+        }
+        std::string_view rest = line;
+        const std::string_view kind = NextField(rest);
+        if (kind == "p") {
+            size_t count = 0;
+            if (NextField(rest) != "aux" || NextField(rest) != "sp" || NextField(rest) != "co" ||
+                !ParseNumber(NextField(rest), count)) {
+                Fail("DIMACS coordinates", number, "expected \"p aux sp co n\"");
+            }
+            if (count != n) {
+                Fail("DIMACS coordinates", number, "vertex count differs from the graph");
+            }
+            return;
+        }
+        size_t id = 0;
+        int64_t x = 0;
+        int64_t y = 0;
+        if (kind != "v" || !ParseNumber(NextField(rest), id) || !ParseNumber(NextField(rest), x) ||
+            !ParseNumber(NextField(rest), y)) {
+            Fail("DIMACS coordinates", number, "expected \"v id x y\"");
+        }
+        if (id == 0 || id > n) {
+            Fail("DIMACS coordinates", number, "vertex " + std::to_string(id) + " is out of range");
+        }
+        coordinates.begin()[id - 1] = {static_cast<double>(x) * kMicrodegree, static_cast<double>(y) * kMicrodegree};
+    });
+    return coordinates;
+}
+
+GraphData ReadDimacs(std::istream& graph, std::istream* coordinates, const ImportOptions& options) {
+    size_t n = 0;
+    size_t m = 0;
+    bool has_problem = false;
+    ArraySequence<Edge> edges;
+    size_t arc_count = 0;
+    ForEachLine(graph, [&](std::string_view line, size_t number) {
+        if (line.empty() || line.front() == 'c') {
+            return;
+        }
+        std::string_view rest = line;
+        const std::string_view kind = NextField(rest);
+        if (kind == "p") {
+            if (has_problem) {
+                Fail("DIMACS", number, "duplicate problem line");
+            }
+            if (NextField(rest) != "sp" || !ParseNumber(NextField(rest), n) || !ParseNumber(NextField(rest), m)) {
+                Fail("DIMACS", number, "expected \"p sp n m\"");
+            }
+            has_problem = true;
+            // The declared count is untrusted: it sizes the builder input only up to a cap, beyond that
+            // storage grows with the arcs actually read.
+            edges = ArraySequence<Edge>(std::min(m, kMaxReservedArcs));
+            return;
+        }
+        if (kind != "a") {
+            Fail("DIMACS", number, "unknown line type \"" + std::string(kind) + "\"");
+        }
+        if (!has_problem) {
+            Fail("DIMACS", number, "arc before the problem line");
+        }
+        if (arc_count == m) {
+            Fail("DIMACS", number, "more arcs than declared");
+        }
+        size_t u = 0;
+        size_t v = 0;
+        int64_t w = 0;
+        if (!ParseNumber(NextField(rest), u) || !ParseNumber(NextField(rest), v) || !ParseNumber(NextField(rest), w) ||
+            !NextField(rest).empty()) {
+            Fail("DIMACS", number, "expected \"a u v w\"");
+        }
+        if (u == 0 || v == 0 || u > n || v > n) {
+            Fail("DIMACS", number, "vertex is out of range");
+        }
+        if (arc_count < edges.GetLength()) {
+            edges.begin()[arc_count] = Edge(u - 1, v - 1, w);
+        } else {
+            edges.Append(Edge(u - 1, v - 1, w));
+        }
+        ++arc_count;
+    });
+    if (!has_problem) {
+        throw std::invalid_argument("DIMACS file has no problem line");
+    }
+    if (arc_count != m) {
+        throw std::invalid_argument("DIMACS file declares " + std::to_string(m) + " arcs but has " +
+                                    std::to_string(arc_count));
+    }
+
+    GraphData res;
+    res.graph = DirectedGraph::Build(n, edges, options.threads);
+    SetTransfers(*res.graph, options.transfer);
+    if (coordinates != nullptr) {
+        res.coordinates = ReadDimacsCoordinates(*coordinates, n);
+    }
+    return res;
+}
+
+GraphData ImportDimacs(const std::string& graph_path, const std::string& coordinates_path,
+                       const ImportOptions& options) {
+    std::ifstream graph(graph_path, std::ios::binary);
+    if (!graph.is_open()) {
+        throw std::invalid_argument("Cannot open " + graph_path);
+    }
+    if (coordinates_path.empty()) {
+        return ReadDimacs(graph, nullptr, options);
+    }
+    std::ifstream coordinates(coordinates_path, std::ios::binary);
+    if (!coordinates.is_open()) {
+        throw std::invalid_argument("Cannot open " + coordinates_path);
+    }
+    return ReadDimacs(graph, &coordinates, options);
+}
+
+struct OsmColumns {
+    size_t u = kNoColumn;
+    size_t v = kNoColumn;
+    size_t weight = kNoColumn;
+    size_t oneway = kNoColumn;
+    std::array<size_t, 4> coordinates = {kNoColumn, kNoColumn, kNoColumn, kNoColumn};
+
+    size_t GetRequiredCount() const {
+        size_t res = std::max(u, v) + 1;
+        for (size_t column : {weight, oneway, coordinates[0], coordinates[1], coordinates[2], coordinates[3]}) {
+            if (column != kNoColumn) {
+                res = std::max(res, column + 1);
+            }
+        }
+        return res;
+    }
+};
+
+static size_t FindColumn(const ArraySequence<std::string_view>& names, std::initializer_list<std::string_view> aliases) {
+    for (std::string_view alias : aliases) {
+        for (size_t i = 0; i < names.GetLength(); ++i) {
+            if (names.Get(i) == alias) {
+                return i;
+            }
+        }
+    }
+    return kNoColumn;
+}
+
+static OsmColumns ParseOsmHeader(const ArraySequence<std::string_view>& names, size_t line) {
+    OsmColumns columns;
+    columns.u = FindColumn(names, {"u", "source", "from"});
+    columns.v = FindColumn(names, {"v", "target", "to"});
+    if (columns.u == kNoColumn || columns.v == kNoColumn) {
+        Fail("OSM", line, "header must name the source and target columns");
+    }
+    columns.weight = FindColumn(names, {"weight", "cost", "travel_time", "length"});
+    columns.oneway = FindColumn(names, {"oneway"});
+    columns.coordinates = {FindColumn(names, {"u_x", "u_lon"}), FindColumn(names, {"u_y", "u_lat"}),
+                           FindColumn(names, {"v_x", "v_lon"}), FindColumn(names, {"v_y", "v_lat"})};
+    const size_t present = std::count_if(columns.coordinates.begin(), columns.coordinates.end(),
+                                         [](size_t column) { return column != kNoColumn; });
+    if (present != 0 && present != columns.coordinates.size()) {
+        Fail("OSM", line, "coordinates need all of u_x, u_y, v_x, v_y");
+    }
+    return columns;
+}
+
+static bool IsTwoWay(std::string_view value) {
+    return value == "false" || value == "False" || value == "FALSE" || value == "0" || value == "no";
+}
+
+GraphData ReadOsmEdges(std::istream& in, const ImportOptions& options) {
+    std::unordered_map<int64_t, size_t> dense_ids;
+    ArraySequence<int64_t> external_ids;
+    ArraySequence<Coordinate> coordinates;
+    ArraySequence<Edge> edges;
+    ArraySequence<std::string_view> fields;
+    OsmColumns columns;
+    bool has_header = false;
+    bool has_coordinates = false;
+
+    auto to_dense = [&](int64_t id, Coordinate coordinate) {
+        const auto [it, inserted] = dense_ids.try_emplace(id, external_ids.GetLength());
+        if (inserted) {
+            external_ids.Append(id);
+            coordinates.Append(coordinate);
+        }
+        return it->second;
+    };
+
+    ForEachLine(in, [&](std::string_view line, size_t number) {
+        SplitFields(line, fields);
+        if (fields.GetLength() == 0 || fields.Get(0).starts_with('#')) {
+            return;
+        }
+        if (!has_header) {
+            columns = ParseOsmHeader(fields, number);
+            has_coordinates = columns.coordinates[0] != kNoColumn;
+            has_header = true;
+            return;
+        }
+        if (fields.GetLength() < columns.GetRequiredCount()) {
+            Fail("OSM", number, "missing columns");
+        }
+        int64_t u = 0;
+        int64_t v = 0;
+        if (!ParseNumber(fields.Get(columns.u), u) || !ParseNumber(fields.Get(columns.v), v)) {
+            Fail("OSM", number, "malformed node id");
+        }
+        int64_t weight = 1;
+        if (columns.weight != kNoColumn && !ParseWeight(fields.Get(columns.weight), options.weight_scale, weight)) {
+            Fail("OSM", number, "malformed weight");
+        }
+        std::array<double, 4> position{};
+        for (size_t i = 0; has_coordinates && i < position.size(); ++i) {
+            if (!ParseNumber(fields.Get(columns.coordinates[i]), position[i])) {
+                Fail("OSM", number, "malformed coordinate");
+            }
+        }
+        const size_t from = to_dense(u, {position[0], position[1]});
+        const size_t to = to_dense(v, {position[2], position[3]});
+        edges.Append(Edge(from, to, weight));
+        if (columns.oneway != kNoColumn && IsTwoWay(fields.Get(columns.oneway))) {
+            edges.Append(Edge(to, from, weight));
+        }
+    });
+    if (!has_header) {
+        throw std::invalid_argument("OSM edge list has no header line");
+    }
+
+    GraphData res;
+    res.graph = DirectedGraph::Build(external_ids.GetLength(), edges, options.threads);
+    SetTransfers(*res.graph, options.transfer);
+    if (external_ids.GetLength() != 0) {
+        res.external_ids = std::move(external_ids);
+        if (has_coordinates) {
+            res.coordinates = std::move(coordinates);
+        }
+    }
+    return res;
+}
+
+GraphData ImportOsmEdges(const std::string& path, const ImportOptions& options) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    return ReadOsmEdges(in, options);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+#include "graph_io.hpp"
+
+// Road datasets carry no transit data: every vertex may switch between walking and either
+// vehicle for free, switching directly between car and bus is not allowed.
+TransferMatrix RoadTransferMatrix();
+
+struct ImportOptions {
+    // Assigned to every imported vertex.
+    TransferMatrix transfer = RoadTransferMatrix();
+    // Fractional weights (OSM lengths in metres, travel times in seconds) are multiplied by this
+    // and rounded.
+    double weight_scale = 1;
+    // Graph building threads, 0 means hardware concurrency.
+    size_t threads = 0;
+};
+
+// DIMACS 9th Challenge shortest path files: "c" comments, "p sp n m", then m lines "a u v w" with
+// 1-based vertex ids. The optional coordinate stream has "p aux sp co n" and "v id x y" lines in
+// millionths of a degree; coordinates are returned in degrees.
+GraphData ReadDimacs(std::istream& graph, std::istream* coordinates = nullptr, const ImportOptions& options = {});
+
+GraphData ImportDimacs(const std::string& graph_path, const std::string& coordinates_path = "",
+                       const ImportOptions& options = {});
+
+// Edge lists extracted from OpenStreetMap (osmnx, osm2graph and similar), comma or whitespace
+// separated with a header line naming the columns:
+//   u | source | from               source node id, any 64-bit integer
+//   v | target | to                 target node id
+//   weight | cost | travel_time | length   the first one present is the weight, default 1
+//   oneway                          optional; rows that are not one-way ("false", "0", "no") add
+//                                   arcs in both directions
+//   u_x u_y v_x v_y | u_lon u_lat v_lon v_lat   optional node coordinates
+// Double quotes protect separators inside fields. Node ids are renumbered densely in order of first
+// appearance and returned as external ids.
+GraphData ReadOsmEdges(std::istream& in, const ImportOptions& options = {});
+
+GraphData ImportOsmEdges(const std::string& path, const ImportOptions& options = {});
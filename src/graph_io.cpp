@@ -0,0 +1,303 @@
+#include "graph_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "directed_graph.hpp"
+#include "graph.hpp"
+
+constexpr char kMagic[8] = {'L', 'A', 'B', '3', 'G', 'R', 'P', 'H'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kDirectedFlag = 1;
+constexpr uint32_t kCoordinatesFlag = 2;
+constexpr uint32_t kExternalIdsFlag = 4;
+constexpr size_t kBlockRecords = 1 << 16;
+constexpr uint64_t kUnknownSize = std::numeric_limits<uint64_t>::max();
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+};
+
+struct BinaryEdge {
+    uint32_t u;
+    uint32_t v;
+    int64_t weight;
+};
+
+struct BinaryTransfer {
+    uint64_t vertex;
+    int64_t cost[kTransportCount * kTransportCount];
+};
+
+struct BinaryModes {
+    uint64_t edge;
+    int32_t extra[kTransportCount];
+    uint32_t mask;
+};
+
+static_assert(sizeof(BinaryEdge) == 16);
+
+template <typename T>
+static void WriteRecords(std::ostream& out, const T* items, size_t count) {
+    out.write(reinterpret_cast<const char*>(items), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+static void ReadRecords(std::istream& in, T* items, size_t count) {
+    const std::streamsize bytes = static_cast<std::streamsize>(count * sizeof(T));
+    if (!in.read(reinterpret_cast<char*>(items), bytes)) {
+        throw std::invalid_argument("Binary graph is truncated");
+    }
+}
+
+template <typename T>
+static T ReadRecord(std::istream& in) {
+    T item;
+    ReadRecords(in, &item, 1);
+    return item;
+}
+
+// Bytes left after the read position, or kUnknownSize when the stream cannot seek.
+static uint64_t RemainingBytes(std::istream& in) {
+    const std::istream::pos_type position = in.tellg();
+    if (position == std::istream::pos_type(-1) || !in.seekg(0, std::ios::end)) {
+        in.clear();
+        return kUnknownSize;
+    }
+    const std::istream::pos_type end = in.tellg();
+    in.seekg(position);
+    if (end == std::istream::pos_type(-1) || !in) {
+        throw std::runtime_error("Failed to seek in binary graph");
+    }
+    return static_cast<uint64_t>(end - position);
+}
+
+// Charges `count` records against the bytes left, so that counts read from a corrupt file fail
+// before anything of their size is allocated.
+static void Consume(uint64_t& remaining, uint64_t count, size_t record_size) {
+    if (count > remaining / record_size) {
+        throw std::invalid_argument("Binary graph is truncated");
+    }
+    if (remaining != kUnknownSize) {
+        remaining -= count * record_size;
+    }
+}
+
+// Reads `count` records in blocks. Storage grows with what was actually read, which bounds the
+// allocation by the input size on streams that cannot report it up front.
+template <typename T>
+static ArraySequence<T> ReadSection(std::istream& in, uint64_t count) {
+    ArraySequence<T> res;
+    ArraySequence<T> block(std::min<uint64_t>(count, kBlockRecords));
+    for (uint64_t begin = 0; begin < count; begin += kBlockRecords) {
+        const size_t size = std::min<uint64_t>(kBlockRecords, count - begin);
+        ReadRecords(in, block.begin(), size);
+        for (size_t i = 0; i < size; ++i) {
+            res.Append(block.begin()[i]);
+        }
+    }
+    return res;
+}
+
+static BinaryTransfer ToBinary(size_t vertex, const TransferMatrix& transfer) {
+    BinaryTransfer res{vertex, {}};
+    for (size_t i = 0; i < kTransportCount * kTransportCount; ++i) {
+        res.cost[i] = transfer.cost[i / kTransportCount][i % kTransportCount];
+    }
+    return res;
+}
+
+static TransferMatrix FromBinary(const BinaryTransfer& item) {
+    TransferMatrix res;
+    for (size_t i = 0; i < kTransportCount * kTransportCount; ++i) {
+        res.cost[i / kTransportCount][i % kTransportCount] = item.cost[i];
+    }
+    return res;
+}
+
+void WriteGraphBinary(const GraphData& data, std::ostream& out) {
+    const IGraph& graph = *data.graph;
+    const size_t n = graph.GetVertexCount();
+    const size_t m = graph.GetEdgeCount();
+    if (n > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Binary graph format supports at most 2^32 - 1 vertices");
+    }
+    const bool has_coordinates = data.coordinates.GetLength() != 0;
+    const bool has_ids = data.external_ids.GetLength() != 0;
+    if ((has_coordinates && data.coordinates.GetLength() != n) || (has_ids && data.external_ids.GetLength() != n)) {
+        throw std::invalid_argument("Per-vertex data must have one entry per vertex");
+    }
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.flags = (graph.IsDirected() ? kDirectedFlag : 0) | (has_coordinates ? kCoordinatesFlag : 0) |
+                   (has_ids ? kExternalIdsFlag : 0);
+    header.vertex_count = n;
+    header.edge_count = m;
+    WriteRecords(out, &header, 1);
+
+    // Imported graphs share one matrix almost everywhere, so only the exceptions are stored.
+    const TransferMatrix base = n != 0 ? graph.GetVertex(0)->transfer : TransferMatrix::Diagonal(0);
+    const BinaryTransfer base_record = ToBinary(0, base);
+    WriteRecords(out, &base_record, 1);
+    ArraySequence<BinaryTransfer> transfers;
+    for (size_t v = 0; v < n; ++v) {
+        const TransferMatrix& transfer = graph.GetVertex(v)->transfer;
+        if (transfer.cost != base.cost) {
+            transfers.Append(ToBinary(v, transfer));
+        }
+    }
+    const uint64_t transfer_count = transfers.GetLength();
+    WriteRecords(out, &transfer_count, 1);
+    WriteRecords(out, transfers.begin(), transfers.GetLength());
+
+    ArraySequence<BinaryEdge> block;
+    ArraySequence<BinaryModes> modes;
+    for (size_t id = 0, written = 0; written < m; ++id) {
+        if (!graph.HasEdge(id)) {
+            continue;
+        }
+        const Edge edge = graph.GetEdge(id);
+        if (!edge.modes.IsDefault()) {
+            BinaryModes item{written, {}, edge.modes.mask};
+            std::copy(edge.modes.extra.begin(), edge.modes.extra.end(), item.extra);
+            modes.Append(item);
+        }
+        ++written;
+    }
+    const uint64_t mode_count = modes.GetLength();
+    WriteRecords(out, &mode_count, 1);
+    WriteRecords(out, modes.begin(), modes.GetLength());
+
+    for (size_t id = 0, written = 0; written < m; ++id) {
+        if (!graph.HasEdge(id)) {
+            continue;
+        }
+        const Edge edge = graph.GetEdge(id);
+        block.Append({static_cast<uint32_t>(edge.u), static_cast<uint32_t>(edge.v), edge.weight});
+        ++written;
+        if (block.GetLength() == kBlockRecords || written == m) {
+            WriteRecords(out, block.begin(), block.GetLength());
+            block.Clear();
+        }
+    }
+    if (has_coordinates) {
+        WriteRecords(out, data.coordinates.begin(), n);
+    }
+    if (has_ids) {
+        WriteRecords(out, data.external_ids.begin(), n);
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write binary graph");
+    }
+}
+
+void SaveGraphBinary(const GraphData& data, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+    WriteGraphBinary(data, out);
+}
+
+GraphData ReadGraphBinary(std::istream& in, size_t threads) {
+    const BinaryHeader header = ReadRecord<BinaryHeader>(in);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::invalid_argument("Not a binary graph file");
+    }
+    if (header.version != kFormatVersion) {
+        throw std::invalid_argument("Unsupported binary graph version " + std::to_string(header.version));
+    }
+    if (header.vertex_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Binary graph has more than 2^32 - 1 vertices");
+    }
+    const size_t n = header.vertex_count;
+    const bool has_coordinates = (header.flags & kCoordinatesFlag) != 0 && n != 0;
+    const bool has_ids = (header.flags & kExternalIdsFlag) != 0 && n != 0;
+
+    uint64_t remaining = RemainingBytes(in);
+    Consume(remaining, 1, sizeof(BinaryTransfer));
+    const TransferMatrix base = FromBinary(ReadRecord<BinaryTransfer>(in));
+    Consume(remaining, 1, sizeof(uint64_t));
+    const uint64_t transfer_count = ReadRecord<uint64_t>(in);
+    Consume(remaining, transfer_count, sizeof(BinaryTransfer));
+    const ArraySequence<BinaryTransfer> transfers = ReadSection<BinaryTransfer>(in, transfer_count);
+    Consume(remaining, 1, sizeof(uint64_t));
+    const uint64_t mode_count = ReadRecord<uint64_t>(in);
+    Consume(remaining, mode_count, sizeof(BinaryModes));
+    const ArraySequence<BinaryModes> modes = ReadSection<BinaryModes>(in, mode_count);
+    Consume(remaining, header.edge_count, sizeof(BinaryEdge));
+    Consume(remaining, has_coordinates ? n : 0, sizeof(Coordinate));
+    Consume(remaining, has_ids ? n : 0, sizeof(int64_t));
+    const size_t m = header.edge_count;
+
+    // Sized input was checked to hold all m edges; otherwise storage grows with what was read.
+    ArraySequence<Edge> edges(remaining != kUnknownSize ? m : 0);
+    ArraySequence<BinaryEdge> block(std::min(m, kBlockRecords));
+    for (size_t begin = 0; begin < m; begin += kBlockRecords) {
+        const size_t count = std::min(kBlockRecords, m - begin);
+        ReadRecords(in, block.begin(), count);
+        for (size_t i = 0; i < count; ++i) {
+            const BinaryEdge& item = block.begin()[i];
+            const Edge edge(item.u, item.v, item.weight);
+            if (edges.GetLength() == m) {
+                edges.begin()[begin + i] = edge;
+            } else {
+                edges.Append(edge);
+            }
+        }
+    }
+    for (const BinaryModes& item : modes) {
+        if (item.edge >= m) {
+            throw std::invalid_argument("Binary graph arc modes refer to a missing edge");
+        }
+        ArcModes& target = edges.begin()[item.edge].modes;
+        target.mask = static_cast<TransportMask>(item.mask);
+        std::copy(item.extra, item.extra + kTransportCount, target.extra.begin());
+    }
+
+    GraphData res;
+    if ((header.flags & kDirectedFlag) != 0) {
+        res.graph = DirectedGraph::Build(n, edges, threads);
+    } else {
+        res.graph = Graph::Build(n, edges, threads);
+    }
+    for (size_t v = 0; v < n; ++v) {
+        res.graph->GetVertex(v)->transfer = base;
+    }
+    for (const BinaryTransfer& item : transfers) {
+        if (item.vertex >= n) {
+            throw std::invalid_argument("Binary graph transfer refers to a missing vertex");
+        }
+        res.graph->GetVertex(item.vertex)->transfer = FromBinary(item);
+    }
+    if (has_coordinates) {
+        res.coordinates = ReadSection<Coordinate>(in, n);
+    }
+    if (has_ids) {
+        res.external_ids = ReadSection<int64_t>(in, n);
+    }
+    return res;
+}
+
+GraphData LoadGraphBinary(const std::string& path, size_t threads) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    return ReadGraphBinary(in, threads);
+}
+
+bool IsGraphBinary(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
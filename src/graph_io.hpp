@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "array_sequence.hpp"
+#include "igraph.hpp"
+
+// A graph together with the optional per-vertex data that importers produce.
+struct GraphData {
+    IGraphPtr graph;
+    // Empty or one entry per vertex.
+    ArraySequence<Coordinate> coordinates;
+    // Ids of the vertices in the source dataset (e.g. OSM node ids); empty when ids were already dense.
+    ArraySequence<int64_t> external_ids;
+};
+
+// Binary graph format, host byte order:
+//   header       magic "LAB3GRPH", version, flags, n, m
+//   transfers    one default matrix and the vertices whose matrix differs from it
+//   arc modes    edges whose ArcModes are not the default
+//   edges        m records of {uint32 u, uint32 v, int64 weight}
+//   coordinates  n pairs of doubles, if flagged
+//   external ids n int64 values, if flagged
+// Only live edges are written, renumbered densely in id order.
+void WriteGraphBinary(const GraphData& data, std::ostream& out);
+
+void SaveGraphBinary(const GraphData& data, const std::string& path);
+
+// Reads edges in blocks straight into the builder's input and bulk-builds the graph.
+GraphData ReadGraphBinary(std::istream& in, size_t threads = 0);
+
+GraphData LoadGraphBinary(const std::string& path, size_t threads = 0);
+
+// True when the file starts with the binary format magic.
+bool IsGraphBinary(const std::string& path);
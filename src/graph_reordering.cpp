@@ -0,0 +1,239 @@
+#include "graph_reordering.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "directed_graph.hpp"
+#include "graph.hpp"
+#include "list_sequence.hpp"
+
+const size_t kUnassigned = static_cast<size_t>(-1);
+const uint32_t kHilbertSide = 1 << 16;
+
+VertexOrder::VertexOrder(const ArraySequence<size_t>& new_to_old)
+    : old_to_new_(new_to_old.GetLength(), kUnassigned), new_to_old_(new_to_old) {
+    for (size_t i = 0; i < new_to_old_.GetLength(); ++i) {
+        const size_t old_vertex = new_to_old_.Get(i);
+        if (old_vertex >= old_to_new_.GetLength() || old_to_new_.Get(old_vertex) != kUnassigned) {
+            throw std::invalid_argument("Vertex order is not a permutation");
+        }
+        old_to_new_.Set(i, old_vertex);
+    }
+}
+
+size_t VertexOrder::GetVertexCount() const {
+    return new_to_old_.GetLength();
+}
+
+size_t VertexOrder::ToNew(size_t old_vertex) const {
+    return old_to_new_.Get(old_vertex);
+}
+
+size_t VertexOrder::ToOld(size_t new_vertex) const {
+    return new_to_old_.Get(new_vertex);
+}
+
+static void AppendBfs(const IGraph& graph, size_t root, ArraySequence<bool>& visited, ArraySequence<size_t>& order) {
+    size_t head = order.GetLength();
+    visited.Set(true, root);
+    order.Append(root);
+    while (head < order.GetLength()) {
+        const size_t vertex = order.Get(head++);
+        for (const Arc& arc : *graph.GetArcs(vertex)) {
+            const size_t next = arc.vertex->id;
+            if (!visited.Get(next)) {
+                visited.Set(true, next);
+                order.Append(next);
+            }
+        }
+    }
+}
+
+VertexOrder BfsOrder(const IGraph& graph, size_t root) {
+    const size_t n = graph.GetVertexCount();
+    ArraySequence<bool> visited(n, false);
+    ArraySequence<size_t> order;
+    if (n == 0) {
+        return VertexOrder(order);
+    }
+    if (root >= n) {
+        throw std::out_of_range("Root vertex is out of range");
+    }
+    AppendBfs(graph, root, visited, order);
+    for (size_t v = 0; v < n; ++v) {
+        if (!visited.Get(v)) {
+            AppendBfs(graph, v, visited, order);
+        }
+    }
+    return VertexOrder(order);
+}
+
+VertexOrder ReverseCuthillMcKeeOrder(const IGraph& graph) {
+    const size_t n = graph.GetVertexCount();
+    ArraySequence<size_t> degree(n);
+    ArraySequence<size_t> by_degree(n);
+    for (size_t v = 0; v < n; ++v) {
+        degree.Set(graph.GetArcs(v)->GetLength(), v);
+        by_degree.Set(v, v);
+    }
+    auto less_degree = [&degree](size_t a, size_t b) {
+        return std::make_pair(degree.Get(a), a) < std::make_pair(degree.Get(b), b);
+    };
+    std::sort(by_degree.begin(), by_degree.end(), less_degree);
+
+    ArraySequence<bool> visited(n, false);
+    ArraySequence<size_t> order;
+    ArraySequence<size_t> neighbours;
+    for (size_t start : by_degree) {
+        if (visited.Get(start)) {
+            continue;
+        }
+        size_t head = order.GetLength();
+        visited.Set(true, start);
+        order.Append(start);
+        while (head < order.GetLength()) {
+            const size_t vertex = order.Get(head++);
+            neighbours.Clear();
+            for (const Arc& arc : *graph.GetArcs(vertex)) {
+                const size_t next = arc.vertex->id;
+                if (!visited.Get(next)) {
+                    visited.Set(true, next);
+                    neighbours.Append(next);
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end(), less_degree);
+            for (size_t next : neighbours) {
+                order.Append(next);
+            }
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return VertexOrder(order);
+}
+
+static uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t index = 0;
+    for (uint32_t s = kHilbertSide / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) > 0;
+        const uint32_t ry = (y & s) > 0;
+        index += uint64_t{s} * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kHilbertSide - 1 - x;
+                y = kHilbertSide - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+static uint32_t ToGrid(double value, double min, double max) {
+    if (max <= min) {
+        return 0;
+    }
+    const double scaled = (value - min) / (max - min) * (kHilbertSide - 1);
+    return static_cast<uint32_t>(std::clamp(scaled, 0.0, static_cast<double>(kHilbertSide - 1)));
+}
+
+VertexOrder HilbertOrder(const Sequence<Coordinate>& coordinates) {
+    const ArraySequence<Coordinate> points(coordinates);
+    const size_t n = points.GetLength();
+    if (n == 0) {
+        return VertexOrder(ArraySequence<size_t>());
+    }
+    Coordinate min = points.GetFirst();
+    Coordinate max = points.GetFirst();
+    for (const Coordinate& p : points) {
+        min = {std::min(min.x, p.x), std::min(min.y, p.y)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y)};
+    }
+
+    ArraySequence<std::pair<uint64_t, size_t>> keyed(n);
+    for (size_t v = 0; v < n; ++v) {
+        const Coordinate& p = points.Get(v);
+        keyed.Set({HilbertIndex(ToGrid(p.x, min.x, max.x), ToGrid(p.y, min.y, max.y)), v}, v);
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    ArraySequence<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) {
+        order.Set(keyed.Get(i).second, i);
+    }
+    return VertexOrder(order);
+}
+
+ReorderedGraph Reorder(const IGraph& graph, const VertexOrder& order) {
+    const size_t n = graph.GetVertexCount();
+    if (order.GetVertexCount() != n) {
+        throw std::invalid_argument("Vertex order does not match the graph size");
+    }
+    const bool directed = graph.IsDirected();
+    IGraphPtr res;
+    if (directed) {
+        res = std::make_shared<DirectedGraph>(n);
+    } else {
+        res = std::make_shared<Graph>(n);
+    }
+
+    for (size_t new_u = 0; new_u < n; ++new_u) {
+        VertexPtr source = graph.GetVertex(order.ToOld(new_u));
+        res->GetVertex(new_u)->transfer = source->transfer;
+        // An undirected edge is stored as two arcs, so it is re-added from its smaller endpoint only.
+        // A loop puts both of its arcs into the same list, every second one is skipped.
+        bool loop_pending = false;
+        for (const Arc& arc : *source->arcs) {
+            const size_t new_v = order.ToNew(arc.vertex->id);
+            if (!directed) {
+                if (new_v < new_u) {
+                    continue;
+                }
+                if (new_v == new_u) {
+                    loop_pending = !loop_pending;
+                    if (!loop_pending) {
+                        continue;
+                    }
+                }
+            }
+            res->AddEdge({new_u, new_v, arc.weight, arc.modes});
+        }
+    }
+    return {res, std::make_shared<const VertexOrder>(order)};
+}
+
+ReorderedShortestPaths::ReorderedShortestPaths(IShortestPathsFinderPtr finder, std::shared_ptr<const VertexOrder> order)
+    : finder_(std::move(finder)), order_(std::move(order)) {
+}
+
+int64_t ReorderedShortestPaths::GetDistance(size_t to) const {
+    return finder_->GetDistance(order_->ToNew(to));
+}
+
+SequencePtr<size_t> ReorderedShortestPaths::GetShortestPath(size_t to) const {
+    SequencePtr<size_t> path = finder_->GetShortestPath(order_->ToNew(to));
+    if (path == nullptr) {
+        return nullptr;
+    }
+    auto res = std::make_shared<ArraySequence<size_t>>(path->GetLength());
+    size_t i = 0;
+    for (auto it = path->GetIterator(); it->HasNext(); it->Next()) {
+        res->Set(order_->ToOld(it->GetCurrentItem()), i++);
+    }
+    return res;
+}
+
+PathSteps ReorderedShortestPaths::GetShortestPathWithTransfers(size_t to) const {
+    PathSteps path = finder_->GetShortestPathWithTransfers(order_->ToNew(to));
+    if (path == nullptr) {
+        return nullptr;
+    }
+    auto res = std::make_shared<ArraySequence<PathStep>>(path->GetLength());
+    size_t i = 0;
+    for (auto it = path->GetIterator(); it->HasNext(); it->Next()) {
+        PathStep step = it->GetCurrentItem();
+        step.vertex = order_->ToOld(step.vertex);
+        res->Set(step, i++);
+    }
+    return res;
+}
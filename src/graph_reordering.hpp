@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "ishortest_paths.hpp"
+
+// Vertex renumbering: vertex `old` of the source graph becomes vertex `ToNew(old)` of the permuted one.
+class VertexOrder {
+public:
+    // new_to_old[i] is the old id of the i-th vertex in the new order.
+    explicit VertexOrder(const ArraySequence<size_t>& new_to_old);
+
+    size_t GetVertexCount() const;
+
+    size_t ToNew(size_t old_vertex) const;
+
+    size_t ToOld(size_t new_vertex) const;
+
+private:
+    ArraySequence<size_t> old_to_new_;
+    ArraySequence<size_t> new_to_old_;
+};
+
+// Breadth-first order from root; vertices not reachable from it start new BFS trees in id order.
+VertexOrder BfsOrder(const IGraph& graph, size_t root = 0);
+
+// Reverse Cuthill-McKee: BFS from a minimum-degree vertex of every component, neighbours visited in
+// increasing degree, whole order reversed. Directed graphs are traversed along outgoing arcs.
+VertexOrder ReverseCuthillMcKeeOrder(const IGraph& graph);
+
+// Sorts vertices along a Hilbert curve over their bounding box.
+VertexOrder HilbertOrder(const Sequence<Coordinate>& coordinates);
+
+struct ReorderedGraph {
+    IGraphPtr graph;
+    std::shared_ptr<const VertexOrder> order;
+};
+
+// Builds a graph of the same kind with renumbered vertices. Arcs are added in new vertex order.
+ReorderedGraph Reorder(const IGraph& graph, const VertexOrder& order);
+
+// Finder over a reordered graph that takes and returns ids of the original graph.
+class ReorderedShortestPaths : public IShortestPathsFinder {
+public:
+    ReorderedShortestPaths(IShortestPathsFinderPtr finder, std::shared_ptr<const VertexOrder> order);
+
+    int64_t GetDistance(size_t to) const override;
+
+    SequencePtr<size_t> GetShortestPath(size_t to) const override;
+
+    PathSteps GetShortestPathWithTransfers(size_t to) const override;
+
+private:
+    IShortestPathsFinderPtr finder_;
+    std::shared_ptr<const VertexOrder> order_;
+};
+
+template <typename Finder>
+IShortestPathsFinderPtr MakeReorderedFinder(const ReorderedGraph& reordered, size_t from) {
+    return std::make_shared<ReorderedShortestPaths>(
+        std::make_shared<Finder>(reordered.graph, reordered.order->ToNew(from)), reordered.order);
+}
@@ -26,6 +26,40 @@ constexpr std::array<Transport, kTransportCount> kAllTransports = {
     Transport::Feet,
 };
 
+// Bit set of transports, bit i standing for the transport with index i.
+using TransportMask = uint8_t;
+
+constexpr TransportMask TransportBit(Transport transport) {
+    return static_cast<TransportMask>(1u << ToTransportIndex(transport));
+}
+
+constexpr TransportMask kAllTransportsMask = (1u << kTransportCount) - 1;
+
+// Which transports may use an edge and how much each pays on top of the edge weight.
+// 16 bytes, so an Arc carrying it still fits a 64-byte cache line.
+struct ArcModes {
+    TransportMask mask = kAllTransportsMask;
+    std::array<int32_t, kTransportCount> extra{};
+
+    static ArcModes Only(TransportMask mask) {
+        ArcModes modes;
+        modes.mask = mask;
+        return modes;
+    }
+
+    bool Allows(Transport transport) const {
+        return (mask & TransportBit(transport)) != 0;
+    }
+
+    int64_t GetWeight(int64_t weight, Transport transport) const {
+        return weight + extra[ToTransportIndex(transport)];
+    }
+
+    bool IsDefault() const {
+        return mask == kAllTransportsMask && extra == std::array<int32_t, kTransportCount>{};
+    }
+};
+
 constexpr int64_t kNoTransferCost = 1'000'000'000'000'000'000;
 
 struct TransferMatrix {
@@ -63,12 +97,30 @@ struct TransferMatrix {
 };
 
 struct Edge {
-    Edge(size_t u_, size_t v_, int64_t w = 1) : u(u_), v(v_), weight(w) {
+    Edge(size_t u_, size_t v_, int64_t w = 1, ArcModes m = {}) : u(u_), v(v_), weight(w), modes(m) {
+    }
+
+    Edge() : Edge(0, 0) {
     }
 
     size_t u;
     size_t v;
     int64_t weight;
+    ArcModes modes;
+
+    bool Allows(Transport transport) const {
+        return modes.Allows(transport);
+    }
+
+    int64_t GetWeight(Transport transport) const {
+        return modes.GetWeight(weight, transport);
+    }
+};
+
+// Planar position of a vertex, used by geometric orderings and importers.
+struct Coordinate {
+    double x = 0;
+    double y = 0;
 };
 
 struct AccumulatedPath {
@@ -91,9 +143,32 @@ struct Arc {
     VertexPtr from;
     VertexPtr vertex;
     int64_t weight;
+    size_t edge_id = 0;
+    ArcModes modes;
+
+    bool Allows(Transport transport) const {
+        return modes.Allows(transport);
+    }
+
+    int64_t GetWeight(Transport transport) const {
+        return modes.GetWeight(weight, transport);
+    }
+};
+
+// Concrete type so that adjacency scans can use the non-virtual begin()/end().
+using Arcs = std::shared_ptr<ListSequence<Arc>>;
+
+// Arcs created for one edge: an undirected edge owns two of them, a directed one only `forward`.
+struct EdgeArcs {
+    ListNodePtr<Arc> forward;
+    ListNodePtr<Arc> backward;
 };
 
-using Arcs = SequencePtr<Arc>;
+struct EdgeUpdate {
+    size_t edge_id;
+    int64_t weight = 0;
+    bool remove = false;
+};
 
 struct Vertex {
     explicit Vertex(size_t id_, const TransferMatrix& transfer_ = TransferMatrix::Diagonal(0))
@@ -116,7 +191,25 @@ public:
 
     virtual size_t GetEdgeCount() const = 0;
 
-    virtual void AddEdge(const Edge& edge) = 0;
+    virtual bool IsDirected() const = 0;
+
+    // Edge ids are assigned in insertion order and are never reused after removal.
+    virtual size_t AddEdge(const Edge& edge) = 0;
+
+    virtual bool HasEdge(size_t edge_id) const = 0;
+
+    virtual Edge GetEdge(size_t edge_id) const = 0;
+
+    virtual void UpdateEdgeWeight(size_t edge_id, int64_t weight) = 0;
+
+    virtual void RemoveEdge(size_t edge_id) = 0;
+
+    // Validates the whole batch before changing anything and bumps the version once.
+    virtual void ApplyUpdates(const Sequence<EdgeUpdate>& updates) = 0;
+
+    // Incremented by every structural or weight change made through this interface.
+    // Direct edits of Vertex::transfer are not tracked.
+    virtual uint64_t GetVersion() const = 0;
 
     virtual VertexPtr GetVertex(size_t v) const = 0;
 
@@ -0,0 +1,313 @@
+#include "incremental_shortest_paths.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "binary_heap.hpp"
+#include "search_workspace.hpp"
+#include "transport_state.hpp"
+
+IncrementalShortestPaths::IncrementalShortestPaths(IGraphPtr graph, size_t from)
+    : StateShortestPaths(*graph, from),
+      graph_(std::move(graph)),
+      graph_version_(graph_->GetVersion()),
+      incoming_(vertex_count_),
+      first_child_(GetStateCount(vertex_count_), kNoState),
+      next_sibling_(GetStateCount(vertex_count_), kNoState),
+      prev_sibling_(GetStateCount(vertex_count_), kNoState),
+      affected_(GetStateCount(vertex_count_), false) {
+    {
+        PhaseTimer timer(stats_, SolverPhase::Setup);
+        for (size_t v = 0; v < vertex_count_; ++v) {
+            for (const Arc& arc : *graph_->GetArcs(v)) {
+                IndexEdge(arc.edge_id);
+            }
+        }
+    }
+    ArraySequence<size_t> seeds;
+    seeds.Append(from_state_);
+    Propagate(seeds);
+}
+
+static void CheckNonNegative(const Edge& edge) {
+    for (Transport transport : kAllTransports) {
+        if (edge.Allows(transport) && edge.GetWeight(transport) < 0) {
+            throw std::invalid_argument("Incremental shortest paths do not support negative edge weights");
+        }
+    }
+}
+
+void IncrementalShortestPaths::ApplyUpdates(const Sequence<EdgeUpdate>& updates) {
+    // Rejected before the graph is touched, so a bad batch leaves graph and tree in sync.
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        const EdgeUpdate& update = it->GetCurrentItem();
+        if (update.remove || !graph_->HasEdge(update.edge_id)) {
+            continue;
+        }
+        Edge edge = graph_->GetEdge(update.edge_id);
+        edge.weight = update.weight;
+        CheckNonNegative(edge);
+    }
+    graph_->ApplyUpdates(updates);
+    ArraySequence<size_t> changed;
+    for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+        changed.Append(it->GetCurrentItem().edge_id);
+    }
+    Repair(changed);
+}
+
+void IncrementalShortestPaths::Repair(const Sequence<size_t>& changed_edges) {
+    const ArraySequence<size_t> changed(changed_edges);
+    for (size_t edge_id : changed) {
+        if (!graph_->HasEdge(edge_id)) {
+            continue;
+        }
+        CheckNonNegative(graph_->GetEdge(edge_id));
+    }
+    last_repair_size_ = 0;
+    stats_ = SolverStats{};
+    const bool directed = graph_->IsDirected();
+    ArraySequence<size_t> seeds;
+    std::optional<PhaseTimer> invalidate_timer(std::in_place, stats_, SolverPhase::Invalidate);
+
+    // Tree arcs that got more expensive or disappeared invalidate the whole subtree below them.
+    ArraySequence<size_t> affected;
+    for (size_t edge_id : changed) {
+        const bool exists = graph_->HasEdge(edge_id);
+        if (exists) {
+            IndexEdge(edge_id);
+        }
+        if (edge_id >= ends_.GetLength() || ends_.Get(edge_id).u == kNoState) {
+            continue;
+        }
+        const EdgeEnds ends = ends_.Get(edge_id);
+        const Edge edge = exists ? graph_->GetEdge(edge_id) : Edge(ends.u, ends.v, kInf);
+        for (size_t direction = 0; direction < (directed ? 1 : 2); ++direction) {
+            const size_t from = direction == 0 ? ends.u : ends.v;
+            const size_t to = direction == 0 ? ends.v : ends.u;
+            for (Transport transport : kAllTransports) {
+                const size_t from_state = EncodeState(from, transport);
+                const size_t to_state = EncodeState(to, transport);
+                if (prev_->Get(to_state) != from_state || affected_.Get(to_state)) {
+                    continue;
+                }
+                AccumulatedPath candidate;
+                if (!exists || !edge.Allows(transport) ||
+                    !dist_->Get(from_state).Combine(edge.GetWeight(transport), candidate) ||
+                    candidate.total_cost > dist_->Get(to_state).total_cost) {
+                    CollectSubtree(to_state, affected);
+                }
+            }
+        }
+    }
+
+    for (size_t state : affected) {
+        dist_->Set(AccumulatedPath{kInf}, state);
+        Detach(state);
+    }
+    for (size_t state : affected) {
+        size_t parent = kNoState;
+        const int64_t distance = BestIncoming(state, parent);
+        if (parent != kNoState) {
+            dist_->Set(AccumulatedPath{distance}, state);
+            SetParent(state, parent);
+            seeds.Append(state);
+        }
+    }
+    for (size_t state : affected) {
+        affected_.Set(false, state);
+    }
+
+    // Cheaper or new arcs can only improve their head states.
+    for (size_t edge_id : changed) {
+        if (!graph_->HasEdge(edge_id)) {
+            continue;
+        }
+        const Edge edge = graph_->GetEdge(edge_id);
+        for (size_t direction = 0; direction < (directed ? 1 : 2); ++direction) {
+            const size_t from = direction == 0 ? edge.u : edge.v;
+            const size_t to = direction == 0 ? edge.v : edge.u;
+            for (Transport transport : kAllTransports) {
+                const size_t from_state = EncodeState(from, transport);
+                const size_t to_state = EncodeState(to, transport);
+                AccumulatedPath candidate;
+                if (dist_->Get(from_state).total_cost == kInf || !edge.Allows(transport) ||
+                    !dist_->Get(from_state).Combine(edge.GetWeight(transport), candidate) ||
+                    candidate.total_cost >= dist_->Get(to_state).total_cost) {
+                    continue;
+                }
+                dist_->Set(candidate, to_state);
+                SetParent(to_state, from_state);
+                seeds.Append(to_state);
+            }
+        }
+    }
+
+    invalidate_timer.reset();
+    Propagate(seeds);
+    graph_version_ = graph_->GetVersion();
+}
+
+uint64_t IncrementalShortestPaths::GetGraphVersion() const {
+    return graph_version_;
+}
+
+size_t IncrementalShortestPaths::GetLastRepairSize() const {
+    return last_repair_size_;
+}
+
+void IncrementalShortestPaths::IndexEdge(size_t edge_id) {
+    while (ends_.GetLength() <= edge_id) {
+        ends_.Append({});
+    }
+    if (ends_.Get(edge_id).u != kNoState) {
+        return;
+    }
+    const Edge edge = graph_->GetEdge(edge_id);
+    ends_.Set({edge.u, edge.v}, edge_id);
+    incoming_.begin()[edge.v].Append(edge_id);
+    if (!graph_->IsDirected() && edge.u != edge.v) {
+        incoming_.begin()[edge.u].Append(edge_id);
+    }
+}
+
+size_t IncrementalShortestPaths::GetSource(const EdgeEnds& ends, size_t target) const {
+    if (graph_->IsDirected()) {
+        return ends.u;
+    }
+    return ends.v == target ? ends.u : ends.v;
+}
+
+void IncrementalShortestPaths::SetParent(size_t state, size_t parent) {
+    Detach(state);
+    prev_->Set(parent, state);
+    const size_t head = first_child_.Get(parent);
+    next_sibling_.Set(head, state);
+    if (head != kNoState) {
+        prev_sibling_.Set(state, head);
+    }
+    first_child_.Set(state, parent);
+}
+
+void IncrementalShortestPaths::Detach(size_t state) {
+    const size_t parent = prev_->Get(state);
+    if (parent == kNoState) {
+        return;
+    }
+    const size_t prev = prev_sibling_.Get(state);
+    const size_t next = next_sibling_.Get(state);
+    if (prev != kNoState) {
+        next_sibling_.Set(next, prev);
+    } else {
+        first_child_.Set(next, parent);
+    }
+    if (next != kNoState) {
+        prev_sibling_.Set(prev, next);
+    }
+    prev_sibling_.Set(kNoState, state);
+    next_sibling_.Set(kNoState, state);
+    prev_->Set(kNoState, state);
+}
+
+void IncrementalShortestPaths::CollectSubtree(size_t root, ArraySequence<size_t>& states) {
+    size_t head = states.GetLength();
+    affected_.Set(true, root);
+    states.Append(root);
+    while (head < states.GetLength()) {
+        const size_t state = states.Get(head++);
+        for (size_t child = first_child_.Get(state); child != kNoState; child = next_sibling_.Get(child)) {
+            if (!affected_.Get(child)) {
+                affected_.Set(true, child);
+                states.Append(child);
+            }
+        }
+    }
+}
+
+int64_t IncrementalShortestPaths::BestIncoming(size_t state, size_t& parent) const {
+    const size_t vertex_id = DecodeVertex(state);
+    const Transport transport = DecodeTransport(state);
+    int64_t best = kInf;
+    auto consider = [&](size_t from_state, int64_t delta_cost) {
+        if (affected_.Get(from_state) || dist_->Get(from_state).total_cost == kInf) {
+            return;
+        }
+        AccumulatedPath candidate;
+        if (dist_->Get(from_state).Combine(delta_cost, candidate) && candidate.total_cost < best) {
+            best = candidate.total_cost;
+            parent = from_state;
+        }
+    };
+
+    const TransferMatrix& transfer = graph_->GetVertex(vertex_id)->transfer;
+    for (Transport from_transport : kAllTransports) {
+        const int64_t step_cost = transfer.GetCost(from_transport, transport);
+        if (from_transport != transport && step_cost < kNoTransferCost) {
+            consider(EncodeState(vertex_id, from_transport), step_cost);
+        }
+    }
+    for (size_t edge_id : incoming_.Get(vertex_id)) {
+        if (!graph_->HasEdge(edge_id)) {
+            continue;
+        }
+        const Edge edge = graph_->GetEdge(edge_id);
+        if (edge.Allows(transport)) {
+            consider(EncodeState(GetSource(ends_.Get(edge_id), vertex_id), transport), edge.GetWeight(transport));
+        }
+    }
+    return best;
+}
+
+void IncrementalShortestPaths::Propagate(ArraySequence<size_t>& seeds) {
+    PhaseTimer timer(stats_, SolverPhase::Search);
+    BinaryHeap<StateQueueEntry> queue;
+    for (size_t state : seeds) {
+        queue.Push({dist_->Get(state).total_cost, state});
+    }
+    CountStat(stats_.queue_pushes, seeds.GetLength());
+    while (!queue.IsEmpty()) {
+        const StateQueueEntry top = queue.Pop();
+        CountStat(stats_.queue_pops);
+        const size_t state = top.state;
+        if (top.distance != dist_->Get(state).total_cost) {
+            continue;
+        }
+        ++last_repair_size_;
+        CountStat(stats_.settled_states);
+        const AccumulatedPath current = dist_->Get(state);
+        const size_t vertex_id = DecodeVertex(state);
+        const Transport current_transport = DecodeTransport(state);
+        VertexPtr vertex = graph_->GetVertex(vertex_id);
+
+        auto relax = [&](size_t to_state, int64_t delta_cost) {
+            if (delta_cost < 0) {
+                throw std::invalid_argument("Incremental shortest paths do not support negative edge weights");
+            }
+            AccumulatedPath candidate;
+            if (!current.Combine(delta_cost, candidate) || candidate.total_cost >= dist_->Get(to_state).total_cost) {
+                return;
+            }
+            dist_->Set(candidate, to_state);
+            SetParent(to_state, state);
+            queue.Push({candidate.total_cost, to_state});
+            CountStat(stats_.successful_relaxations);
+            CountStat(stats_.queue_pushes);
+        };
+
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (step_cost < kNoTransferCost) {
+                CountStat(stats_.transfer_relaxations);
+                relax(EncodeState(vertex_id, next_transport), step_cost);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (arc.Allows(current_transport)) {
+                CountStat(stats_.relaxed_arcs);
+                relax(EncodeState(arc.vertex->id, current_transport), arc.GetWeight(current_transport));
+            }
+        }
+    }
+    TrackPeakMemory(stats_, GetMemoryUsage() + queue.GetCapacity() * sizeof(StateQueueEntry));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "array_sequence.hpp"
+#include "shortest_paths.hpp"
+#include "transport_state.hpp"
+
+// Keeps the shortest-path tree of one source and repairs it after edge changes instead of
+// recomputing from scratch (Ramalingam-Reps). Distances always equal those of a fresh Dijkstra.
+// Weights and transfer costs must be non-negative.
+class IncrementalShortestPaths : public StateShortestPaths {
+public:
+    IncrementalShortestPaths(IGraphPtr graph, size_t from);
+
+    // Applies the batch to the graph and repairs the tree.
+    void ApplyUpdates(const Sequence<EdgeUpdate>& updates);
+
+    // Repairs the tree after the given edges were changed, removed or added directly on the graph.
+    // Every edge changed since the last repair must be listed.
+    void Repair(const Sequence<size_t>& changed_edges);
+
+    // Graph version the current distances correspond to.
+    uint64_t GetGraphVersion() const;
+
+    // Number of states settled by the last repair.
+    size_t GetLastRepairSize() const;
+
+private:
+    IGraphPtr graph_;
+    uint64_t graph_version_;
+    size_t last_repair_size_ = 0;
+
+    struct EdgeEnds {
+        size_t u = kNoState;
+        size_t v = kNoState;
+    };
+
+    // Edge ids entering each vertex, including ids of edges removed since.
+    ArraySequence<ArraySequence<size_t>> incoming_;
+    // Endpoints by edge id, kept so that removed edges can still be located.
+    ArraySequence<EdgeEnds> ends_;
+
+    // Children of every state in the tree as intrusive doubly linked lists.
+    ArraySequence<size_t> first_child_;
+    ArraySequence<size_t> next_sibling_;
+    ArraySequence<size_t> prev_sibling_;
+
+    ArraySequence<bool> affected_;
+
+    void IndexEdge(size_t edge_id);
+
+    size_t GetSource(const EdgeEnds& ends, size_t target) const;
+
+    void SetParent(size_t state, size_t parent);
+
+    void Detach(size_t state);
+
+    void CollectSubtree(size_t root, ArraySequence<size_t>& states);
+
+    int64_t BestIncoming(size_t state, size_t& parent) const;
+
+    void Propagate(ArraySequence<size_t>& seeds);
+};
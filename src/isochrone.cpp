@@ -0,0 +1,84 @@
+#include "isochrone.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "parallel.hpp"
+#include "transport_state.hpp"
+
+ReachedStates ExploreWithinBudget(const IGraph& graph, size_t from, int64_t budget, SearchWorkspace& workspace) {
+    if (from >= graph.GetVertexCount()) {
+        throw std::out_of_range("Source vertex is out of range");
+    }
+    workspace.Reset();
+    auto res = std::make_shared<ArraySequence<ReachedState>>();
+    if (budget < 0) {
+        return res;
+    }
+
+    const size_t from_state = EncodeState(from, kSourceTransport);
+    workspace.labels.FindOrInsert(from_state).distance = 0;
+    workspace.queue.Push({0, from_state});
+    while (!workspace.queue.IsEmpty()) {
+        const StateQueueEntry top = workspace.queue.Pop();
+        StateTable::Entry& entry = *workspace.labels.Find(top.state);
+        if (entry.settled || top.distance != entry.distance) {
+            continue;
+        }
+        entry.settled = true;
+        const size_t state = top.state;
+        const size_t vertex_id = DecodeVertex(state);
+        const Transport current_transport = DecodeTransport(state);
+        res->Append({vertex_id, current_transport, top.distance});
+
+        auto relax = [&](size_t to_state, int64_t delta_cost) {
+            if (delta_cost < 0) {
+                throw std::invalid_argument("Budget search does not support negative edge weights");
+            }
+            AccumulatedPath candidate;
+            if (!AccumulatedPath{top.distance}.Combine(delta_cost, candidate) || candidate.total_cost > budget) {
+                return;
+            }
+            StateTable::Entry& next = workspace.labels.FindOrInsert(to_state);
+            if (candidate.total_cost < next.distance) {
+                next.distance = candidate.total_cost;
+                next.parent = state;
+                workspace.queue.Push({candidate.total_cost, to_state});
+            }
+        };
+
+        VertexPtr vertex = graph.GetVertex(vertex_id);
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (step_cost < kNoTransferCost) {
+                relax(EncodeState(vertex_id, next_transport), step_cost);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (arc.Allows(current_transport)) {
+                relax(EncodeState(arc.vertex->id, current_transport), arc.GetWeight(current_transport));
+            }
+        }
+    }
+    return res;
+}
+
+ReachedStates ExploreWithinBudget(const IGraph& graph, size_t from, int64_t budget) {
+    SearchWorkspace workspace;
+    return ExploreWithinBudget(graph, from, budget, workspace);
+}
+
+ArraySequence<ReachedStates> ExploreWithinBudget(
+    const IGraph& graph, const Sequence<size_t>& origins, int64_t budget, size_t threads) {
+    const ArraySequence<size_t> sources(origins);
+    ArraySequence<ReachedStates> res(sources.GetLength());
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    ArraySequence<SearchWorkspace> workspaces(std::min(threads, std::max<size_t>(1, sources.GetLength())));
+    ParallelFor(sources.GetLength(), workspaces.GetLength(), [&](size_t i, size_t worker) {
+        res.begin()[i] = ExploreWithinBudget(graph, sources.Get(i), budget, workspaces.begin()[worker]);
+    });
+    return res;
+}
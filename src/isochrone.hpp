@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "igraph.hpp"
+#include "search_workspace.hpp"
+
+struct ReachedState {
+    size_t vertex;
+    Transport transport;
+    int64_t cost;
+};
+
+using ReachedStates = std::shared_ptr<ArraySequence<ReachedState>>;
+
+// All (vertex, transport) states reachable from `from` with cost <= budget, in increasing cost.
+// Only states inside the budget are ever stored; neighbours beyond it are skipped without a label.
+ReachedStates ExploreWithinBudget(const IGraph& graph, size_t from, int64_t budget, SearchWorkspace& workspace);
+
+ReachedStates ExploreWithinBudget(const IGraph& graph, size_t from, int64_t budget);
+
+// Evaluates every origin on up to `threads` threads (0 = hardware concurrency) with one
+// workspace per thread. The graph must not be modified meanwhile.
+ArraySequence<ReachedStates> ExploreWithinBudget(
+    const IGraph& graph, const Sequence<size_t>& origins, int64_t budget, size_t threads = 0);
@@ -0,0 +1,195 @@
+#include "k_shortest_paths.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "parallel.hpp"
+#include "transport_state.hpp"
+
+// costs[i] is the cost of the path prefix ending in states[i].
+struct StatePath {
+    ArraySequence<size_t> states;
+    ArraySequence<int64_t> costs;
+};
+
+static bool SamePrefix(const StatePath& a, const StatePath& b, size_t length) {
+    if (a.states.GetLength() < length || b.states.GetLength() < length) {
+        return false;
+    }
+    return std::equal(a.states.begin(), a.states.begin() + length, b.states.begin());
+}
+
+static bool SamePath(const StatePath& a, const StatePath& b) {
+    return a.states.GetLength() == b.states.GetLength() && SamePrefix(a, b, a.states.GetLength());
+}
+
+static bool Contains(const ArraySequence<StatePath>& paths, const StatePath& path) {
+    for (const StatePath& other : paths) {
+        if (SamePath(other, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Dijkstra from spur_state to the first state of target, avoiding workspace.banned states and the
+// transitions spur_state -> banned_next. Appends the found states (spur_state included) to res.
+static bool SearchSpur(
+    const IGraph& graph, size_t spur_state, int64_t start_cost, size_t target, const ArraySequence<size_t>& banned_next,
+    SearchWorkspace& workspace, const StateTable& banned, StatePath& res) {
+    workspace.Reset();
+    workspace.labels.FindOrInsert(spur_state).distance = start_cost;
+    workspace.queue.Push({start_cost, spur_state});
+    while (!workspace.queue.IsEmpty()) {
+        const StateQueueEntry top = workspace.queue.Pop();
+        StateTable::Entry& entry = *workspace.labels.Find(top.state);
+        if (entry.settled || top.distance != entry.distance) {
+            continue;
+        }
+        entry.settled = true;
+        const size_t state = top.state;
+        const size_t vertex_id = DecodeVertex(state);
+
+        if (vertex_id == target) {
+            ArraySequence<size_t> reversed;
+            for (size_t s = state; s != kNoState; s = workspace.labels.Find(s)->parent) {
+                reversed.Append(s);
+            }
+            for (size_t i = reversed.GetLength(); i > 0; --i) {
+                const size_t s = reversed.Get(i - 1);
+                res.states.Append(s);
+                res.costs.Append(workspace.labels.GetDistance(s));
+            }
+            return true;
+        }
+
+        const Transport current_transport = DecodeTransport(state);
+        auto relax = [&](size_t to_state, int64_t delta_cost) {
+            if (delta_cost < 0) {
+                throw std::invalid_argument("K shortest paths do not support negative edge weights");
+            }
+            if (to_state == state || banned.Find(to_state) != nullptr) {
+                return;
+            }
+            if (state == spur_state && std::find(banned_next.begin(), banned_next.end(), to_state) != banned_next.end()) {
+                return;
+            }
+            AccumulatedPath candidate;
+            if (!AccumulatedPath{top.distance}.Combine(delta_cost, candidate)) {
+                return;
+            }
+            StateTable::Entry& next = workspace.labels.FindOrInsert(to_state);
+            if (candidate.total_cost < next.distance) {
+                next.distance = candidate.total_cost;
+                next.parent = state;
+                workspace.queue.Push({candidate.total_cost, to_state});
+            }
+        };
+
+        VertexPtr vertex = graph.GetVertex(vertex_id);
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (step_cost < kNoTransferCost) {
+                relax(EncodeState(vertex_id, next_transport), step_cost);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (arc.Allows(current_transport)) {
+                relax(EncodeState(arc.vertex->id, current_transport), arc.GetWeight(current_transport));
+            }
+        }
+    }
+    return false;
+}
+
+static PathSteps ToPathSteps(const StatePath& path) {
+    auto res = std::make_shared<ArraySequence<PathStep>>(path.states.GetLength());
+    for (size_t i = 0; i < path.states.GetLength(); ++i) {
+        const size_t state = path.states.Get(i);
+        const bool is_transfer = i > 0 && DecodeVertex(path.states.Get(i - 1)) == DecodeVertex(state);
+        res->Set({DecodeVertex(state), DecodeTransport(state), is_transfer}, i);
+    }
+    return res;
+}
+
+YenKShortestPaths::YenKShortestPaths(IGraphPtr graph, size_t threads)
+    : graph_(std::move(graph)),
+      workspaces_(threads == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : threads) {
+}
+
+RankedPaths YenKShortestPaths::Find(size_t from, size_t to, size_t k) {
+    if (from >= graph_->GetVertexCount() || to >= graph_->GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    auto res = std::make_shared<ArraySequence<RankedPath>>();
+    if (k == 0) {
+        return res;
+    }
+
+    ArraySequence<StatePath> accepted;
+    ArraySequence<StatePath> candidates;
+    {
+        SpurWorkspace& workspace = workspaces_.begin()[0];
+        workspace.banned.Clear();
+        StatePath first;
+        if (!SearchSpur(*graph_, EncodeState(from, kSourceTransport), 0, to, ArraySequence<size_t>(), workspace.search,
+                        workspace.banned, first)) {
+            return res;
+        }
+        accepted.Append(first);
+    }
+
+    while (accepted.GetLength() < k) {
+        const StatePath& last = accepted.GetLast();
+        const size_t spur_count = last.states.GetLength() - 1;
+        ArraySequence<StatePath> spur_paths(spur_count);
+        ArraySequence<bool> found(spur_count, false);
+
+        ParallelFor(spur_count, workspaces_.GetLength(), [&](size_t i, size_t worker) {
+            SpurWorkspace& workspace = workspaces_.begin()[worker];
+            workspace.banned.Clear();
+            for (size_t j = 0; j < i; ++j) {
+                workspace.banned.FindOrInsert(last.states.Get(j));
+            }
+            ArraySequence<size_t> banned_next;
+            for (const StatePath& path : accepted) {
+                if (path.states.GetLength() > i + 1 && SamePrefix(path, last, i + 1)) {
+                    banned_next.Append(path.states.Get(i + 1));
+                }
+            }
+            StatePath candidate;
+            for (size_t j = 0; j < i; ++j) {
+                candidate.states.Append(last.states.Get(j));
+                candidate.costs.Append(last.costs.Get(j));
+            }
+            if (SearchSpur(*graph_, last.states.Get(i), last.costs.Get(i), to, banned_next, workspace.search,
+                           workspace.banned, candidate)) {
+                spur_paths.begin()[i] = candidate;
+                found.begin()[i] = true;
+            }
+        });
+
+        for (size_t i = 0; i < spur_count; ++i) {
+            if (found.Get(i) && !Contains(candidates, spur_paths.Get(i)) && !Contains(accepted, spur_paths.Get(i))) {
+                candidates.Append(spur_paths.Get(i));
+            }
+        }
+        if (candidates.GetLength() == 0) {
+            break;
+        }
+        size_t best = 0;
+        for (size_t i = 1; i < candidates.GetLength(); ++i) {
+            if (candidates.Get(i).costs.GetLast() < candidates.Get(best).costs.GetLast()) {
+                best = i;
+            }
+        }
+        accepted.Append(candidates.Get(best));
+        candidates.EraseAt(best);
+    }
+
+    for (const StatePath& path : accepted) {
+        res->Append({path.costs.GetLast(), ToPathSteps(path)});
+    }
+    return res;
+}
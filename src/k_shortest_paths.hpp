@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "ishortest_paths.hpp"
+#include "search_workspace.hpp"
+
+struct RankedPath {
+    int64_t cost = 0;
+    PathSteps steps;
+};
+
+using RankedPaths = std::shared_ptr<ArraySequence<RankedPath>>;
+
+// Yen's k shortest loopless paths over the (vertex, transport) state graph.
+// A path starts in the source Feet state and ends at its first arrival at the target vertex.
+// Loopless means that no state repeats, so a vertex may still be passed in different transports.
+// Paths are told apart by their state sequence; parallel arcs collapse into the cheapest one.
+// Weights and transfer costs must be non-negative.
+class YenKShortestPaths {
+public:
+    // Spur searches of one iteration run on up to `threads` threads (0 = hardware concurrency),
+    // each thread reusing its own workspace across iterations and queries.
+    explicit YenKShortestPaths(IGraphPtr graph, size_t threads = 0);
+
+    // Up to k paths in non-decreasing cost. Not safe to call concurrently on one object.
+    RankedPaths Find(size_t from, size_t to, size_t k);
+
+private:
+    struct SpurWorkspace {
+        SearchWorkspace search;
+        StateTable banned;
+    };
+
+    IGraphPtr graph_;
+    ArraySequence<SpurWorkspace> workspaces_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Calls fn(line, line_number) for every line of the stream, numbering from 1. The stream is read in
+// large blocks and lines are views into the block buffer, valid only during the call; a trailing
+// '\r' is dropped.
+template <typename Fn>
+void ForEachLine(std::istream& in, Fn&& fn, size_t block_bytes = 1 << 20) {
+    std::string buffer;
+    size_t line_number = 0;
+    auto emit = [&](size_t begin, size_t end) {
+        if (end > begin && buffer[end - 1] == '\r') {
+            --end;
+        }
+        fn(std::string_view(buffer.data() + begin, end - begin), ++line_number);
+    };
+    bool eof = false;
+    while (!eof) {
+        const size_t carried = buffer.size();
+        buffer.resize(carried + block_bytes);
+        in.read(buffer.data() + carried, static_cast<std::streamsize>(block_bytes));
+        buffer.resize(carried + static_cast<size_t>(in.gcount()));
+        eof = !in;
+        size_t begin = 0;
+        for (size_t nl = buffer.find('\n'); nl != std::string::npos; nl = buffer.find('\n', begin)) {
+            emit(begin, nl);
+            begin = nl + 1;
+        }
+        if (eof && begin < buffer.size()) {
+            emit(begin, buffer.size());
+            begin = buffer.size();
+        }
+        buffer.erase(0, begin);
+    }
+}
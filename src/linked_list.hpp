@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 template <typename T>
 struct ListNode;
@@ -27,9 +30,52 @@ struct ListNode : public std::enable_shared_from_this<ListNode<T>> {
     }
 };
 
+// Walks raw node pointers, so iterating does not touch shared_ptr reference counts.
+template <typename T, typename Value>
+class LinkedListIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    LinkedListIterator() = default;
+
+    explicit LinkedListIterator(ListNode<T>* node) : node_(node) {
+    }
+
+    reference operator*() const {
+        return node_->value;
+    }
+
+    pointer operator->() const {
+        return &node_->value;
+    }
+
+    LinkedListIterator& operator++() {
+        node_ = node_->next.get();
+        return *this;
+    }
+
+    LinkedListIterator operator++(int) {
+        LinkedListIterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool operator==(const LinkedListIterator& other) const = default;
+
+private:
+    ListNode<T>* node_ = nullptr;
+};
+
 template <typename T>
 class LinkedList {
 public:
+    using Iterator = LinkedListIterator<T, T>;
+    using ConstIterator = LinkedListIterator<T, const T>;
+
     LinkedList(const T* items, size_t count) {
         for (size_t i = 0; i < count; ++i) {
             Append(items[i]);
@@ -162,6 +208,26 @@ public:
         return first_;
     }
 
+    ListNodePtr<T> GetLastNode() const {
+        return last_;
+    }
+
+    Iterator begin() {
+        return Iterator(first_.get());
+    }
+
+    Iterator end() {
+        return Iterator();
+    }
+
+    ConstIterator begin() const {
+        return ConstIterator(first_.get());
+    }
+
+    ConstIterator end() const {
+        return ConstIterator();
+    }
+
     void EraseAt(size_t index) {
         if (index >= size_) {
             throw std::out_of_range("Index is out of range: " + std::to_string(index) + " " + std::to_string(size_));
@@ -183,6 +249,29 @@ public:
         --size_;
     }
 
+    // Unlinks a node of this list. Linear in the position of the node.
+    void EraseNode(const ListNodePtr<T>& node) {
+        if (node == nullptr) {
+            throw std::invalid_argument("Node is null");
+        }
+        if (node == first_) {
+            EraseAt(0);
+            return;
+        }
+        ListNode<T>* prev = first_.get();
+        while (prev != nullptr && prev->next != node) {
+            prev = prev->next.get();
+        }
+        if (prev == nullptr) {
+            throw std::invalid_argument("Node does not belong to the list");
+        }
+        prev->next = node->next;
+        if (node == last_) {
+            last_ = prev->shared_from_this();
+        }
+        --size_;
+    }
+
     void Clear() {
         while (first_ != nullptr) {
             auto next = first_->next;
@@ -43,6 +43,9 @@ private:
 template <typename T>
 class ListSequence : public Sequence<T> {
 public:
+    using Iterator = typename LinkedList<T>::Iterator;
+    using ConstIterator = typename LinkedList<T>::ConstIterator;
+
     ListSequence(const T* items, size_t count) : data_(items, count) {
     }
 
@@ -118,6 +121,16 @@ public:
         data_.EraseAt(index);
     }
 
+    // Node handles stay valid until the node is erased, which allows O(1) access to a stored element.
+    ListNodePtr<T> AppendNode(const T& item) {
+        data_.Append(item);
+        return data_.GetLastNode();
+    }
+
+    void EraseNode(const ListNodePtr<T>& node) {
+        data_.EraseNode(node);
+    }
+
     void Clear() override {
         data_.Clear();
     }
@@ -126,6 +139,22 @@ public:
         return std::make_shared<ListSequenceIterator<T>>(data_.GetBegin());
     }
 
+    Iterator begin() {
+        return data_.begin();
+    }
+
+    Iterator end() {
+        return data_.end();
+    }
+
+    ConstIterator begin() const {
+        return data_.begin();
+    }
+
+    ConstIterator end() const {
+        return data_.end();
+    }
+
 private:
     LinkedList<T> data_;
 };
@@ -0,0 +1,165 @@
+#include "numa.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Kernel ABI of mbind(2), spelled out so that no libnuma headers are needed.
+constexpr int kMpolBind = 2;
+constexpr int kMpolInterleave = 3;
+constexpr unsigned kMpolMfMove = 1 << 1;
+constexpr size_t kMaxPolicyNodes = 64;
+
+size_t NumaTopology::GetCpuCount() const {
+    size_t count = 0;
+    for (const ArraySequence<size_t>& cpus : node_cpus) {
+        count += cpus.GetLength();
+    }
+    return count;
+}
+
+size_t NumaTopology::GetWorkerNode(size_t worker) const {
+    const size_t cpu_count = GetCpuCount();
+    if (cpu_count == 0) {
+        return 0;
+    }
+    size_t slot = worker % cpu_count;
+    for (size_t node = 0; node < GetNodeCount(); ++node) {
+        if (slot < node_cpus.Get(node).GetLength()) {
+            return node;
+        }
+        slot -= node_cpus.Get(node).GetLength();
+    }
+    return 0;
+}
+
+ArraySequence<size_t> ParseCpuList(std::string_view list) {
+    ArraySequence<size_t> cpus;
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        std::string_view range = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        while (!range.empty() && (range.back() == '\n' || range.back() == ' ')) {
+            range.remove_suffix(1);
+        }
+        if (range.empty()) {
+            continue;
+        }
+        size_t first = 0;
+        size_t last = 0;
+        const char* end = range.data() + range.size();
+        std::from_chars_result parsed = std::from_chars(range.data(), end, first);
+        last = first;
+        if (parsed.ec == std::errc() && parsed.ptr != end && *parsed.ptr == '-') {
+            parsed = std::from_chars(parsed.ptr + 1, end, last);
+        }
+        if (parsed.ec != std::errc() || parsed.ptr != end || last < first) {
+            throw std::invalid_argument("Bad cpu list entry '" + std::string(range) + "'");
+        }
+        for (size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.Append(cpu);
+        }
+    }
+    return cpus;
+}
+
+static NumaTopology SingleNode() {
+    NumaTopology topology;
+    ArraySequence<size_t> cpus;
+    const size_t count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t cpu = 0; cpu < count; ++cpu) {
+        cpus.Append(cpu);
+    }
+    topology.node_ids.Append(0);
+    topology.node_cpus.Append(cpus);
+    return topology;
+}
+
+NumaTopology DetectNumaTopology() {
+    NumaTopology topology;
+    // Node ids can have holes; a run of missing ids ends the scan.
+    for (size_t node = 0, missing = 0; node < kMaxPolicyNodes && missing < 8; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string line;
+        if (!in || !std::getline(in, line)) {
+            ++missing;
+            continue;
+        }
+        missing = 0;
+        ArraySequence<size_t> cpus;
+        try {
+            cpus = ParseCpuList(line);
+        } catch (const std::invalid_argument&) {
+            return SingleNode();
+        }
+        // Memory-only nodes have no CPUs to run workers on.
+        if (cpus.GetLength() > 0) {
+            topology.node_ids.Append(node);
+            topology.node_cpus.Append(cpus);
+        }
+    }
+    return topology.GetNodeCount() == 0 ? SingleNode() : topology;
+}
+
+#ifdef __linux__
+bool PinCurrentThread(const ArraySequence<size_t>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+static bool SetMemoryPolicy(const void* data, size_t bytes, int mode, unsigned long nodemask) {
+    if (data == nullptr || bytes == 0) {
+        return true;
+    }
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(data) + bytes;
+    return syscall(SYS_mbind, begin, end - begin, mode, &nodemask, kMaxPolicyNodes + 1, kMpolMfMove) == 0;
+}
+#else
+bool PinCurrentThread(const ArraySequence<size_t>&) {
+    return false;
+}
+
+static bool SetMemoryPolicy(const void*, size_t, int, unsigned long) {
+    return false;
+}
+#endif
+
+bool BindMemoryToNode(const void* data, size_t bytes, size_t node_id) {
+    if (node_id >= kMaxPolicyNodes) {
+        return false;
+    }
+    return SetMemoryPolicy(data, bytes, kMpolBind, 1UL << node_id);
+}
+
+bool InterleaveMemory(const void* data, size_t bytes, const NumaTopology& topology) {
+    unsigned long mask = 0;
+    for (size_t node_id : topology.node_ids) {
+        if (node_id < kMaxPolicyNodes) {
+            mask |= 1UL << node_id;
+        }
+    }
+    // A single node has nothing to interleave over.
+    if (topology.GetNodeCount() <= 1) {
+        return true;
+    }
+    return SetMemoryPolicy(data, bytes, kMpolInterleave, mask);
+}
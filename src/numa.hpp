@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "array_sequence.hpp"
+
+// Memory nodes of the machine and the CPUs that belong to each, read from
+// /sys/devices/system/node on Linux. Elsewhere, or when sysfs is unavailable, everything is one node.
+struct NumaTopology {
+    // Kernel ids of the nodes that have CPUs; node_cpus[i] belongs to node_ids[i].
+    ArraySequence<size_t> node_ids;
+    ArraySequence<ArraySequence<size_t>> node_cpus;
+
+    size_t GetNodeCount() const {
+        return node_cpus.GetLength();
+    }
+
+    size_t GetCpuCount() const;
+
+    // Index (into node_ids) of the node of the worker-th thread when workers fill the nodes one after
+    // another, so the first threads stay on one socket and later ones spill over to the next.
+    size_t GetWorkerNode(size_t worker) const;
+};
+
+NumaTopology DetectNumaTopology();
+
+// Parses the kernel's cpulist format, e.g. "0-3,8,10-11".
+ArraySequence<size_t> ParseCpuList(std::string_view list);
+
+// Restricts the calling thread to the given CPUs. Returns false where affinity is unsupported or denied.
+bool PinCurrentThread(const ArraySequence<size_t>& cpus);
+
+// Memory policy hints for an existing buffer; pages already touched are migrated. Both return false
+// if the kernel refuses or the platform has no NUMA policy, which leaves the memory where it is.
+// node_id is a kernel node id, see NumaTopology::node_ids.
+bool BindMemoryToNode(const void* data, size_t bytes, size_t node_id);
+
+bool InterleaveMemory(const void* data, size_t bytes, const NumaTopology& topology);
+
+enum class NumaPlacement {
+    // One copy wherever the builder allocated it.
+    Shared,
+    // One copy spread page by page over all nodes.
+    Interleave,
+    // One copy per node, built and bound there; workers read the replica of their node.
+    Replicate,
+};
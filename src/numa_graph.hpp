@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "compact_shortest_paths.hpp"
+#include "numa.hpp"
+
+// Read-only CompactGraph laid out for a NUMA machine. Shared keeps the single copy as it is,
+// Interleave moves its pages round-robin over all nodes, Replicate builds one copy per node on a
+// thread pinned to that node (so first touch already places it) and binds it there. On a single
+// node every placement is the original graph.
+template <typename Id, typename Weight>
+class NumaGraphReplicas {
+public:
+    NumaGraphReplicas(CompactGraphPtr<Id, Weight> graph, NumaPlacement placement,
+                      NumaTopology topology = DetectNumaTopology())
+        : topology_(std::move(topology)), placement_(placement) {
+        if (topology_.GetNodeCount() <= 1 || placement == NumaPlacement::Shared) {
+            replicas_.Append(std::move(graph));
+            return;
+        }
+        if (placement == NumaPlacement::Interleave) {
+            graph->ForEachBuffer([&](const void* data, size_t bytes) {
+                policy_applied_ = InterleaveMemory(data, bytes, topology_) && policy_applied_;
+            });
+            replicas_.Append(std::move(graph));
+            return;
+        }
+
+        replicas_ = ArraySequence<CompactGraphPtr<Id, Weight>>(topology_.GetNodeCount());
+        std::vector<std::thread> builders;
+        std::vector<char> applied(topology_.GetNodeCount(), 1);
+        for (size_t node = 0; node < topology_.GetNodeCount(); ++node) {
+            builders.emplace_back([&, node] {
+                PinCurrentThread(topology_.node_cpus.Get(node));
+                auto replica = std::make_shared<const CompactGraph<Id, Weight>>(*graph);
+                replica->ForEachBuffer([&](const void* data, size_t bytes) {
+                    applied[node] = BindMemoryToNode(data, bytes, topology_.node_ids.Get(node)) && applied[node];
+                });
+                replicas_.begin()[node] = std::move(replica);
+            });
+        }
+        for (std::thread& builder : builders) {
+            builder.join();
+        }
+        for (char node_applied : applied) {
+            policy_applied_ = policy_applied_ && node_applied != 0;
+        }
+    }
+
+    const NumaTopology& GetTopology() const {
+        return topology_;
+    }
+
+    NumaPlacement GetPlacement() const {
+        return placement_;
+    }
+
+    size_t GetReplicaCount() const {
+        return replicas_.GetLength();
+    }
+
+    // The copy that workers on topology node `node` (an index into node_ids) read.
+    const CompactGraphPtr<Id, Weight>& GetForNode(size_t node) const {
+        return replicas_.Get(replicas_.GetLength() == 1 ? 0 : node);
+    }
+
+    // False if the kernel refused a memory policy; the data then stays where first touch put it.
+    bool IsPolicyApplied() const {
+        return policy_applied_;
+    }
+
+private:
+    NumaTopology topology_;
+    NumaPlacement placement_;
+    ArraySequence<CompactGraphPtr<Id, Weight>> replicas_;
+    bool policy_applied_ = true;
+};
+
+struct ManySourceOptions {
+    // 0 means one worker per CPU of the topology.
+    size_t threads = 0;
+    bool pin_threads = true;
+};
+
+// Runs CompactDijkstra from every source and calls fn(index, finder) on the worker that solved
+// sources[index]. Worker w belongs to node topology.GetWorkerNode(w): it is pinned there, reads that
+// node's replica and recycles one dist/prev buffer pair allocated on that node. The calling thread
+// only waits. The first exception stops the run and is rethrown.
+template <typename Id, typename Weight, typename Fn>
+void ForEachSource(const NumaGraphReplicas<Id, Weight>& graphs, const ArraySequence<size_t>& sources,
+                   const ManySourceOptions& options, Fn&& fn) {
+    const NumaTopology& topology = graphs.GetTopology();
+    size_t threads = options.threads == 0 ? topology.GetCpuCount() : options.threads;
+    threads = std::max<size_t>(1, std::min(threads, sources.GetLength()));
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < threads; ++worker) {
+        workers.emplace_back([&, worker] {
+            const size_t node = topology.GetWorkerNode(worker);
+            if (options.pin_threads) {
+                PinCurrentThread(topology.node_cpus.Get(node));
+            }
+            const CompactGraphPtr<Id, Weight>& graph = graphs.GetForNode(node);
+            CompactBuffers<Id> buffers;
+            for (size_t i = next++; i < sources.GetLength(); i = next++) {
+                try {
+                    CompactDijkstra<Id, Weight> finder(graph, sources.Get(i), std::move(buffers));
+                    fn(i, static_cast<const CompactDijkstra<Id, Weight>&>(finder));
+                    buffers = finder.TakeBuffers();
+                } catch (...) {
+                    std::lock_guard lock(error_mutex);
+                    if (error == nullptr) {
+                        error = std::current_exception();
+                    }
+                    next = sources.GetLength();
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs fn(index, worker) for every index in [0, count) on up to `threads` threads, handing out
+// indices dynamically. threads == 0 means std::thread::hardware_concurrency(). The first exception
+// thrown by fn stops the remaining work and is rethrown to the caller.
+template <typename Fn>
+void ParallelFor(size_t count, size_t threads, Fn&& fn) {
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, size_t{0});
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&](size_t worker) {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i, worker);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t worker = 1; worker < threads; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
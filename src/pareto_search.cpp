@@ -0,0 +1,158 @@
+#include "pareto_search.hpp"
+
+#include <stdexcept>
+#include <tuple>
+
+#include "transport_state.hpp"
+
+constexpr uint32_t kNoLabel = std::numeric_limits<uint32_t>::max();
+
+template <typename A, typename B>
+static bool Dominates(const A& a, const B& b) {
+    return a.cost <= b.cost && a.transfers <= b.transfers && a.extra <= b.extra;
+}
+
+bool ParetoSearch::QueueEntry::operator<(const QueueEntry& other) const {
+    return std::tie(cost, transfers, extra) < std::tie(other.cost, other.transfers, other.extra);
+}
+
+ParetoSearch::ParetoSearch(IGraphPtr graph, ParetoOptions options)
+    : graph_(std::move(graph)),
+      options_(std::move(options)),
+      bags_(GetStateCount(graph_->GetVertexCount()), kNoLabel) {
+    if (GetStateCount(graph_->GetVertexCount()) >= kNoLabel) {
+        throw std::out_of_range("Too many vertices for the Pareto search");
+    }
+}
+
+void ParetoSearch::Reset() {
+    for (uint32_t state : touched_) {
+        bags_.Set(kNoLabel, state);
+    }
+    touched_.Clear();
+    labels_.Clear();
+    results_.Clear();
+    queue_.Clear();
+}
+
+// Keeps the bag of label.state free of dominated labels; a label equal to an existing one is dropped.
+void ParetoSearch::TryAdd(const Label& label) {
+    if (label.transfers > options_.max_transfers) {
+        return;
+    }
+    for (uint32_t result : results_) {
+        if (Dominates(labels_.Get(result), label)) {
+            return;
+        }
+    }
+    uint32_t* head = bags_.GetBegin() + label.state;
+    for (uint32_t i = *head; i != kNoLabel; i = labels_.Get(i).next) {
+        if (Dominates(labels_.Get(i), label)) {
+            return;
+        }
+    }
+    Label* all = labels_.begin();
+    for (uint32_t* link = head; *link != kNoLabel;) {
+        Label& other = all[*link];
+        if (Dominates(label, other)) {
+            other.dominated = true;
+            *link = other.next;
+        } else {
+            link = &other.next;
+        }
+    }
+    if (labels_.GetLength() >= kNoLabel) {
+        throw std::length_error("Pareto search label pool overflow");
+    }
+    if (*head == kNoLabel) {
+        touched_.Append(label.state);
+    }
+    const uint32_t index = static_cast<uint32_t>(labels_.GetLength());
+    labels_.Append(label);
+    labels_.begin()[index].next = *head;
+    *head = index;
+    queue_.Push({label.cost, label.transfers, label.extra, index});
+}
+
+ParetoPaths ParetoSearch::Find(size_t from, size_t to) {
+    if (from >= graph_->GetVertexCount() || to >= graph_->GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    Reset();
+    TryAdd({0, 0, static_cast<uint32_t>(EncodeState(from, kSourceTransport)), kNoLabel, kNoLabel, 0, false});
+
+    while (!queue_.IsEmpty()) {
+        const QueueEntry top = queue_.Pop();
+        const Label current = labels_.Get(top.label);
+        if (current.dominated) {
+            continue;
+        }
+        const size_t vertex_id = DecodeVertex(current.state);
+        if (vertex_id == to) {
+            // Settled in lexicographic order, so nothing found later can dominate it.
+            bool dominated = false;
+            for (uint32_t result : results_) {
+                dominated = dominated || Dominates(labels_.Get(result), current);
+            }
+            if (!dominated) {
+                results_.Append(top.label);
+            }
+            continue;
+        }
+        const Transport current_transport = DecodeTransport(current.state);
+
+        auto extend = [&](size_t to_state, int64_t delta_cost, uint32_t delta_transfers, int64_t delta_extra) {
+            if (delta_cost < 0 || delta_extra < 0) {
+                throw std::invalid_argument("Pareto search does not support negative criteria");
+            }
+            AccumulatedPath cost;
+            AccumulatedPath extra;
+            if (!AccumulatedPath{current.cost}.Combine(delta_cost, cost) ||
+                !AccumulatedPath{current.extra}.Combine(delta_extra, extra)) {
+                return;
+            }
+            TryAdd({cost.total_cost, extra.total_cost, static_cast<uint32_t>(to_state), top.label, kNoLabel,
+                    current.transfers + delta_transfers, false});
+        };
+
+        VertexPtr vertex = graph_->GetVertex(vertex_id);
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (next_transport != current_transport && step_cost < kNoTransferCost) {
+                extend(EncodeState(vertex_id, next_transport), step_cost, 1, 0);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (arc.Allows(current_transport)) {
+                extend(EncodeState(arc.vertex->id, current_transport), arc.GetWeight(current_transport), 0,
+                       options_.criterion ? options_.criterion(arc, current_transport) : 0);
+            }
+        }
+    }
+
+    auto res = std::make_shared<ArraySequence<ParetoPath>>();
+    for (uint32_t result : results_) {
+        const Label& label = labels_.Get(result);
+        res->Append({label.cost, label.transfers, label.extra, BuildSteps(result)});
+    }
+    return res;
+}
+
+size_t ParetoSearch::GetLabelCount() const {
+    return labels_.GetLength();
+}
+
+PathSteps ParetoSearch::BuildSteps(uint32_t label) const {
+    size_t length = 0;
+    for (uint32_t i = label; i != kNoLabel; i = labels_.Get(i).parent) {
+        ++length;
+    }
+    auto res = std::make_shared<ArraySequence<PathStep>>(length);
+    for (uint32_t i = label; i != kNoLabel; i = labels_.Get(i).parent) {
+        const Label& current = labels_.Get(i);
+        const uint32_t parent = current.parent;
+        const bool is_transfer = parent != kNoLabel && DecodeVertex(labels_.Get(parent).state) == DecodeVertex(current.state);
+        res->Set({DecodeVertex(current.state), DecodeTransport(current.state), is_transfer}, --length);
+    }
+    return res;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "binary_heap.hpp"
+#include "dynamic_array.hpp"
+#include "ishortest_paths.hpp"
+
+// Optional third criterion: what an arc adds when used in the given transport. Must be non-negative.
+using ParetoCriterion = std::function<int64_t(const Arc& arc, Transport transport)>;
+
+struct ParetoOptions {
+    // Labels with more transfers are dropped.
+    size_t max_transfers = std::numeric_limits<size_t>::max();
+    // Empty means no third criterion (it is always 0).
+    ParetoCriterion criterion;
+};
+
+struct ParetoPath {
+    int64_t cost = 0;
+    size_t transfers = 0;
+    int64_t extra = 0;
+    PathSteps steps;
+};
+
+using ParetoPaths = std::shared_ptr<ArraySequence<ParetoPath>>;
+
+// Multi-criteria label-setting search (Martins) over (vertex, transport) states minimizing
+// (cost, transfer count, optional extra criterion). A transfer is any change of transport at a
+// vertex. Every state keeps a bag of mutually non-dominated labels, labels are settled in
+// lexicographic order, and labels dominated by a result already found at the target are pruned.
+// Label pool and bags are reused across queries, so one object answers one query at a time.
+class ParetoSearch {
+public:
+    explicit ParetoSearch(IGraphPtr graph, ParetoOptions options = {});
+
+    // Pareto set of paths to the target vertex, by increasing cost (so by decreasing transfers).
+    ParetoPaths Find(size_t from, size_t to);
+
+    // Labels created by the last query.
+    size_t GetLabelCount() const;
+
+private:
+    struct Label {
+        int64_t cost;
+        int64_t extra;
+        uint32_t state;
+        uint32_t parent;
+        uint32_t next;
+        uint32_t transfers;
+        bool dominated;
+    };
+
+    struct QueueEntry {
+        int64_t cost;
+        uint32_t transfers;
+        int64_t extra;
+        uint32_t label;
+
+        bool operator<(const QueueEntry& other) const;
+    };
+
+    IGraphPtr graph_;
+    ParetoOptions options_;
+    ArraySequence<Label> labels_;
+    DynamicArray<uint32_t> bags_;
+    ArraySequence<uint32_t> touched_;
+    ArraySequence<uint32_t> results_;
+    BinaryHeap<QueueEntry> queue_;
+
+    void Reset();
+
+    void TryAdd(const Label& label);
+
+    PathSteps BuildSteps(uint32_t label) const;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+
+#include "ishortest_paths.hpp"
+#include "transport_state.hpp"
+
+// Non-owning view of one shortest path stored as a predecessor array. Iteration walks the
+// predecessors lazily, from the target back to the source, without allocating. Fill* methods
+// write the path in source-to-target order into a caller buffer.
+// The view is valid while the finder that produced it is alive and unchanged.
+template <typename State>
+class BasicPathView {
+public:
+    class StepIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = PathStep;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = PathStep;
+
+        StepIterator() = default;
+
+        StepIterator(const State* prev, State no_state, size_t state, size_t source)
+            : prev_(prev), no_state_(no_state), state_(state), source_(source) {
+        }
+
+        PathStep operator*() const {
+            const State prev_state = prev_[state_];
+            const bool is_transfer = prev_state != no_state_ && DecodeVertex(prev_state) == DecodeVertex(state_) &&
+                                     DecodeTransport(prev_state) != DecodeTransport(state_);
+            return {DecodeVertex(state_), DecodeTransport(state_), is_transfer};
+        }
+
+        StepIterator& operator++() {
+            if (state_ == source_ || prev_[state_] == no_state_) {
+                state_ = kNoState;
+            } else {
+                state_ = prev_[state_];
+            }
+            return *this;
+        }
+
+        StepIterator operator++(int) {
+            StepIterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const StepIterator& other) const {
+            return state_ == other.state_;
+        }
+
+        size_t GetState() const {
+            return state_;
+        }
+
+    private:
+        const State* prev_ = nullptr;
+        State no_state_ = 0;
+        size_t state_ = kNoState;
+        size_t source_ = kNoState;
+    };
+
+    // Skips the extra states a transfer adds, so every vertex of the path is visited once.
+    class VertexIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = size_t;
+
+        VertexIterator() = default;
+
+        explicit VertexIterator(StepIterator it) : it_(it) {
+        }
+
+        size_t operator*() const {
+            return DecodeVertex(it_.GetState());
+        }
+
+        VertexIterator& operator++() {
+            const size_t vertex = **this;
+            do {
+                ++it_;
+            } while (it_ != StepIterator() && DecodeVertex(it_.GetState()) == vertex);
+            return *this;
+        }
+
+        VertexIterator operator++(int) {
+            VertexIterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const VertexIterator& other) const = default;
+
+    private:
+        StepIterator it_;
+    };
+
+    struct VertexRange {
+        VertexIterator first;
+
+        VertexIterator begin() const {
+            return first;
+        }
+
+        VertexIterator end() const {
+            return VertexIterator();
+        }
+    };
+
+    BasicPathView() = default;
+
+    // target_state is kNoState for an unreachable target.
+    BasicPathView(const State* prev, State no_state, size_t target_state, size_t source_state)
+        : prev_(prev), no_state_(no_state), target_(target_state), source_(source_state) {
+    }
+
+    bool IsEmpty() const {
+        return target_ == kNoState;
+    }
+
+    StepIterator begin() const {
+        return IsEmpty() ? StepIterator() : StepIterator(prev_, no_state_, target_, source_);
+    }
+
+    StepIterator end() const {
+        return StepIterator();
+    }
+
+    VertexRange Vertices() const {
+        return {VertexIterator(begin())};
+    }
+
+    // Number of states on the path, transfers included.
+    size_t GetLength() const {
+        size_t length = 0;
+        for (auto it = begin(); it != end(); ++it) {
+            ++length;
+        }
+        return length;
+    }
+
+    size_t GetVertexCount() const {
+        size_t count = 0;
+        for (auto it = Vertices().begin(); it != VertexIterator(); ++it) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Returns the path length. Nothing is written if the buffer is too small.
+    size_t FillSteps(PathStep* buffer, size_t capacity) const {
+        const size_t length = GetLength();
+        if (length <= capacity) {
+            size_t i = length;
+            for (PathStep step : *this) {
+                buffer[--i] = step;
+            }
+        }
+        return length;
+    }
+
+    // Returns the number of path vertices. Nothing is written if the buffer is too small.
+    size_t FillVertices(size_t* buffer, size_t capacity) const {
+        const size_t count = GetVertexCount();
+        if (count <= capacity) {
+            size_t i = count;
+            for (size_t vertex : Vertices()) {
+                buffer[--i] = vertex;
+            }
+        }
+        return count;
+    }
+
+private:
+    const State* prev_ = nullptr;
+    State no_state_ = 0;
+    size_t target_ = kNoState;
+    size_t source_ = kNoState;
+};
+
+using PathView = BasicPathView<size_t>;
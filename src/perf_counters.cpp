@@ -0,0 +1,168 @@
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+#ifdef __linux__
+static uint64_t CacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+constexpr uint64_t kTimeFormat = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+// group_fd == -1 opens a disabled event of its own, leader or standalone; members follow their leader.
+static int OpenEvent(uint32_t type, uint64_t config, int group_fd, uint64_t read_format) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = read_format;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// Extrapolates a count to the whole enabled time; an event that never ran has no value.
+static void StoreScaled(uint64_t value, uint64_t enabled, uint64_t running, PerfSample& sample, size_t event) {
+    if (running == 0) {
+        return;
+    }
+    if (running < enabled) {
+        value = static_cast<uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) /
+                                      static_cast<double>(running));
+        sample.scaled[event] = true;
+    }
+    sample.values[event] = static_cast<int64_t>(value);
+}
+#endif
+
+PerfCounters::PerfCounters() {
+    fds_.fill(-1);
+#ifdef __linux__
+    struct EventConfig {
+        uint32_t type;
+        uint64_t config;
+    };
+    std::array<EventConfig, kPerfEventCount> events;
+    events[static_cast<size_t>(PerfEvent::Cycles)] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    events[static_cast<size_t>(PerfEvent::Instructions)] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+    events[static_cast<size_t>(PerfEvent::L1dMisses)] = {
+        PERF_TYPE_HW_CACHE,
+        CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)};
+    events[static_cast<size_t>(PerfEvent::LlcMisses)] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+    events[static_cast<size_t>(PerfEvent::BranchMisses)] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+    events[static_cast<size_t>(PerfEvent::DtlbMisses)] = {
+        PERF_TYPE_HW_CACHE,
+        CacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)};
+
+    // Cycles lead when available. The kernel refuses members that would make the group unschedulable;
+    // those fall back to counting alone.
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        int fd = OpenEvent(events[i].type, events[i].config, leader_,
+                           kTimeFormat | (leader_ == -1 ? PERF_FORMAT_GROUP : 0));
+        if (fd >= 0) {
+            if (leader_ == -1) {
+                leader_ = fd;
+            }
+            grouped_[i] = true;
+            group_[group_size_++] = i;
+        } else if (leader_ != -1) {
+            fd = OpenEvent(events[i].type, events[i].config, -1, kTimeFormat);
+        }
+        fds_[i] = fd;
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    // Members before the leader.
+    for (size_t i = kPerfEventCount; i-- > 0;) {
+        if (fds_[i] >= 0) {
+            close(fds_[i]);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::IsAvailable() const {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::Start() {
+#ifdef __linux__
+    if (leader_ >= 0) {
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        if (fds_[i] >= 0 && !grouped_[i]) {
+            ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfSample PerfCounters::Stop() {
+    PerfSample res;
+#ifdef __linux__
+    if (leader_ >= 0) {
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        if (fds_[i] >= 0 && !grouped_[i]) {
+            ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    if (leader_ >= 0) {
+        // {nr, time_enabled, time_running, value per member}, shared times for the whole group.
+        std::array<uint64_t, 3 + kPerfEventCount> group{};
+        const ssize_t bytes = static_cast<ssize_t>((3 + group_size_) * sizeof(uint64_t));
+        if (read(leader_, group.data(), static_cast<size_t>(bytes)) == bytes && group[0] == group_size_) {
+            for (size_t j = 0; j < group_size_; ++j) {
+                StoreScaled(group[3 + j], group[1], group[2], res, group_[j]);
+            }
+        }
+    }
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        std::array<uint64_t, 3> single{};
+        if (fds_[i] >= 0 && !grouped_[i] &&
+            read(fds_[i], single.data(), sizeof(single)) == static_cast<ssize_t>(sizeof(single))) {
+            StoreScaled(single[0], single[1], single[2], res, i);
+        }
+    }
+#endif
+    return res;
+}
+
+const char* PerfCounters::GetName(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles:
+            return "cycles";
+        case PerfEvent::Instructions:
+            return "instructions";
+        case PerfEvent::L1dMisses:
+            return "l1d_misses";
+        case PerfEvent::LlcMisses:
+            return "llc_misses";
+        case PerfEvent::BranchMisses:
+            return "branch_misses";
+        case PerfEvent::DtlbMisses:
+            return "dtlb_misses";
+    }
+    return "unknown";
+}
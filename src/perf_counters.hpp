@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class PerfEvent : uint8_t {
+    Cycles = 0,
+    Instructions = 1,
+    L1dMisses = 2,
+    LlcMisses = 3,
+    BranchMisses = 4,
+    DtlbMisses = 5,
+};
+
+constexpr size_t kPerfEventCount = 6;
+
+constexpr int64_t kPerfUnavailable = -1;
+
+struct PerfSample {
+    std::array<int64_t, kPerfEventCount> values;
+    // Events the kernel multiplexed: their value is extrapolated from the share of time they ran.
+    std::array<bool, kPerfEventCount> scaled{};
+
+    PerfSample() {
+        values.fill(kPerfUnavailable);
+    }
+
+    int64_t Get(PerfEvent event) const {
+        return values[static_cast<size_t>(event)];
+    }
+
+    bool IsScaled(PerfEvent event) const {
+        return scaled[static_cast<size_t>(event)];
+    }
+};
+
+// Hardware counters of the calling thread through Linux perf_event_open, user space only.
+// Events are opened as one group under the cycles leader, so they are scheduled and read together
+// and their ratios stay comparable. Events that do not fit the group are counted on their own.
+// Whenever the PMU multiplexes, counts are scaled by time enabled / time running and marked in
+// PerfSample::scaled. Events the kernel or CPU refuses (perf_event_paranoid, virtual machines,
+// other OSes) stay kPerfUnavailable; the rest are still counted.
+class PerfCounters {
+public:
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Whether at least one event could be opened.
+    bool IsAvailable() const;
+
+    void Start();
+
+    PerfSample Stop();
+
+    // CSV column name of an event.
+    static const char* GetName(PerfEvent event);
+
+private:
+    std::array<int, kPerfEventCount> fds_;
+    // Leader fd of the group, -1 if no event could be grouped.
+    int leader_ = -1;
+    // Events in the group, in the order the kernel reports them on a group read.
+    std::array<size_t, kPerfEventCount> group_{};
+    size_t group_size_ = 0;
+    std::array<bool, kPerfEventCount> grouped_{};
+};
@@ -0,0 +1,573 @@
+#include "query_server.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "transport_state.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define LAB3_HAS_UNIX_SOCKETS 1
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kAcceptPollMs = 100;
+constexpr size_t kReadBytes = 1 << 16;
+
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static std::string_view Trim(std::string_view s) {
+    while (!s.empty() && IsSpace(s.front())) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && IsSpace(s.back())) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Cuts the next whitespace separated word off the front of s.
+static std::string_view NextWord(std::string_view& s) {
+    s = Trim(s);
+    size_t end = 0;
+    while (end < s.size() && !IsSpace(s[end])) {
+        ++end;
+    }
+    std::string_view word = s.substr(0, end);
+    s.remove_prefix(end);
+    return word;
+}
+
+static size_t ParseVertex(std::string_view word) {
+    size_t value = 0;
+    auto [ptr, ec] = std::from_chars(word.data(), word.data() + word.size(), value);
+    if (word.empty() || ec != std::errc() || ptr != word.data() + word.size()) {
+        throw std::invalid_argument("bad vertex '" + std::string(word) + "'");
+    }
+    return value;
+}
+
+static ArraySequence<size_t> ParseVertexList(std::string_view word) {
+    ArraySequence<size_t> vertices;
+    while (true) {
+        const size_t comma = word.find(',');
+        vertices.Append(ParseVertex(word.substr(0, comma)));
+        if (comma == std::string_view::npos) {
+            return vertices;
+        }
+        word.remove_prefix(comma + 1);
+    }
+}
+
+static void AppendDistance(std::string& out, int64_t distance) {
+    if (distance >= kInf) {
+        out += "inf";
+    } else {
+        out += std::to_string(distance);
+    }
+}
+
+// Writes " v0 v1 ... vk" straight from the predecessor array. The view walks from the target, so
+// "vk ... v0 " is appended and put in order by reversing the tail and then every number in it.
+static void AppendPath(std::string& out, const PathView& view) {
+    const size_t begin = out.size();
+    for (size_t vertex : view.Vertices()) {
+        out += std::to_string(vertex);
+        out += ' ';
+    }
+    const auto tail = out.begin() + static_cast<std::ptrdiff_t>(begin);
+    std::reverse(tail, out.end());
+    for (auto word = tail + 1; word < out.end();) {
+        const auto end = std::find(word, out.end(), ' ');
+        std::reverse(word, end);
+        word = end + (end == out.end() ? 0 : 1);
+    }
+}
+
+static bool IsQuit(std::string_view request) {
+    std::string_view rest = request;
+    return NextWord(rest) == "quit" && Trim(rest).empty();
+}
+
+QueryServer::QueryServer(IGraphPtr graph, const ServerOptions& options)
+    : graph_(graph), options_(options), cache_(std::move(graph), options.cache_bytes), pool_(options.threads) {
+    if (options_.max_batch == 0) {
+        throw std::invalid_argument("max_batch must be positive");
+    }
+}
+
+QueryServer::~QueryServer() {
+    Stop();
+}
+
+std::string QueryServer::Handle(std::string_view request) {
+    ++requests_;
+    try {
+        return Answer(request);
+    } catch (const std::exception& e) {
+        ++errors_;
+        return std::string("err ") + e.what();
+    }
+}
+
+std::string QueryServer::Answer(std::string_view request) {
+    std::string_view rest = request;
+    const std::string_view command = NextWord(rest);
+    std::string out = "ok ";
+    if (command == "dist" || command == "path") {
+        const size_t from = ParseVertex(NextWord(rest));
+        const size_t to = ParseVertex(NextWord(rest));
+        if (!Trim(rest).empty()) {
+            throw std::invalid_argument("usage: " + std::string(command) + " <from> <to>");
+        }
+        const std::shared_ptr<StateShortestPaths> finder = Solve(from);
+        const int64_t distance = finder->GetDistance(to);
+        AppendDistance(out, distance);
+        if (command == "path" && distance < kInf) {
+            AppendPath(out, finder->GetPathView(to));
+        }
+    } else if (command == "matrix") {
+        const ArraySequence<size_t> sources = ParseVertexList(NextWord(rest));
+        const ArraySequence<size_t> targets = ParseVertexList(NextWord(rest));
+        if (!Trim(rest).empty()) {
+            throw std::invalid_argument("usage: matrix <s1,s2,...> <t1,t2,...>");
+        }
+        for (size_t i = 0; i < sources.GetLength(); ++i) {
+            const IShortestPathsFinderPtr finder = Solve(sources.Get(i));
+            if (i > 0) {
+                out += ';';
+            }
+            for (size_t j = 0; j < targets.GetLength(); ++j) {
+                if (j > 0) {
+                    out += ',';
+                }
+                AppendDistance(out, finder->GetDistance(targets.Get(j)));
+            }
+        }
+    } else if (command == "info") {
+        out += "n=" + std::to_string(graph_->GetVertexCount()) + " m=" + std::to_string(graph_->GetEdgeCount()) +
+               " directed=" + (graph_->IsDirected() ? "1" : "0");
+    } else if (command == "stats") {
+        const ServerStats stats = GetStats();
+        const CacheStats cache = cache_.GetStats();
+        out += "requests=" + std::to_string(stats.requests) + " errors=" + std::to_string(stats.errors) +
+               " batches=" + std::to_string(stats.batches) + " connections=" + std::to_string(stats.connections) +
+               " timeouts=" + std::to_string(stats.timeouts) + " cache_hits=" + std::to_string(cache.hits) +
+               " cache_misses=" + std::to_string(cache.misses);
+    } else if (command == "ping") {
+        out += "pong";
+    } else if (command == "quit") {
+        out += "bye";
+    } else {
+        throw std::invalid_argument("unknown command '" + std::string(command) + "'");
+    }
+    return out;
+}
+
+std::shared_ptr<StateShortestPaths> QueryServer::Solve(size_t from) {
+    CancellationToken cancel;
+    if (options_.query_timeout.count() > 0) {
+        cancel = CancellationToken::WithTimeout(options_.query_timeout);
+    }
+    std::shared_ptr<StateShortestPaths> finder = cache_.Get(from, options_.algorithm, cancel);
+    if (!finder->IsComplete()) {
+        ++timeouts_;
+        throw std::runtime_error("deadline exceeded");
+    }
+    return finder;
+}
+
+ArraySequence<std::string> QueryServer::HandleBatch(const ArraySequence<std::string>& requests) {
+    if (requests.GetLength() == 0) {
+        return {};
+    }
+    ++batches_;
+    ArraySequence<std::string> responses(requests.GetLength());
+    pool_.ParallelFor(requests.GetLength(), [&](size_t i) { responses.begin()[i] = Handle(requests.Get(i)); });
+    return responses;
+}
+
+void QueryServer::Serve(std::istream& in, std::ostream& out) {
+    std::string line;
+    bool quit = false;
+    while (!quit && std::getline(in, line)) {
+        // Everything the client has already sent joins the batch without blocking for more.
+        ArraySequence<std::string> batch;
+        while (true) {
+            if (!Trim(line).empty()) {
+                quit = IsQuit(line);
+                batch.Append(line);
+            }
+            if (quit || batch.GetLength() == options_.max_batch || in.rdbuf()->in_avail() <= 0 ||
+                !std::getline(in, line)) {
+                break;
+            }
+        }
+        for (const std::string& response : HandleBatch(batch)) {
+            out << response << '\n';
+        }
+        out.flush();
+    }
+}
+
+ServerStats QueryServer::GetStats() const {
+    ServerStats stats;
+    stats.requests = requests_;
+    stats.errors = errors_;
+    stats.batches = batches_;
+    stats.connections = connections_;
+    stats.timeouts = timeouts_;
+    return stats;
+}
+
+#ifdef LAB3_HAS_UNIX_SOCKETS
+static std::runtime_error SocketError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+static sockaddr_un SocketAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is empty or too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return address;
+}
+
+static bool WriteAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+#ifdef MSG_NOSIGNAL
+        const ssize_t written = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+#else
+        const ssize_t written = write(fd, data.data(), data.size());
+#endif
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+static ssize_t ReadSome(int fd, char* buffer, size_t size) {
+    while (true) {
+        const ssize_t got = read(fd, buffer, size);
+        if (got >= 0 || errno != EINTR) {
+            return got;
+        }
+    }
+}
+
+void QueryServer::ServeUnixSocket(const std::string& path) {
+    const sockaddr_un address = SocketAddress(path);
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw SocketError("socket");
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        const std::runtime_error error = SocketError("bind " + path);
+        close(listener);
+        throw error;
+    }
+
+    auto reap = [this](bool all) {
+        std::list<Connection> finished;
+        {
+            std::lock_guard lock(connections_mutex_);
+            for (auto it = open_connections_.begin(); it != open_connections_.end();) {
+                auto next = std::next(it);
+                if (all || it->done) {
+                    finished.splice(finished.end(), open_connections_, it);
+                }
+                it = next;
+            }
+        }
+        for (Connection& connection : finished) {
+            connection.thread.join();
+        }
+    };
+
+    while (!stopping_) {
+        pollfd poll_fd{listener, POLLIN, 0};
+        const int ready = poll(&poll_fd, 1, kAcceptPollMs);
+        reap(false);
+        if (ready <= 0) {
+            continue;
+        }
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        ++connections_;
+        std::lock_guard lock(connections_mutex_);
+        Connection& connection = open_connections_.emplace_back();
+        connection.fd = fd;
+        connection.thread = std::thread([this, &connection] { ServeConnection(connection); });
+    }
+
+    close(listener);
+    unlink(path.c_str());
+    {
+        std::lock_guard lock(connections_mutex_);
+        for (Connection& connection : open_connections_) {
+            if (connection.fd >= 0) {
+                shutdown(connection.fd, SHUT_RDWR);
+            }
+        }
+    }
+    reap(true);
+}
+
+void QueryServer::ServeConnection(Connection& connection) {
+    std::string pending;
+    std::string reply;
+    char buffer[kReadBytes];
+    bool quit = false;
+    while (!quit) {
+        const ssize_t got = ReadSome(connection.fd, buffer, sizeof(buffer));
+        if (got <= 0) {
+            break;
+        }
+        pending.append(buffer, static_cast<size_t>(got));
+
+        // The complete lines of one read form the batch, so a pipelining client gets its requests
+        // answered together while a request-response client is not kept waiting.
+        size_t begin = 0;
+        while (!quit) {
+            ArraySequence<std::string> batch;
+            size_t end;
+            while (batch.GetLength() < options_.max_batch && (end = pending.find('\n', begin)) != std::string::npos) {
+                const std::string_view line(pending.data() + begin, end - begin);
+                begin = end + 1;
+                if (!Trim(line).empty()) {
+                    quit = IsQuit(line);
+                    batch.Append(std::string(line));
+                    if (quit) {
+                        break;
+                    }
+                }
+            }
+            if (batch.GetLength() == 0) {
+                break;
+            }
+            reply.clear();
+            for (const std::string& response : HandleBatch(batch)) {
+                reply += response;
+                reply += '\n';
+            }
+            if (!WriteAll(connection.fd, reply)) {
+                quit = true;
+            }
+        }
+        pending.erase(0, begin);
+    }
+
+    std::lock_guard lock(connections_mutex_);
+    close(connection.fd);
+    connection.fd = -1;
+    connection.done = true;
+}
+
+// Client side of one load connection: writes requests, reads response lines.
+class LoadConnection {
+public:
+    explicit LoadConnection(const std::string& path) : fd_(socket(AF_UNIX, SOCK_STREAM, 0)) {
+        if (fd_ < 0) {
+            throw SocketError("socket");
+        }
+        const sockaddr_un address = SocketAddress(path);
+        if (connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            const std::runtime_error error = SocketError("connect " + path);
+            close(fd_);
+            throw error;
+        }
+    }
+
+    ~LoadConnection() {
+        close(fd_);
+    }
+
+    LoadConnection(const LoadConnection&) = delete;
+    LoadConnection& operator=(const LoadConnection&) = delete;
+
+    void Write(std::string_view data) {
+        if (!WriteAll(fd_, data)) {
+            throw SocketError("write");
+        }
+    }
+
+    std::string ReadLine() {
+        while (true) {
+            const size_t end = pending_.find('\n', begin_);
+            if (end != std::string::npos) {
+                std::string line = pending_.substr(begin_, end - begin_);
+                begin_ = end + 1;
+                return line;
+            }
+            pending_.erase(0, begin_);
+            begin_ = 0;
+            char buffer[kReadBytes];
+            const ssize_t got = ReadSome(fd_, buffer, sizeof(buffer));
+            if (got <= 0) {
+                throw std::runtime_error("Server closed the connection");
+            }
+            pending_.append(buffer, static_cast<size_t>(got));
+        }
+    }
+
+private:
+    int fd_;
+    std::string pending_;
+    size_t begin_ = 0;
+};
+
+static size_t ParseVertexCount(const std::string& info) {
+    const size_t at = info.find("n=");
+    if (info.rfind("ok ", 0) != 0 || at == std::string::npos) {
+        throw std::runtime_error("Unexpected info response: " + info);
+    }
+    return std::stoull(info.substr(at + 2));
+}
+
+static std::string RandomRequest(std::mt19937_64& rng, size_t n, size_t index, const LoadOptions& options) {
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    if (options.matrix_percent > 0 && rng() % 100 < options.matrix_percent) {
+        std::string request = "matrix ";
+        for (size_t side = 0; side < 2; ++side) {
+            for (size_t i = 0; i < options.matrix_size; ++i) {
+                request += std::to_string(vertex(rng));
+                request += i + 1 < options.matrix_size ? ',' : ' ';
+            }
+        }
+        request.back() = '\n';
+        return request;
+    }
+    const size_t from = vertex(rng);
+    const size_t to = vertex(rng);
+    return (index % 2 == 0 ? "dist " : "path ") + std::to_string(from) + ' ' + std::to_string(to) + '\n';
+}
+
+LoadReport RunLoad(const std::string& socket_path, const LoadOptions& options) {
+    if (options.connections == 0 || options.pipeline == 0 || options.matrix_size == 0) {
+        throw std::invalid_argument("connections, pipeline and matrix_size must be positive");
+    }
+    size_t n;
+    {
+        LoadConnection probe(socket_path);
+        probe.Write("info\n");
+        n = ParseVertexCount(probe.ReadLine());
+    }
+    if (n == 0) {
+        throw std::runtime_error("Server graph has no vertices");
+    }
+
+    struct Worker {
+        ArraySequence<double> latencies;
+        uint64_t errors = 0;
+        std::exception_ptr error;
+    };
+    ArraySequence<Worker> workers(options.connections);
+    std::vector<std::thread> threads;
+    const Clock::time_point start = Clock::now();
+    for (size_t c = 0; c < options.connections; ++c) {
+        const size_t count = options.requests / options.connections + (c < options.requests % options.connections);
+        threads.emplace_back([&, c, count] {
+            Worker& worker = workers.begin()[c];
+            try {
+                LoadConnection connection(socket_path);
+                std::mt19937_64 rng(options.seed * 0x9E3779B97F4A7C15ULL + c);
+                std::deque<Clock::time_point> sent;
+                size_t next = 0;
+                std::string window;
+                for (size_t done = 0; done < count; ++done) {
+                    // Keep `pipeline` requests in flight, sending the refill in one write.
+                    window.clear();
+                    while (next < count && sent.size() < options.pipeline) {
+                        window += RandomRequest(rng, n, next++, options);
+                        sent.push_back(Clock::now());
+                    }
+                    if (!window.empty()) {
+                        connection.Write(window);
+                    }
+                    const std::string response = connection.ReadLine();
+                    const std::chrono::duration<double, std::micro> latency = Clock::now() - sent.front();
+                    sent.pop_front();
+                    worker.latencies.Append(latency.count());
+                    worker.errors += response.rfind("ok", 0) != 0;
+                }
+            } catch (...) {
+                worker.error = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    LoadReport report;
+    ArraySequence<double> latencies;
+    for (const Worker& worker : workers) {
+        if (worker.error != nullptr) {
+            std::rethrow_exception(worker.error);
+        }
+        for (double latency : worker.latencies) {
+            latencies.Append(latency);
+        }
+        report.errors += worker.errors;
+    }
+    report.requests = latencies.GetLength();
+    report.seconds = elapsed.count();
+    report.throughput = report.seconds > 0 ? static_cast<double>(report.requests) / report.seconds : 0;
+    report.p50 = Percentile(latencies, 0.5);
+    report.p90 = Percentile(latencies, 0.9);
+    report.p99 = Percentile(latencies, 0.99);
+    report.max = Percentile(latencies, 1.0);
+    return report;
+}
+#else
+void QueryServer::ServeUnixSocket(const std::string&) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+
+void QueryServer::ServeConnection(Connection&) {
+}
+
+LoadReport RunLoad(const std::string&, const LoadOptions&) {
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+}
+#endif
+
+void QueryServer::Stop() {
+    stopping_ = true;
+}
+
+double Percentile(ArraySequence<double> samples, double q) {
+    if (samples.GetLength() == 0) {
+        return 0;
+    }
+    const size_t n = samples.GetLength();
+    const size_t rank = static_cast<size_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(n)));
+    const size_t index = rank == 0 ? 0 : rank - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples.Get(index);
+}
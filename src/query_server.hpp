@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "array_sequence.hpp"
+#include "shortest_paths_cache.hpp"
+#include "thread_pool.hpp"
+
+// Line protocol, one request per line and one response per line, in request order:
+//   dist <from> <to>             ok <distance> | ok inf
+//   path <from> <to>             ok <distance> <v0> ... <vk> | ok inf
+//   matrix <s1,s2,...> <t1,...>  ok <row 1>;<row 2>;...  rows are comma separated distances
+//   info                         ok n=<vertices> m=<edges> directed=<0|1>
+//   stats                        ok requests=... errors=... batches=... timeouts=... cache_hits=... ...
+//   ping                         ok pong
+//   quit                         ok bye, then the connection is closed
+// Malformed requests get "err <message>", blank lines are ignored. Clients may pipeline: requests that are already buffered
+// are answered together as one batch on the worker pool.
+struct ServerOptions {
+    // Worker pool size, 0 means hardware concurrency.
+    size_t threads = 0;
+    // Most requests answered in one batch.
+    size_t max_batch = 256;
+    // Solved shortest-path trees are kept in a ShortestPathsCache of this size.
+    size_t cache_bytes = size_t{256} << 20;
+    Algorithm algorithm = Algorithm::Dijkstra;
+    // Solves running longer are aborted and answered "err deadline exceeded"; zero disables.
+    std::chrono::milliseconds query_timeout{0};
+};
+
+struct ServerStats {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t batches = 0;
+    uint64_t connections = 0;
+    uint64_t timeouts = 0;
+};
+
+class QueryServer {
+public:
+    QueryServer(IGraphPtr graph, const ServerOptions& options = {});
+
+    ~QueryServer();
+
+    // Answers one request line (without the newline). Thread-safe.
+    std::string Handle(std::string_view request);
+
+    // Answers a batch on the worker pool; responses[i] belongs to requests[i].
+    ArraySequence<std::string> HandleBatch(const ArraySequence<std::string>& requests);
+
+    // Serves a line stream until end of input or "quit". Responses are flushed after every batch.
+    void Serve(std::istream& in, std::ostream& out);
+
+    // Accepts connections on a Unix domain socket, each served on its own thread like Serve, until
+    // Stop() is called. Replaces a stale socket file at path. Throws std::runtime_error on socket errors.
+    void ServeUnixSocket(const std::string& path);
+
+    // Makes ServeUnixSocket return within ~100 ms; open connections are shut down and joined.
+    // A stopped server does not serve sockets again.
+    void Stop();
+
+    ServerStats GetStats() const;
+
+private:
+    IGraphPtr graph_;
+    ServerOptions options_;
+    ShortestPathsCache cache_;
+    ThreadPool pool_;
+    std::atomic<uint64_t> requests_ = 0;
+    std::atomic<uint64_t> errors_ = 0;
+    std::atomic<uint64_t> batches_ = 0;
+    std::atomic<uint64_t> connections_ = 0;
+    std::atomic<uint64_t> timeouts_ = 0;
+    std::atomic<bool> stopping_ = false;
+
+    struct Connection {
+        int fd;
+        std::thread thread;
+        std::atomic<bool> done = false;
+    };
+
+    std::mutex connections_mutex_;
+    // Finished connections are joined and dropped by the accept loop.
+    std::list<Connection> open_connections_;
+
+    std::string Answer(std::string_view request);
+
+    std::shared_ptr<StateShortestPaths> Solve(size_t from);
+
+    void ServeConnection(Connection& connection);
+};
+
+// Latency distribution and throughput of one load run.
+struct LoadReport {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    double seconds = 0;
+    double throughput = 0;
+    // Microseconds.
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+struct LoadOptions {
+    size_t requests = 10000;
+    size_t connections = 4;
+    // Requests written before reading their responses back.
+    size_t pipeline = 16;
+    // Share of "matrix" requests in percent, each with matrix_size sources and targets; the rest
+    // alternate between "dist" and "path".
+    size_t matrix_percent = 0;
+    size_t matrix_size = 4;
+    uint64_t seed = 1;
+};
+
+// Local load generator: opens `connections` client connections to a server socket, sends random
+// queries over its vertices and measures each request from send to response.
+LoadReport RunLoad(const std::string& socket_path, const LoadOptions& options = {});
+
+// Nearest-rank percentile of unsorted samples, q in [0, 1].
+double Percentile(ArraySequence<double> samples, double q);
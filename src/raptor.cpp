@@ -0,0 +1,192 @@
+#include "raptor.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+constexpr uint32_t kNoRouteStart = std::numeric_limits<uint32_t>::max();
+
+Raptor::Raptor(TimetablePtr timetable, IGraphPtr footpaths, size_t max_rides)
+    : timetable_(std::move(timetable)),
+      footpaths_(std::move(footpaths)),
+      max_rides_(max_rides),
+      vertex_count_(footpaths_->GetVertexCount()),
+      labels_((max_rides_ + 1) * vertex_count_),
+      best_(vertex_count_, kInf),
+      marked_(vertex_count_, false),
+      route_start_(timetable_->GetRouteCount(), kNoRouteStart) {
+    if (timetable_->GetStopCount() != vertex_count_) {
+        throw std::invalid_argument("Timetable stops must be the vertices of the footpath graph");
+    }
+}
+
+Raptor::Label& Raptor::At(size_t round, size_t vertex) {
+    return labels_.GetBegin()[round * vertex_count_ + vertex];
+}
+
+TransitJourney Raptor::Query(size_t from, size_t to, int64_t departure) {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Stop is out of range");
+    }
+    std::fill(labels_.GetBegin(), labels_.GetBegin() + used_rounds_ * vertex_count_, Label{});
+    std::fill(best_.GetBegin(), best_.GetBegin() + vertex_count_, kInf);
+    for (size_t stop : marked_stops_) {
+        marked_.Set(false, stop);
+    }
+    marked_stops_.Clear();
+
+    At(0, from) = {departure, kNoState, 0, 0, LabelKind::Source};
+    best_.Set(departure, from);
+    marked_.Set(true, from);
+    marked_stops_.Append(from);
+    Walk(0, to);
+    used_rounds_ = 1;
+    for (size_t round = 1; round <= max_rides_ && marked_stops_.GetLength() != 0; ++round) {
+        for (size_t v = 0; v < vertex_count_; ++v) {
+            At(round, v).arrival = At(round - 1, v).arrival;
+        }
+        used_rounds_ = round + 1;
+        ScanRoutes(round, to);
+        Walk(round, to);
+    }
+
+    for (size_t round = 0; round < used_rounds_; ++round) {
+        if (best_.Get(to) != kInf && At(round, to).arrival == best_.Get(to)) {
+            return Reconstruct(round, to);
+        }
+    }
+    return {};
+}
+
+void Raptor::ScanRoutes(size_t round, size_t target) {
+    queued_routes_.Clear();
+    uint32_t* route_start = route_start_.GetBegin();
+    for (size_t stop : marked_stops_) {
+        marked_.Set(false, stop);
+        for (const RouteStop& route_stop : timetable_->GetRoutes(stop)) {
+            if (route_start[route_stop.route] == kNoRouteStart) {
+                queued_routes_.Append(route_stop.route);
+                route_start[route_stop.route] = route_stop.index;
+            } else {
+                route_start[route_stop.route] = std::min(route_start[route_stop.route], route_stop.index);
+            }
+        }
+    }
+    marked_stops_.Clear();
+
+    int64_t* best = best_.GetBegin();
+    for (size_t route : queued_routes_) {
+        const std::span<const size_t> stops = timetable_->GetStops(route);
+        const size_t trips = timetable_->GetTripCount(route);
+        size_t trip = trips;
+        size_t board = 0;
+        for (size_t i = route_start[route]; i < stops.size(); ++i) {
+            const size_t stop = stops[i];
+            const std::span<const StopTime> times = timetable_->GetStopTimes(route, i);
+            if (trip < trips) {
+                const int64_t arrival = times[trip].arrival;
+                if (arrival < best[stop] && arrival < best[target]) {
+                    best[stop] = arrival;
+                    At(round, stop) = {arrival, board, static_cast<uint32_t>(route), static_cast<uint32_t>(trip),
+                                       LabelKind::Ride};
+                    if (!marked_.Get(stop)) {
+                        marked_.Set(true, stop);
+                        marked_stops_.Append(stop);
+                    }
+                }
+            }
+            const int64_t ready = At(round - 1, stop).arrival;
+            if (ready != kInf && (trip == trips || ready <= times[trip].departure)) {
+                const size_t earliest = timetable_->FindEarliestTrip(route, i, ready);
+                if (earliest < trip) {
+                    trip = earliest;
+                    board = i;
+                }
+            }
+        }
+        route_start[route] = kNoRouteStart;
+    }
+}
+
+// Dijkstra over Feet arcs from the stops improved in this round; only improving labels spread.
+void Raptor::Walk(size_t round, size_t target) {
+    walk_.Reset();
+    for (size_t stop : marked_stops_) {
+        const int64_t arrival = At(round, stop).arrival;
+        walk_.labels.FindOrInsert(stop).distance = arrival;
+        walk_.queue.Push({arrival, stop});
+    }
+    int64_t* best = best_.GetBegin();
+    while (!walk_.queue.IsEmpty()) {
+        const StateQueueEntry top = walk_.queue.Pop();
+        StateTable::Entry& entry = *walk_.labels.Find(top.state);
+        if (entry.settled || top.distance != entry.distance) {
+            continue;
+        }
+        entry.settled = true;
+        for (const Arc& arc : *footpaths_->GetVertex(top.state)->arcs) {
+            if (!arc.Allows(Transport::Feet)) {
+                continue;
+            }
+            const int64_t weight = arc.GetWeight(Transport::Feet);
+            if (weight < 0) {
+                throw std::invalid_argument("Walking times must be non-negative");
+            }
+            AccumulatedPath candidate;
+            const size_t next = arc.vertex->id;
+            if (!AccumulatedPath{top.distance}.Combine(weight, candidate) || candidate.total_cost >= best[next] ||
+                candidate.total_cost >= best[target]) {
+                continue;
+            }
+            best[next] = candidate.total_cost;
+            At(round, next) = {candidate.total_cost, top.state, 0, 0, LabelKind::Walk};
+            walk_.labels.FindOrInsert(next).distance = candidate.total_cost;
+            walk_.queue.Push({candidate.total_cost, next});
+            if (!marked_.Get(next)) {
+                marked_.Set(true, next);
+                marked_stops_.Append(next);
+            }
+        }
+    }
+}
+
+TransitJourney Raptor::Reconstruct(size_t round, size_t to) const {
+    TransitJourney res;
+    res.arrival = best_.Get(to);
+    ArraySequence<TransitLeg> reversed;
+    size_t vertex = to;
+    while (true) {
+        const Label& label = labels_.Get(round * vertex_count_ + vertex);
+        if (label.kind == LabelKind::Source) {
+            break;
+        }
+        // Carried labels and rides step back a round; round 0 only holds the source and walks.
+        if (label.kind != LabelKind::Walk && round == 0) {
+            throw std::logic_error("Corrupt RAPTOR labels: round 0 refers to an earlier round");
+        }
+        if (label.kind == LabelKind::Carried) {
+            --round;
+            continue;
+        }
+        if (label.kind == LabelKind::Walk) {
+            size_t start = vertex;
+            while (labels_.Get(round * vertex_count_ + start).kind == LabelKind::Walk) {
+                start = labels_.Get(round * vertex_count_ + start).parent;
+            }
+            reversed.Append(
+                {start, vertex, labels_.Get(round * vertex_count_ + start).arrival, label.arrival, kWalkLeg, 0});
+            vertex = start;
+            continue;
+        }
+        const size_t board = timetable_->GetStops(label.route)[label.parent];
+        const int64_t departure = timetable_->GetStopTimes(label.route, label.parent)[label.trip].departure;
+        reversed.Append({board, vertex, departure, label.arrival, label.route, label.trip});
+        ++res.rides;
+        vertex = board;
+        --round;
+    }
+    for (size_t i = reversed.GetLength(); i > 0; --i) {
+        res.legs.Append(reversed.Get(i - 1));
+    }
+    return res;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "igraph.hpp"
+#include "search_workspace.hpp"
+#include "timetable.hpp"
+#include "transport_state.hpp"
+
+constexpr size_t kWalkLeg = static_cast<size_t>(-1);
+
+// One leg of a journey: a ride on a trip, or a walk when route == kWalkLeg.
+struct TransitLeg {
+    size_t from = 0;
+    size_t to = 0;
+    int64_t departure = 0;
+    int64_t arrival = 0;
+    size_t route = kWalkLeg;
+    size_t trip = 0;
+};
+
+struct TransitJourney {
+    int64_t arrival = kInf;
+    size_t rides = 0;
+    ArraySequence<TransitLeg> legs;
+};
+
+// Round-based earliest-arrival transit routing (RAPTOR). Round k scans the routes touched in
+// round k - 1, then walks from the improved stops over the Feet arcs of the graph, which need not
+// be transitively closed. Timetable stops are graph vertices. Labels are reused across queries,
+// so one object answers one query at a time.
+class Raptor {
+public:
+    Raptor(TimetablePtr timetable, IGraphPtr footpaths, size_t max_rides = 8);
+
+    // Earliest arrival, using the fewest rides among the earliest journeys.
+    TransitJourney Query(size_t from, size_t to, int64_t departure);
+
+private:
+    enum class LabelKind : uint8_t {
+        Carried,
+        Source,
+        Ride,
+        Walk,
+    };
+
+    // Walk: parent is the previous vertex. Ride: parent is the boarding position on the route.
+    struct Label {
+        int64_t arrival = kInf;
+        size_t parent = kNoState;
+        uint32_t route = 0;
+        uint32_t trip = 0;
+        LabelKind kind = LabelKind::Carried;
+    };
+
+    TimetablePtr timetable_;
+    IGraphPtr footpaths_;
+    size_t max_rides_;
+    size_t vertex_count_;
+    size_t used_rounds_ = 0;
+    DynamicArray<Label> labels_;
+    DynamicArray<int64_t> best_;
+    DynamicArray<bool> marked_;
+    DynamicArray<uint32_t> route_start_;
+    ArraySequence<size_t> marked_stops_;
+    ArraySequence<size_t> queued_routes_;
+    SearchWorkspace walk_;
+
+    Label& At(size_t round, size_t vertex);
+
+    void Walk(size_t round, size_t target);
+
+    void ScanRoutes(size_t round, size_t target);
+
+    TransitJourney Reconstruct(size_t round, size_t to) const;
+};
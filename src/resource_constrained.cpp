@@ -0,0 +1,201 @@
+#include "resource_constrained.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "transport_state.hpp"
+
+constexpr uint32_t kNoLabel = std::numeric_limits<uint32_t>::max();
+
+EdgeResources::EdgeResources(size_t resource_count) : resource_count_(resource_count) {
+}
+
+size_t EdgeResources::GetResourceCount() const {
+    return resource_count_;
+}
+
+void EdgeResources::Set(size_t edge_id, size_t resource, int64_t amount) {
+    if (resource >= resource_count_) {
+        throw std::out_of_range("Resource is out of range");
+    }
+    if (amount < 0) {
+        throw std::invalid_argument("Resource consumption must be non-negative");
+    }
+    while (amounts_.GetLength() < (edge_id + 1) * resource_count_) {
+        amounts_.Append(0);
+    }
+    amounts_.Set(amount, edge_id * resource_count_ + resource);
+}
+
+int64_t EdgeResources::Get(size_t edge_id, size_t resource) const {
+    const size_t index = edge_id * resource_count_ + resource;
+    return index < amounts_.GetLength() ? amounts_.Get(index) : 0;
+}
+
+ResourceConstrainedShortestPaths::ResourceConstrainedShortestPaths(IGraphPtr graph, EdgeResourcesPtr resources)
+    : graph_(std::move(graph)),
+      resources_(std::move(resources)),
+      resource_count_(resources_->GetResourceCount()),
+      bags_(GetStateCount(graph_->GetVertexCount()), kNoLabel),
+      candidate_(resource_count_, 0) {
+    if (GetStateCount(graph_->GetVertexCount()) >= kNoLabel) {
+        throw std::out_of_range("Too many vertices for the resource-constrained search");
+    }
+}
+
+void ResourceConstrainedShortestPaths::Reset() {
+    for (uint32_t state : touched_) {
+        bags_.Set(kNoLabel, state);
+    }
+    touched_.Clear();
+    labels_.Clear();
+    pool_.Clear();
+    queue_.Clear();
+}
+
+bool ResourceConstrainedShortestPaths::Dominates(uint32_t label, int64_t cost, const int64_t* resources) const {
+    if (labels_.Get(label).cost > cost) {
+        return false;
+    }
+    const int64_t* own = pool_.begin() + label * resource_count_;
+    for (size_t r = 0; r < resource_count_; ++r) {
+        if (own[r] > resources[r]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The candidate resources are in candidate_.
+void ResourceConstrainedShortestPaths::TryAdd(int64_t cost, size_t state, uint32_t parent) {
+    const int64_t* resources = candidate_.begin();
+    uint32_t* head = bags_.GetBegin() + state;
+    for (uint32_t i = *head; i != kNoLabel; i = labels_.Get(i).next) {
+        if (Dominates(i, cost, resources)) {
+            return;
+        }
+    }
+    for (uint32_t* link = head; *link != kNoLabel;) {
+        Label& other = labels_.begin()[*link];
+        bool dominated = cost <= other.cost;
+        const int64_t* own = pool_.begin() + *link * resource_count_;
+        for (size_t r = 0; dominated && r < resource_count_; ++r) {
+            dominated = resources[r] <= own[r];
+        }
+        if (dominated) {
+            other.dominated = true;
+            *link = other.next;
+        } else {
+            link = &other.next;
+        }
+    }
+    if (labels_.GetLength() >= kNoLabel) {
+        throw std::length_error("Resource-constrained label pool overflow");
+    }
+    if (*head == kNoLabel) {
+        touched_.Append(static_cast<uint32_t>(state));
+    }
+    const uint32_t index = static_cast<uint32_t>(labels_.GetLength());
+    labels_.Append({cost, static_cast<uint32_t>(state), parent, *head, false});
+    for (size_t r = 0; r < resource_count_; ++r) {
+        pool_.Append(resources[r]);
+    }
+    *head = index;
+    queue_.Append(index);
+}
+
+ResourcePath ResourceConstrainedShortestPaths::Find(size_t from, size_t to, const Sequence<int64_t>& limits) {
+    if (from >= graph_->GetVertexCount() || to >= graph_->GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    if (limits.GetLength() != resource_count_) {
+        throw std::invalid_argument("Expected one limit per resource");
+    }
+    const ArraySequence<int64_t> limit(limits);
+    for (int64_t value : limit) {
+        if (value < 0) {
+            throw std::invalid_argument("Resource limits must be non-negative");
+        }
+    }
+    Reset();
+    for (size_t r = 0; r < resource_count_; ++r) {
+        candidate_.Set(0, r);
+    }
+    TryAdd(0, EncodeState(from, kSourceTransport), kNoLabel);
+
+    uint32_t best = kNoLabel;
+    for (size_t head = 0; head < queue_.GetLength(); ++head) {
+        const uint32_t index = queue_.Get(head);
+        const Label current = labels_.Get(index);
+        if (current.dominated || (best != kNoLabel && current.cost >= labels_.Get(best).cost)) {
+            continue;
+        }
+        const size_t vertex_id = DecodeVertex(current.state);
+        if (vertex_id == to) {
+            best = index;
+            continue;
+        }
+        const Transport current_transport = DecodeTransport(current.state);
+
+        // Arcs pass their edge id to charge resources; transfers are free of them.
+        auto extend = [&](size_t to_state, int64_t delta_cost, size_t edge_id, bool is_arc) {
+            if (delta_cost < 0) {
+                throw std::invalid_argument("Resource-constrained search does not support negative edge weights");
+            }
+            AccumulatedPath cost;
+            if (!AccumulatedPath{current.cost}.Combine(delta_cost, cost) ||
+                (best != kNoLabel && cost.total_cost >= labels_.Get(best).cost)) {
+                return;
+            }
+            const int64_t* own = pool_.begin() + index * resource_count_;
+            for (size_t r = 0; r < resource_count_; ++r) {
+                const int64_t amount = is_arc ? resources_->Get(edge_id, r) : 0;
+                if (amount > limit.Get(r) - own[r]) {
+                    return;
+                }
+                candidate_.Set(own[r] + amount, r);
+            }
+            TryAdd(cost.total_cost, to_state, index);
+        };
+
+        VertexPtr vertex = graph_->GetVertex(vertex_id);
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (next_transport != current_transport && step_cost < kNoTransferCost) {
+                extend(EncodeState(vertex_id, next_transport), step_cost, 0, false);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (arc.Allows(current_transport)) {
+                extend(EncodeState(arc.vertex->id, current_transport), arc.GetWeight(current_transport), arc.edge_id,
+                       true);
+            }
+        }
+    }
+
+    ResourcePath res;
+    if (best == kNoLabel) {
+        return res;
+    }
+    res.cost = labels_.Get(best).cost;
+    for (size_t r = 0; r < resource_count_; ++r) {
+        res.resources.Append(pool_.Get(best * resource_count_ + r));
+    }
+    size_t length = 0;
+    for (uint32_t i = best; i != kNoLabel; i = labels_.Get(i).parent) {
+        ++length;
+    }
+    auto steps = std::make_shared<ArraySequence<PathStep>>(length);
+    for (uint32_t i = best; i != kNoLabel; i = labels_.Get(i).parent) {
+        const Label& label = labels_.Get(i);
+        const bool is_transfer =
+            label.parent != kNoLabel && DecodeVertex(labels_.Get(label.parent).state) == DecodeVertex(label.state);
+        steps->Set({DecodeVertex(label.state), DecodeTransport(label.state), is_transfer}, --length);
+    }
+    res.steps = steps;
+    return res;
+}
+
+size_t ResourceConstrainedShortestPaths::GetLabelCount() const {
+    return labels_.GetLength();
+}
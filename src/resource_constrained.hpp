@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "ishortest_paths.hpp"
+#include "transport_state.hpp"
+
+// Consumption of constrained resources (distance, tolls, ...) per edge id. Edges without an entry
+// consume nothing. Transfers never consume resources.
+class EdgeResources {
+public:
+    explicit EdgeResources(size_t resource_count);
+
+    size_t GetResourceCount() const;
+
+    // Amounts must be non-negative.
+    void Set(size_t edge_id, size_t resource, int64_t amount);
+
+    int64_t Get(size_t edge_id, size_t resource) const;
+
+private:
+    size_t resource_count_;
+    ArraySequence<int64_t> amounts_;
+};
+
+using EdgeResourcesPtr = std::shared_ptr<const EdgeResources>;
+
+struct ResourcePath {
+    int64_t cost = kInf;
+    ArraySequence<int64_t> resources;
+    // nullptr if no path fits the limits.
+    PathSteps steps;
+};
+
+// Cheapest path over (vertex, transport) states whose total consumption stays within per-resource
+// limits. Label-correcting with a FIFO queue: every state keeps a bag of non-dominated labels over
+// (cost, resources...), and labels not cheaper than the best path found so far are pruned.
+// Resource vectors live in one flat pool next to the labels, so creating a label never allocates
+// on its own; pools are reused across queries, so one object answers one query at a time.
+class ResourceConstrainedShortestPaths {
+public:
+    ResourceConstrainedShortestPaths(IGraphPtr graph, EdgeResourcesPtr resources);
+
+    ResourcePath Find(size_t from, size_t to, const Sequence<int64_t>& limits);
+
+    // Labels created by the last query.
+    size_t GetLabelCount() const;
+
+private:
+    // Resources of label i are pool_[i * resource_count, (i + 1) * resource_count).
+    struct Label {
+        int64_t cost;
+        uint32_t state;
+        uint32_t parent;
+        uint32_t next;
+        bool dominated;
+    };
+
+    IGraphPtr graph_;
+    EdgeResourcesPtr resources_;
+    size_t resource_count_;
+    ArraySequence<Label> labels_;
+    ArraySequence<int64_t> pool_;
+    DynamicArray<uint32_t> bags_;
+    ArraySequence<uint32_t> touched_;
+    ArraySequence<uint32_t> queue_;
+    ArraySequence<int64_t> candidate_;
+
+    void Reset();
+
+    bool Dominates(uint32_t label, int64_t cost, const int64_t* resources) const;
+
+    void TryAdd(int64_t cost, size_t state, uint32_t parent);
+};
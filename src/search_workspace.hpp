@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "binary_heap.hpp"
+#include "state_table.hpp"
+
+struct StateQueueEntry {
+    int64_t distance;
+    size_t state;
+
+    bool operator<(const StateQueueEntry& other) const {
+        return distance < other.distance;
+    }
+};
+
+// Scratch memory of one label-setting search. Keep one per thread and Reset() it between
+// queries: nothing is reallocated once the table and the queue have grown to the working size.
+struct SearchWorkspace {
+    StateTable labels;
+    BinaryHeap<StateQueueEntry> queue;
+
+    void Reset() {
+        labels.Clear();
+        queue.Clear();
+    }
+};
@@ -0,0 +1,156 @@
+#include "shortest_path_tree.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "transport_state.hpp"
+
+ShortestPathTree::ShortestPathTree(
+    const ArraySequence<size_t>& prev, const ArraySequence<size_t>& target_states, size_t root)
+    : root_(root),
+      state_count_(prev.GetLength()),
+      child_offsets_(state_count_ + 1, 0),
+      enter_(state_count_, kNoState),
+      subtree_size_(state_count_, 0),
+      target_states_(target_states),
+      is_target_(state_count_, false) {
+    if (root_ >= state_count_) {
+        throw std::out_of_range("Root state is out of range");
+    }
+    size_t* offsets = child_offsets_.GetBegin();
+    for (size_t parent : prev) {
+        if (parent != kNoState) {
+            ++offsets[parent + 1];
+        }
+    }
+    for (size_t s = 0; s < state_count_; ++s) {
+        offsets[s + 1] += offsets[s];
+    }
+    children_ = DynamicArray<size_t>(offsets[state_count_]);
+    DynamicArray<size_t> cursor(offsets, state_count_);
+    for (size_t s = 0; s < state_count_; ++s) {
+        const size_t parent = prev.Get(s);
+        if (parent != kNoState) {
+            children_.GetBegin()[cursor.GetBegin()[parent]++] = s;
+        }
+    }
+
+    // Iterative DFS from the root; states hanging off unreachable parents are never visited.
+    ArraySequence<size_t> order;
+    ArraySequence<size_t> stack;
+    stack.Append(root_);
+    while (stack.GetLength() != 0) {
+        const size_t state = stack.GetLast();
+        stack.EraseAt(stack.GetLength() - 1);
+        enter_.Set(order.GetLength(), state);
+        order.Append(state);
+        const std::span<const size_t> kids = GetChildren(state);
+        for (size_t i = kids.size(); i > 0; --i) {
+            stack.Append(kids[i - 1]);
+        }
+    }
+    preorder_ = DynamicArray<size_t>(order.begin(), order.GetLength());
+
+    for (size_t i = order.GetLength(); i > 0; --i) {
+        const size_t state = order.Get(i - 1);
+        size_t& size = subtree_size_.GetBegin()[state];
+        size += 1;
+        if (state != root_) {
+            subtree_size_.GetBegin()[prev.Get(state)] += size;
+        }
+    }
+
+    for (size_t state : target_states_) {
+        if (state != kNoState) {
+            is_target_.Set(true, state);
+        }
+    }
+}
+
+size_t ShortestPathTree::GetRoot() const {
+    return root_;
+}
+
+size_t ShortestPathTree::GetStateCount() const {
+    return preorder_.GetSize();
+}
+
+bool ShortestPathTree::Contains(size_t state) const {
+    return state < state_count_ && enter_.Get(state) != kNoState;
+}
+
+std::span<const size_t> ShortestPathTree::GetChildren(size_t state) const {
+    if (state >= state_count_) {
+        throw std::out_of_range("State is out of range: " + std::to_string(state));
+    }
+    const size_t* offsets = child_offsets_.GetBegin();
+    return {children_.GetBegin() + offsets[state], children_.GetBegin() + offsets[state + 1]};
+}
+
+size_t ShortestPathTree::GetSubtreeSize(size_t state) const {
+    CheckState(state);
+    return subtree_size_.Get(state);
+}
+
+size_t ShortestPathTree::GetEnter(size_t state) const {
+    CheckState(state);
+    return enter_.Get(state);
+}
+
+size_t ShortestPathTree::GetExit(size_t state) const {
+    CheckState(state);
+    return enter_.Get(state) + subtree_size_.Get(state);
+}
+
+bool ShortestPathTree::IsInSubtree(size_t ancestor, size_t state) const {
+    if (!Contains(ancestor) || !Contains(state)) {
+        return false;
+    }
+    return GetEnter(ancestor) <= GetEnter(state) && GetEnter(state) < GetExit(ancestor);
+}
+
+std::span<const size_t> ShortestPathTree::GetSubtree(size_t state) const {
+    return {preorder_.GetBegin() + GetEnter(state), preorder_.GetBegin() + GetExit(state)};
+}
+
+bool ShortestPathTree::RoutesThrough(size_t target, size_t via) const {
+    const size_t target_state = target_states_.Get(target);
+    for (Transport transport : kAllTransports) {
+        if (IsInSubtree(EncodeState(via, transport), target_state)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SequencePtr<size_t> ShortestPathTree::GetTargetsThrough(size_t via) const {
+    auto res = std::make_shared<ArraySequence<size_t>>();
+    for (Transport transport : kAllTransports) {
+        const size_t root = EncodeState(via, transport);
+        if (!Contains(root)) {
+            continue;
+        }
+        // A transfer at via nests one of its states under another; visit each subtree once.
+        bool nested = false;
+        for (Transport other : kAllTransports) {
+            if (other != transport && IsInSubtree(EncodeState(via, other), root)) {
+                nested = true;
+            }
+        }
+        if (nested) {
+            continue;
+        }
+        for (size_t state : GetSubtree(root)) {
+            if (is_target_.Get(state)) {
+                res->Append(DecodeVertex(state));
+            }
+        }
+    }
+    return res;
+}
+
+void ShortestPathTree::CheckState(size_t state) const {
+    if (!Contains(state)) {
+        throw std::out_of_range("State is not in the tree: " + std::to_string(state));
+    }
+}
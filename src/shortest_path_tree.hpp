@@ -0,0 +1,57 @@
+#pragma once
+
+#include <span>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "ishortest_paths.hpp"
+
+// Shortest-path tree over (vertex, transport) states in CSR form.
+// Children of state s are GetChildren(s). States are numbered in DFS preorder, so the subtree of s
+// is the contiguous range GetSubtree(s) and ancestor checks are two comparisons.
+// States not reachable from the root are not part of the tree.
+class ShortestPathTree {
+public:
+    // prev[s] is the parent state of s or kNoState. target_states[v] is the state a path to
+    // vertex v ends in, or kNoState if v is unreachable.
+    ShortestPathTree(const ArraySequence<size_t>& prev, const ArraySequence<size_t>& target_states, size_t root);
+
+    size_t GetRoot() const;
+
+    size_t GetStateCount() const;
+
+    bool Contains(size_t state) const;
+
+    std::span<const size_t> GetChildren(size_t state) const;
+
+    size_t GetSubtreeSize(size_t state) const;
+
+    // Euler tour interval: the subtree of s occupies preorder positions [GetEnter(s), GetExit(s)).
+    size_t GetEnter(size_t state) const;
+
+    size_t GetExit(size_t state) const;
+
+    bool IsInSubtree(size_t ancestor, size_t state) const;
+
+    // States of the subtree in preorder, the state itself first.
+    std::span<const size_t> GetSubtree(size_t state) const;
+
+    // Whether the shortest path to target passes through vertex via (endpoints included).
+    bool RoutesThrough(size_t target, size_t via) const;
+
+    // All vertices whose shortest path passes through via, in preorder. O(number of subtree states).
+    SequencePtr<size_t> GetTargetsThrough(size_t via) const;
+
+private:
+    size_t root_;
+    size_t state_count_;
+    DynamicArray<size_t> child_offsets_;
+    DynamicArray<size_t> children_;
+    DynamicArray<size_t> preorder_;
+    DynamicArray<size_t> enter_;
+    DynamicArray<size_t> subtree_size_;
+    ArraySequence<size_t> target_states_;
+    DynamicArray<bool> is_target_;
+
+    void CheckState(size_t state) const;
+};
@@ -5,43 +5,14 @@
 #include "array_sequence.hpp"
 #include "igraph.hpp"
 #include "list_sequence.hpp"
+#include "transport_state.hpp"
 
-const int64_t kInf = 1'000'000'000'000'000'000;
-const size_t kNoState = kInf;
-const Transport kSourceTransport = Transport::Feet;
-
-static size_t EncodeState(size_t vertex, Transport transport) {
-    return vertex * kTransportCount + ToTransportIndex(transport);
-}
-
-static size_t DecodeVertex(size_t state) {
-    return state / kTransportCount;
-}
-
-static Transport DecodeTransport(size_t state) {
-    return static_cast<Transport>(state % kTransportCount);
-}
-
-static size_t GetStateCount(size_t vertex_count) {
-    return vertex_count * kTransportCount;
-}
-
-static bool CombineTransfer(
-    const TransferMatrix& transfer, const AccumulatedPath& current, Transport from_transport, Transport to_transport,
-    AccumulatedPath& combined) {
-    const int64_t step_cost = transfer.GetCost(from_transport, to_transport);
-    if (step_cost >= kNoTransferCost) {
-        return false;
-    }
-    return current.Combine(step_cost, combined);
-}
-
-static size_t FindBestStateAtVertex(const SequencePtr<AccumulatedPath>& dist, size_t vertex) {
+static size_t FindBestStateAtVertex(const ArraySequence<AccumulatedPath>& dist, size_t vertex) {
     size_t best_state = kNoState;
     int64_t best_distance = kInf;
     for (Transport transport : kAllTransports) {
         const size_t state = EncodeState(vertex, transport);
-        const int64_t candidate = dist->Get(state).total_cost;
+        const int64_t candidate = dist.Get(state).total_cost;
         if (candidate < best_distance) {
             best_distance = candidate;
             best_state = state;
@@ -50,20 +21,94 @@ static size_t FindBestStateAtVertex(const SequencePtr<AccumulatedPath>& dist, si
     return best_state;
 }
 
-Dijkstra::Dijkstra(IGraphPtr graph, size_t from)
+StateShortestPaths::StateShortestPaths(const IGraph& graph, size_t from)
     : dist_(std::make_shared<ArraySequence<AccumulatedPath>>(
-          GetStateCount(graph->GetVertexCount()), AccumulatedPath{kInf})),
-      prev_(std::make_shared<ArraySequence<size_t>>(GetStateCount(graph->GetVertexCount()), kNoState)),
+          GetStateCount(graph.GetVertexCount()), AccumulatedPath{kInf})),
+      prev_(std::make_shared<ArraySequence<size_t>>(GetStateCount(graph.GetVertexCount()), kNoState)),
       from_state_(EncodeState(from, kSourceTransport)),
-      vertex_count_(graph->GetVertexCount()) {
+      vertex_count_(graph.GetVertexCount()) {
     if (from >= vertex_count_) {
         throw std::out_of_range("Source vertex is out of range");
     }
-    const size_t state_count = GetStateCount(vertex_count_);
-    auto used = std::make_shared<ArraySequence<bool>>(state_count);
     dist_->Set(AccumulatedPath{0}, from_state_);
+}
+
+int64_t StateShortestPaths::GetDistance(size_t to) const {
+    if (to >= vertex_count_) {
+        throw std::out_of_range("Target vertex is out of range");
+    }
+    const size_t best_state = FindBestStateAtVertex(*dist_, to);
+    return best_state == kNoState ? kInf : dist_->Get(best_state).total_cost;
+}
+
+PathView StateShortestPaths::GetPathView(size_t to) const {
+    if (to >= vertex_count_) {
+        throw std::out_of_range("Target vertex is out of range");
+    }
+    return PathView(prev_->begin(), kNoState, FindBestStateAtVertex(*dist_, to), from_state_);
+}
+
+PathSteps StateShortestPaths::GetShortestPathWithTransfers(size_t to) const {
+    const PathView view = GetPathView(to);
+    if (view.IsEmpty()) {
+        return nullptr;
+    }
+    auto res = std::make_shared<ArraySequence<PathStep>>(view.GetLength());
+    view.FillSteps(res->begin(), res->GetLength());
+    return res;
+}
 
+SequencePtr<size_t> StateShortestPaths::GetShortestPath(size_t to) const {
+    const PathView view = GetPathView(to);
+    if (view.IsEmpty()) {
+        return nullptr;
+    }
+    auto res = std::make_shared<ArraySequence<size_t>>(view.GetVertexCount());
+    view.FillVertices(res->begin(), res->GetLength());
+    return res;
+}
+
+ShortestPathTree StateShortestPaths::GetShortestPathTree() const {
+    ArraySequence<size_t> target_states(vertex_count_);
+    for (size_t v = 0; v < vertex_count_; ++v) {
+        target_states.Set(FindBestStateAtVertex(*dist_, v), v);
+    }
+    return ShortestPathTree(*prev_, target_states, from_state_);
+}
+
+size_t StateShortestPaths::GetMemoryUsage() const {
+    return sizeof(*this) + dist_->GetCapacity() * sizeof(AccumulatedPath) + prev_->GetCapacity() * sizeof(size_t);
+}
+
+const SolverStats& StateShortestPaths::GetStats() const {
+    return stats_;
+}
+
+StopReason StateShortestPaths::GetStopReason() const {
+    return stop_reason_;
+}
+
+bool StateShortestPaths::IsComplete() const {
+    return stop_reason_ == StopReason::None;
+}
+
+Dijkstra::Dijkstra(IGraphPtr graph, size_t from, const CancellationToken& cancel) : StateShortestPaths(*graph, from) {
+    const size_t state_count = GetStateCount(vertex_count_);
+    std::shared_ptr<ArraySequence<bool>> used;
+    {
+        PhaseTimer timer(stats_, SolverPhase::Setup);
+        used = std::make_shared<ArraySequence<bool>>(state_count);
+        TrackPeakMemory(stats_, GetMemoryUsage() + used->GetCapacity() * sizeof(bool));
+    }
+
+    PhaseTimer timer(stats_, SolverPhase::Search);
+    StopPoller poller(cancel);
     for (size_t iteration = 0; iteration < state_count; ++iteration) {
+        // Every iteration scans all states.
+        if (poller.ShouldStop(state_count)) {
+            stop_reason_ = poller.GetReason();
+            break;
+        }
         size_t state = kNoState;
         int64_t best_distance = kInf;
         for (size_t s = 0; s < state_count; ++s) {
@@ -76,6 +121,8 @@ Dijkstra::Dijkstra(IGraphPtr graph, size_t from)
             break;
         }
         used->Set(true, state);
+        CountStat(stats_.settled_states);
+        CountStat(stats_.queue_pops);
 
         const AccumulatedPath current = dist_->Get(state);
         const size_t vertex_id = DecodeVertex(state);
@@ -88,24 +135,30 @@ Dijkstra::Dijkstra(IGraphPtr graph, size_t from)
             if (!CombineTransfer(vertex->transfer, current, current_transport, next_transport, candidate)) {
                 continue;
             }
+            CountStat(stats_.transfer_relaxations);
             if (candidate.total_cost < best_distance) {
                 throw std::invalid_argument("Dijkstra does not support negative edge weights");
             }
             if (candidate.total_cost < dist_->Get(to_state).total_cost) {
                 dist_->Set(candidate, to_state);
                 prev_->Set(state, to_state);
+                CountStat(stats_.successful_relaxations);
             }
         }
 
-        for (auto it = vertex->arcs->GetIterator(); it->HasNext(); it->Next()) {
-            const Arc arc = it->GetCurrentItem();
+        const TransportMask mode = TransportBit(current_transport);
+        for (const Arc& arc : *vertex->arcs) {
             if (arc.vertex == nullptr) {
                 throw std::runtime_error("Graph contains null adjacent vertex");
             }
+            if ((arc.modes.mask & mode) == 0) {
+                continue;
+            }
+            CountStat(stats_.relaxed_arcs);
             const size_t to_vertex = arc.vertex->id;
             const size_t to_state = EncodeState(to_vertex, current_transport);
             AccumulatedPath candidate;
-            if (!current.Combine(arc.weight, candidate)) {
+            if (!current.Combine(arc.GetWeight(current_transport), candidate)) {
                 continue;
             }
             if (candidate.total_cost < best_distance) {
@@ -114,77 +167,26 @@ Dijkstra::Dijkstra(IGraphPtr graph, size_t from)
             if (candidate.total_cost < dist_->Get(to_state).total_cost) {
                 dist_->Set(candidate, to_state);
                 prev_->Set(state, to_state);
+                CountStat(stats_.successful_relaxations);
             }
         }
     }
 }
 
-int64_t Dijkstra::GetDistance(size_t to) const {
-    if (to >= vertex_count_) {
-        throw std::out_of_range("Target vertex is out of range");
-    }
-    const size_t best_state = FindBestStateAtVertex(dist_, to);
-    return best_state == kNoState ? kInf : dist_->Get(best_state).total_cost;
-}
-
-PathSteps Dijkstra::GetShortestPathWithTransfers(size_t to) const {
-    if (to >= vertex_count_) {
-        throw std::out_of_range("Target vertex is out of range");
-    }
-    const size_t best_state = FindBestStateAtVertex(dist_, to);
-    if (best_state == kNoState || dist_->Get(best_state).total_cost == kInf) {
-        return nullptr;
-    }
-
-    auto res = std::make_shared<ListSequence<PathStep>>();
-    bool reached_source = false;
-    for (size_t state = best_state; state != kNoState; state = prev_->Get(state)) {
-        const size_t prev_state = prev_->Get(state);
-        const bool is_transfer = prev_state != kNoState && DecodeVertex(prev_state) == DecodeVertex(state) &&
-                                 DecodeTransport(prev_state) != DecodeTransport(state);
-        res->Prepend({DecodeVertex(state), DecodeTransport(state), is_transfer});
-        if (state == from_state_) {
-            reached_source = true;
-            break;
-        }
-    }
-    if (!reached_source) {
-        return nullptr;
-    }
-    return res;
-}
-
-SequencePtr<size_t> Dijkstra::GetShortestPath(size_t to) const {
-    PathSteps detailed = GetShortestPathWithTransfers(to);
-    if (detailed == nullptr) {
-        return nullptr;
-    }
-
-    auto res = std::make_shared<ListSequence<size_t>>();
-    for (auto it = detailed->GetIterator(); it->HasNext(); it->Next()) {
-        const size_t vertex = it->GetCurrentItem().vertex;
-        if (res->GetLength() == 0 || res->GetLast() != vertex) {
-            res->Append(vertex);
-        }
-    }
-    return res;
-}
-
-FordBellman::FordBellman(IGraphPtr graph, size_t from)
-    : dist_(std::make_shared<ArraySequence<AccumulatedPath>>(
-          GetStateCount(graph->GetVertexCount()), AccumulatedPath{kInf})),
-      prev_(std::make_shared<ArraySequence<size_t>>(GetStateCount(graph->GetVertexCount()), kNoState)),
-      from_state_(EncodeState(from, kSourceTransport)),
-      vertex_count_(graph->GetVertexCount()) {
-    if (from >= vertex_count_) {
-        throw std::out_of_range("Source vertex is out of range");
-    }
-
+FordBellman::FordBellman(IGraphPtr graph, size_t from, const CancellationToken& cancel)
+    : StateShortestPaths(*graph, from) {
     const size_t state_count = GetStateCount(vertex_count_);
-    dist_->Set(AccumulatedPath{0}, from_state_);
-    for (size_t iteration = 0; iteration + 1 < state_count; ++iteration) {
+    TrackPeakMemory(stats_, GetMemoryUsage());
+    PhaseTimer timer(stats_, SolverPhase::Search);
+    StopPoller poller(cancel);
+    for (size_t iteration = 0; iteration + 1 < state_count && stop_reason_ == StopReason::None; ++iteration) {
+        CountStat(stats_.bellman_ford_passes);
         bool updated = false;
         for (size_t state = 0; state < state_count; ++state) {
+            if (poller.ShouldStop()) {
+                stop_reason_ = poller.GetReason();
+                break;
+            }
             const AccumulatedPath current = dist_->Get(state);
             if (current.total_cost == kInf) {
                 continue;
@@ -200,27 +202,34 @@ FordBellman::FordBellman(IGraphPtr graph, size_t from)
                 if (!CombineTransfer(vertex->transfer, current, current_transport, next_transport, candidate)) {
                     continue;
                 }
+                CountStat(stats_.transfer_relaxations);
                 if (candidate.total_cost < dist_->Get(to_state).total_cost) {
                     dist_->Set(candidate, to_state);
                     prev_->Set(state, to_state);
+                    CountStat(stats_.successful_relaxations);
                     updated = true;
                 }
             }
 
-            for (auto it = vertex->arcs->GetIterator(); it->HasNext(); it->Next()) {
-                const Arc arc = it->GetCurrentItem();
+            const TransportMask mode = TransportBit(current_transport);
+            for (const Arc& arc : *vertex->arcs) {
                 if (arc.vertex == nullptr) {
                     throw std::runtime_error("Graph contains null adjacent vertex");
                 }
+                if ((arc.modes.mask & mode) == 0) {
+                    continue;
+                }
+                CountStat(stats_.relaxed_arcs);
                 const size_t to_vertex = arc.vertex->id;
                 const size_t to_state = EncodeState(to_vertex, current_transport);
                 AccumulatedPath candidate;
-                if (!current.Combine(arc.weight, candidate)) {
+                if (!current.Combine(arc.GetWeight(current_transport), candidate)) {
                     continue;
                 }
                 if (candidate.total_cost < dist_->Get(to_state).total_cost) {
                     dist_->Set(candidate, to_state);
                     prev_->Set(state, to_state);
+                    CountStat(stats_.successful_relaxations);
                     updated = true;
                 }
             }
@@ -230,54 +239,3 @@ FordBellman::FordBellman(IGraphPtr graph, size_t from)
         }
     }
 }
-
-int64_t FordBellman::GetDistance(size_t to) const {
-    if (to >= vertex_count_) {
-        throw std::out_of_range("Target vertex is out of range");
-    }
-    const size_t best_state = FindBestStateAtVertex(dist_, to);
-    return best_state == kNoState ? kInf : dist_->Get(best_state).total_cost;
-}
-
-PathSteps FordBellman::GetShortestPathWithTransfers(size_t to) const {
-    if (to >= vertex_count_) {
-        throw std::out_of_range("Target vertex is out of range");
-    }
-    const size_t best_state = FindBestStateAtVertex(dist_, to);
-    if (best_state == kNoState || dist_->Get(best_state).total_cost == kInf) {
-        return nullptr;
-    }
-
-    auto res = std::make_shared<ListSequence<PathStep>>();
-    bool reached_source = false;
-    for (size_t state = best_state; state != kNoState; state = prev_->Get(state)) {
-        const size_t prev_state = prev_->Get(state);
-        const bool is_transfer = prev_state != kNoState && DecodeVertex(prev_state) == DecodeVertex(state) &&
-                                 DecodeTransport(prev_state) != DecodeTransport(state);
-        res->Prepend({DecodeVertex(state), DecodeTransport(state), is_transfer});
-        if (state == from_state_) {
-            reached_source = true;
-            break;
-        }
-    }
-    if (!reached_source) {
-        return nullptr;
-    }
-    return res;
-}
-
-SequencePtr<size_t> FordBellman::GetShortestPath(size_t to) const {
-    PathSteps detailed = GetShortestPathWithTransfers(to);
-    if (detailed == nullptr) {
-        return nullptr;
-    }
-
-    auto res = std::make_shared<ListSequence<size_t>>();
-    for (auto it = detailed->GetIterator(); it->HasNext(); it->Next()) {
-        const size_t vertex = it->GetCurrentItem().vertex;
-        if (res->GetLength() == 0 || res->GetLast() != vertex) {
-            res->Append(vertex);
-        }
-    }
-    return res;
-}
@@ -1,37 +1,58 @@
 #pragma once
 
+#include "array_sequence.hpp"
+#include "cancellation.hpp"
 #include "ishortest_paths.hpp"
+#include "path_view.hpp"
+#include "shortest_path_tree.hpp"
+#include "solver_stats.hpp"
 
-class Dijkstra : public IShortestPathsFinder {
+// Result storage shared by the solvers over (vertex, transport) states.
+class StateShortestPaths : public IShortestPathsFinder {
 public:
-    Dijkstra(IGraphPtr graph, size_t from);
-
     int64_t GetDistance(size_t to) const override;
 
     SequencePtr<size_t> GetShortestPath(size_t to) const override;
 
     PathSteps GetShortestPathWithTransfers(size_t to) const override;
 
-private:
-    SequencePtr<AccumulatedPath> dist_;
-    SequencePtr<size_t> prev_;
-    size_t from_state_;
-    size_t vertex_count_;
-};
+    // Allocation-free access to the path; see PathView.
+    PathView GetPathView(size_t to) const;
 
-class FordBellman : public IShortestPathsFinder {
-public:
-    FordBellman(IGraphPtr graph, size_t from);
+    // Exports the current predecessor tree with subtree and Euler tour indices.
+    ShortestPathTree GetShortestPathTree() const;
 
-    int64_t GetDistance(size_t to) const override;
+    // Bytes held by the distance and predecessor arrays.
+    size_t GetMemoryUsage() const;
 
-    SequencePtr<size_t> GetShortestPath(size_t to) const override;
+    // Counters of the last solve; all zero unless built with LAB3_SOLVER_STATS.
+    const SolverStats& GetStats() const;
 
-    PathSteps GetShortestPathWithTransfers(size_t to) const override;
+    // Why the solve stopped early, None if it finished. A stopped solve keeps its work: distances are
+    // upper bounds and paths are real paths, exact only for the states settled before the stop.
+    StopReason GetStopReason() const;
 
-private:
-    SequencePtr<AccumulatedPath> dist_;
-    SequencePtr<size_t> prev_;
+    bool IsComplete() const;
+
+protected:
+    StateShortestPaths(const IGraph& graph, size_t from);
+
+    std::shared_ptr<ArraySequence<AccumulatedPath>> dist_;
+    std::shared_ptr<ArraySequence<size_t>> prev_;
     size_t from_state_;
     size_t vertex_count_;
+    SolverStats stats_;
+    StopReason stop_reason_ = StopReason::None;
+};
+
+// Both solvers poll `cancel` from their main loops and stop within kStopPollInterval steps of it
+// firing, see GetStopReason.
+class Dijkstra : public StateShortestPaths {
+public:
+    Dijkstra(IGraphPtr graph, size_t from, const CancellationToken& cancel = {});
+};
+
+class FordBellman : public StateShortestPaths {
+public:
+    FordBellman(IGraphPtr graph, size_t from, const CancellationToken& cancel = {});
 };
@@ -0,0 +1,103 @@
+#include "shortest_paths_cache.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+std::shared_ptr<StateShortestPaths> MakeFinder(Algorithm algorithm, IGraphPtr graph, size_t from,
+                                               const CancellationToken& cancel) {
+    switch (algorithm) {
+        case Algorithm::Dijkstra:
+            return std::make_shared<Dijkstra>(std::move(graph), from, cancel);
+        case Algorithm::FordBellman:
+            return std::make_shared<FordBellman>(std::move(graph), from, cancel);
+    }
+    throw std::invalid_argument("Unknown algorithm");
+}
+
+size_t ShortestPathsCache::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<size_t>()(key.from);
+    hash = hash * 31 + std::hash<uint64_t>()(key.version);
+    return hash * 31 + static_cast<size_t>(key.algorithm);
+}
+
+ShortestPathsCache::ShortestPathsCache(IGraphPtr graph, size_t capacity_bytes)
+    : graph_(std::move(graph)), version_(graph_->GetVersion()) {
+    stats_.capacity_bytes = capacity_bytes;
+}
+
+std::shared_ptr<StateShortestPaths> ShortestPathsCache::Get(size_t from, Algorithm algorithm,
+                                                        const CancellationToken& cancel) {
+    const uint64_t version = graph_->GetVersion();
+    const Key key{from, version, algorithm};
+    {
+        std::lock_guard lock(mutex_);
+        DropStaleLocked(version);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            ++stats_.hits;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->finder;
+        }
+        ++stats_.misses;
+    }
+
+    std::shared_ptr<StateShortestPaths> finder = MakeFinder(algorithm, graph_, from, cancel);
+    const size_t bytes = finder->GetMemoryUsage();
+
+    std::lock_guard lock(mutex_);
+    // Another thread may have solved the same key or the graph may have moved on meanwhile.
+    if (!finder->IsComplete() || bytes > stats_.capacity_bytes || version != version_ || index_.contains(key)) {
+        return finder;
+    }
+    entries_.push_front({key, finder, bytes});
+    index_.emplace(key, entries_.begin());
+    stats_.bytes += bytes;
+    ++stats_.entries;
+    EvictLocked();
+    return finder;
+}
+
+int64_t ShortestPathsCache::GetDistance(size_t from, size_t to, Algorithm algorithm) {
+    return Get(from, algorithm)->GetDistance(to);
+}
+
+SequencePtr<size_t> ShortestPathsCache::GetShortestPath(size_t from, size_t to, Algorithm algorithm) {
+    return Get(from, algorithm)->GetShortestPath(to);
+}
+
+void ShortestPathsCache::Clear() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+CacheStats ShortestPathsCache::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void ShortestPathsCache::DropStaleLocked(uint64_t version) {
+    if (version == version_) {
+        return;
+    }
+    version_ = version;
+    stats_.invalidations += entries_.size();
+    entries_.clear();
+    index_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+void ShortestPathsCache::EvictLocked() {
+    while (stats_.bytes > stats_.capacity_bytes && !entries_.empty()) {
+        const Entry& victim = entries_.back();
+        stats_.bytes -= victim.bytes;
+        --stats_.entries;
+        ++stats_.evictions;
+        index_.erase(victim.key);
+        entries_.pop_back();
+    }
+}
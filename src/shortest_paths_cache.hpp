@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "shortest_paths.hpp"
+
+enum class Algorithm : uint8_t {
+    Dijkstra = 0,
+    FordBellman = 1,
+};
+
+std::shared_ptr<StateShortestPaths> MakeFinder(Algorithm algorithm, IGraphPtr graph, size_t from,
+                                               const CancellationToken& cancel = {});
+
+struct CacheStats {
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t capacity_bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+
+    double GetHitRate() const {
+        const uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+// Thread-safe LRU cache of solved shortest-path trees keyed by (source, graph version, algorithm).
+// Entries of older graph versions are dropped on the first lookup after the graph changes.
+// A tree larger than the whole capacity is computed and returned but not stored.
+class ShortestPathsCache {
+public:
+    ShortestPathsCache(IGraphPtr graph, size_t capacity_bytes);
+
+    // Returns the cached tree or solves it. Solving happens outside the lock. A solve stopped by
+    // `cancel` is returned (check GetStopReason) but never stored.
+    std::shared_ptr<StateShortestPaths> Get(size_t from, Algorithm algorithm = Algorithm::Dijkstra,
+                                            const CancellationToken& cancel = {});
+
+    int64_t GetDistance(size_t from, size_t to, Algorithm algorithm = Algorithm::Dijkstra);
+
+    SequencePtr<size_t> GetShortestPath(size_t from, size_t to, Algorithm algorithm = Algorithm::Dijkstra);
+
+    void Clear();
+
+    CacheStats GetStats() const;
+
+private:
+    struct Key {
+        size_t from;
+        uint64_t version;
+        Algorithm algorithm;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<StateShortestPaths> finder;
+        size_t bytes;
+    };
+
+    IGraphPtr graph_;
+    mutable std::mutex mutex_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    uint64_t version_;
+    CacheStats stats_;
+
+    void DropStaleLocked(uint64_t version);
+
+    void EvictLocked();
+};
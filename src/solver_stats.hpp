@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Statistics are compiled in only with -DLAB3_SOLVER_STATS=ON (CMake option). Otherwise every
+// counting call below is an empty inline function and no clock is ever read.
+#ifdef LAB3_SOLVER_STATS
+constexpr bool kSolverStatsEnabled = true;
+#else
+constexpr bool kSolverStatsEnabled = false;
+#endif
+
+enum class SolverPhase : uint8_t {
+    Setup = 0,
+    Search = 1,
+    Invalidate = 2,
+};
+
+constexpr size_t kSolverPhaseCount = 3;
+
+struct SolverStats {
+    uint64_t settled_states = 0;
+    // Arcs examined in a transport allowed to use them.
+    uint64_t relaxed_arcs = 0;
+    // Transfers examined, forbidden ones excluded.
+    uint64_t transfer_relaxations = 0;
+    // Arc or transfer relaxations that improved a label.
+    uint64_t successful_relaxations = 0;
+    uint64_t bellman_ford_passes = 0;
+    // The array Dijkstra has no heap and counts one pop per minimum selection.
+    uint64_t queue_pushes = 0;
+    uint64_t queue_pops = 0;
+    size_t peak_memory_bytes = 0;
+    std::array<uint64_t, kSolverPhaseCount> phase_ns{};
+
+    uint64_t GetPhaseNs(SolverPhase phase) const {
+        return phase_ns[static_cast<size_t>(phase)];
+    }
+
+    void Print(std::ostream& out) const {
+        out << "    settled states: " << settled_states << "\n"
+            << "    relaxed arcs: " << relaxed_arcs << "\n"
+            << "    transfer relaxations: " << transfer_relaxations << "\n"
+            << "    successful relaxations: " << successful_relaxations << "\n"
+            << "    bellman-ford passes: " << bellman_ford_passes << "\n"
+            << "    queue pushes/pops: " << queue_pushes << "/" << queue_pops << "\n"
+            << "    peak memory: " << peak_memory_bytes << " bytes\n"
+            << "    setup/search/invalidate: " << GetPhaseNs(SolverPhase::Setup) << "/"
+            << GetPhaseNs(SolverPhase::Search) << "/" << GetPhaseNs(SolverPhase::Invalidate) << " ns\n";
+    }
+};
+
+inline void CountStat(uint64_t& counter, uint64_t amount = 1) {
+    if constexpr (kSolverStatsEnabled) {
+        counter += amount;
+    }
+}
+
+inline void TrackPeakMemory(SolverStats& stats, size_t bytes) {
+    if constexpr (kSolverStatsEnabled) {
+        if (bytes > stats.peak_memory_bytes) {
+            stats.peak_memory_bytes = bytes;
+        }
+    }
+}
+
+// Adds the lifetime of the scope to one phase of stats.
+class PhaseTimer {
+public:
+    PhaseTimer(SolverStats& stats, SolverPhase phase) : stats_(stats), phase_(phase) {
+        if constexpr (kSolverStatsEnabled) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    ~PhaseTimer() {
+        if constexpr (kSolverStatsEnabled) {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            stats_.phase_ns[static_cast<size_t>(phase_)] +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+    }
+
+private:
+    SolverStats& stats_;
+    SolverPhase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
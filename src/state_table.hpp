@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+#include "transport_state.hpp"
+
+// Open-addressing map from solver state to its search label. Memory grows with the number of
+// states a search actually reaches, and Clear() costs O(reached) instead of O(all states).
+class StateTable {
+public:
+    struct Entry {
+        size_t state = kNoState;
+        int64_t distance = kInf;
+        size_t parent = kNoState;
+        bool settled = false;
+    };
+
+    StateTable() : StateTable(16) {
+    }
+
+    explicit StateTable(size_t capacity) : slots_(RoundUp(capacity)), mask_(slots_.GetSize() - 1) {
+    }
+
+    size_t GetSize() const {
+        return used_.GetLength();
+    }
+
+    size_t GetCapacity() const {
+        return slots_.GetSize();
+    }
+
+    const Entry* Find(size_t state) const {
+        const Entry* slots = slots_.GetBegin();
+        for (size_t i = Hash(state) & mask_;; i = (i + 1) & mask_) {
+            if (slots[i].state == state) {
+                return &slots[i];
+            }
+            if (slots[i].state == kNoState) {
+                return nullptr;
+            }
+        }
+    }
+
+    Entry* Find(size_t state) {
+        return const_cast<Entry*>(static_cast<const StateTable*>(this)->Find(state));
+    }
+
+    int64_t GetDistance(size_t state) const {
+        const Entry* entry = Find(state);
+        return entry == nullptr ? kInf : entry->distance;
+    }
+
+    // Inserts an unreached entry (distance kInf) if the state is not present yet.
+    Entry& FindOrInsert(size_t state) {
+        if (2 * (used_.GetLength() + 1) > slots_.GetSize()) {
+            Grow();
+        }
+        Entry* slots = slots_.GetBegin();
+        size_t i = Hash(state) & mask_;
+        for (; slots[i].state != kNoState; i = (i + 1) & mask_) {
+            if (slots[i].state == state) {
+                return slots[i];
+            }
+        }
+        slots[i].state = state;
+        used_.Append(i);
+        return slots[i];
+    }
+
+    // Visits entries in insertion order.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t slot : used_) {
+            fn(slots_.Get(slot));
+        }
+    }
+
+    void Clear() {
+        Entry* slots = slots_.GetBegin();
+        for (size_t slot : used_) {
+            slots[slot] = Entry{};
+        }
+        used_.Clear();
+    }
+
+private:
+    DynamicArray<Entry> slots_;
+    size_t mask_;
+    ArraySequence<size_t> used_;
+
+    static size_t RoundUp(size_t capacity) {
+        size_t res = 16;
+        while (res < capacity) {
+            res *= 2;
+        }
+        return res;
+    }
+
+    static size_t Hash(size_t state) {
+        uint64_t h = state * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    void Grow() {
+        DynamicArray<Entry> old = std::move(slots_);
+        ArraySequence<size_t> old_used = used_;
+        slots_ = DynamicArray<Entry>(old.GetSize() * 2);
+        mask_ = slots_.GetSize() - 1;
+        used_.Clear();
+        Entry* slots = slots_.GetBegin();
+        for (size_t slot : old_used) {
+            const Entry& entry = old.Get(slot);
+            size_t i = Hash(entry.state) & mask_;
+            while (slots[i].state != kNoState) {
+                i = (i + 1) & mask_;
+            }
+            slots[i] = entry;
+            used_.Append(i);
+        }
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from one FIFO queue. Unlike ParallelFor the threads outlive a
+// single call, which matters when a server answers many small batches.
+class ThreadPool {
+public:
+    // threads == 0 means std::thread::hardware_concurrency().
+    explicit ThreadPool(size_t threads = 0);
+
+    // Runs the tasks already queued, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const;
+
+    void Post(std::function<void()> task);
+
+    // Runs fn(index) for every index in [0, count) on the workers and the calling thread and returns
+    // when all are done. The first exception stops handing out indices and is rethrown. May be called
+    // from a task on this pool: the caller never waits for helpers that have not started yet.
+    template <typename Fn>
+    void ParallelFor(size_t count, Fn&& fn);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void WorkerLoop();
+};
+
+template <typename Fn>
+void ThreadPool::ParallelFor(size_t count, Fn&& fn) {
+    struct Shared {
+        std::atomic<size_t> next = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t active = 0;
+        bool closed = false;
+    };
+    // Helpers still queued when the caller is done outlive this frame, so they only share the flags.
+    auto shared = std::make_shared<Shared>();
+    auto work = [&] {
+        for (size_t i = shared->next++; i < count; i = shared->next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard lock(shared->mutex);
+                if (shared->error == nullptr) {
+                    shared->error = std::current_exception();
+                }
+                shared->next = count;
+            }
+        }
+    };
+
+    const size_t helpers = count > 1 ? std::min(count - 1, workers_.size()) : 0;
+    for (size_t i = 0; i < helpers; ++i) {
+        Post([shared, &work] {
+            {
+                std::lock_guard lock(shared->mutex);
+                if (shared->closed) {
+                    return;
+                }
+                ++shared->active;
+            }
+            work();
+            std::lock_guard lock(shared->mutex);
+            if (--shared->active == 0) {
+                shared->finished.notify_one();
+            }
+        });
+    }
+    work();
+    // Only helpers that already started are waited for. Waiting for queued ones would deadlock when
+    // the caller is itself a worker and the queue ahead of them is blocked the same way.
+    std::unique_lock lock(shared->mutex);
+    shared->closed = true;
+    shared->finished.wait(lock, [&] { return shared->active == 0; });
+    if (shared->error != nullptr) {
+        std::rethrow_exception(shared->error);
+    }
+}
@@ -0,0 +1,238 @@
+#include "time_dependent.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "transport_state.hpp"
+
+static int64_t FloorDiv(int64_t a, int64_t b) {
+    const int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+void TravelTimeFunctions::Set(size_t edge_id, Transport transport, const Sequence<Breakpoint>& breakpoints) {
+    const size_t count = breakpoints.GetLength();
+    if (count == 0) {
+        throw std::invalid_argument("Travel time function needs at least one breakpoint");
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const Breakpoint& point = breakpoints.Get(i);
+        if (point.duration < 0) {
+            throw std::invalid_argument("Travel time must be non-negative");
+        }
+        if (i > 0) {
+            const Breakpoint& prev = breakpoints.Get(i - 1);
+            if (point.time <= prev.time) {
+                throw std::invalid_argument("Breakpoint times must strictly increase");
+            }
+            if (point.duration - prev.duration < prev.time - point.time) {
+                throw std::invalid_argument("Travel time function violates FIFO");
+            }
+        }
+    }
+
+    Range& range = ranges_[edge_id * kTransportCount + ToTransportIndex(transport)];
+    if (range.count != count) {
+        freed_ += range.count;
+        range = {times_.GetLength(), count};
+        for (size_t i = 0; i < count; ++i) {
+            times_.Append(0);
+            durations_.Append(0);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        times_.Set(breakpoints.Get(i).time, range.offset + i);
+        durations_.Set(breakpoints.Get(i).duration, range.offset + i);
+    }
+    if (freed_ > GetBreakpointCount()) {
+        Compact();
+    }
+}
+
+bool TravelTimeFunctions::Contains(size_t edge_id, Transport transport) const {
+    return Find(edge_id, transport) != nullptr;
+}
+
+const TravelTimeFunctions::Range* TravelTimeFunctions::Find(size_t edge_id, Transport transport) const {
+    const auto it = ranges_.find(edge_id * kTransportCount + ToTransportIndex(transport));
+    return it == ranges_.end() ? nullptr : &it->second;
+}
+
+// Copies the live ranges into fresh pools, dropping freed breakpoints.
+void TravelTimeFunctions::Compact() {
+    ArraySequence<int64_t> times;
+    ArraySequence<int64_t> durations;
+    for (auto& [slot, range] : ranges_) {
+        const size_t offset = times.GetLength();
+        for (size_t i = 0; i < range.count; ++i) {
+            times.Append(times_.Get(range.offset + i));
+            durations.Append(durations_.Get(range.offset + i));
+        }
+        range.offset = offset;
+    }
+    times_ = std::move(times);
+    durations_ = std::move(durations);
+    freed_ = 0;
+}
+
+int64_t TravelTimeFunctions::GetTravelTime(const Arc& arc, Transport transport, int64_t departure) const {
+    const Range* found = Find(arc.edge_id, transport);
+    if (found == nullptr) {
+        return arc.GetWeight(transport);
+    }
+    const Range range = *found;
+    const int64_t* times = times_.begin() + range.offset;
+    const int64_t* durations = durations_.begin() + range.offset;
+    const size_t next = std::upper_bound(times, times + range.count, departure) - times;
+    if (next == 0) {
+        return durations[0];
+    }
+    if (next == range.count) {
+        return durations[range.count - 1];
+    }
+    const int64_t t0 = times[next - 1];
+    const int64_t d0 = durations[next - 1];
+    return d0 + FloorDiv((durations[next] - d0) * (departure - t0), times[next] - t0);
+}
+
+size_t TravelTimeFunctions::GetBreakpointCount() const {
+    return times_.GetLength() - freed_;
+}
+
+size_t TravelTimeFunctions::GetPooledCount() const {
+    return times_.GetLength();
+}
+
+// Labels are absolute arrival times. Stops early when a state of target is settled and returns
+// its arrival, kInf otherwise; target == kNoState explores everything reachable.
+static int64_t SearchEarliestArrival(const IGraph& graph, const TravelTimeFunctions& functions, size_t from,
+                                     size_t target, int64_t departure, SearchWorkspace& workspace) {
+    if (from >= graph.GetVertexCount() || (target != kNoState && target >= graph.GetVertexCount())) {
+        throw std::out_of_range("Vertex is out of range");
+    }
+    workspace.Reset();
+    const size_t from_state = EncodeState(from, kSourceTransport);
+    workspace.labels.FindOrInsert(from_state).distance = departure;
+    workspace.queue.Push({departure, from_state});
+    while (!workspace.queue.IsEmpty()) {
+        const StateQueueEntry top = workspace.queue.Pop();
+        StateTable::Entry& entry = *workspace.labels.Find(top.state);
+        if (entry.settled || top.distance != entry.distance) {
+            continue;
+        }
+        entry.settled = true;
+        const size_t state = top.state;
+        const size_t vertex_id = DecodeVertex(state);
+        if (vertex_id == target) {
+            return top.distance;
+        }
+        const Transport current_transport = DecodeTransport(state);
+
+        auto relax = [&](size_t to_state, int64_t delta_cost) {
+            if (delta_cost < 0) {
+                throw std::invalid_argument("Time-dependent search does not support negative edge weights");
+            }
+            AccumulatedPath candidate;
+            if (!AccumulatedPath{top.distance}.Combine(delta_cost, candidate)) {
+                return;
+            }
+            StateTable::Entry& next = workspace.labels.FindOrInsert(to_state);
+            if (candidate.total_cost < next.distance) {
+                next.distance = candidate.total_cost;
+                next.parent = state;
+                workspace.queue.Push({candidate.total_cost, to_state});
+            }
+        };
+
+        VertexPtr vertex = graph.GetVertex(vertex_id);
+        for (Transport next_transport : kAllTransports) {
+            const int64_t step_cost = vertex->transfer.GetCost(current_transport, next_transport);
+            if (step_cost < kNoTransferCost) {
+                relax(EncodeState(vertex_id, next_transport), step_cost);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            if (!arc.Allows(current_transport)) {
+                continue;
+            }
+            relax(EncodeState(arc.vertex->id, current_transport),
+                  functions.GetTravelTime(arc, current_transport, top.distance));
+        }
+    }
+    return kInf;
+}
+
+int64_t FindEarliestArrival(const IGraph& graph, const TravelTimeFunctions& functions, size_t from, size_t to,
+                            int64_t departure, SearchWorkspace& workspace) {
+    return SearchEarliestArrival(graph, functions, from, to, departure, workspace);
+}
+
+TimeDependentDijkstra::TimeDependentDijkstra(
+    IGraphPtr graph, TravelTimeFunctionsPtr functions, size_t from, int64_t departure)
+    : StateShortestPaths(*graph, from), departure_(departure) {
+    SearchWorkspace workspace;
+    SearchEarliestArrival(*graph, *functions, from, kNoState, departure, workspace);
+    workspace.labels.ForEach([&](const StateTable::Entry& entry) {
+        dist_->Set(AccumulatedPath{entry.distance - departure}, entry.state);
+        prev_->Set(entry.parent, entry.state);
+    });
+}
+
+int64_t TimeDependentDijkstra::GetArrivalTime(size_t to) const {
+    const int64_t distance = GetDistance(to);
+    return distance == kInf ? kInf : departure_ + distance;
+}
+
+ArraySequence<ProfilePoint> FindProfile(const IGraph& graph, const TravelTimeFunctions& functions, size_t from,
+                                        size_t to, int64_t window_begin, int64_t window_end, int64_t resolution) {
+    if (window_begin > window_end) {
+        throw std::invalid_argument("Departure window is empty");
+    }
+    if (resolution <= 0) {
+        throw std::invalid_argument("Profile resolution must be positive");
+    }
+    SearchWorkspace workspace;
+    auto evaluate = [&](int64_t departure) {
+        return ProfilePoint{departure, SearchEarliestArrival(graph, functions, from, to, departure, workspace)};
+    };
+
+    ArraySequence<ProfilePoint> res;
+    res.Append(evaluate(window_begin));
+    if (window_end == window_begin) {
+        return res;
+    }
+    // Appends a point, merging away the previous one when it lies on the segment to the new point.
+    // Every point merged this way was sampled, so the merged segment is still exact at it.
+    auto append = [&](const ProfilePoint& point) {
+        const size_t count = res.GetLength();
+        if (count >= 2) {
+            const ProfilePoint& a = res.Get(count - 2);
+            const ProfilePoint& b = res.Get(count - 1);
+            if (a.arrival != kInf && b.arrival != kInf && point.arrival != kInf &&
+                (b.arrival - a.arrival) * (point.departure - a.departure) ==
+                    (point.arrival - a.arrival) * (b.departure - a.departure)) {
+                res.Set(point, count - 1);
+                return;
+            }
+        }
+        res.Append(point);
+    };
+    // Depth-first over pending right halves, so points come out in departure order. Collinear samples
+    // are no proof of linearity (a kink can hide between them), so only equal ends or the resolution
+    // end the bisection.
+    ArraySequence<ProfilePoint> pending;
+    pending.Append(evaluate(window_end));
+    while (pending.GetLength() != 0) {
+        const ProfilePoint left = res.GetLast();
+        const ProfilePoint right = pending.GetLast();
+        const int64_t span = right.departure - left.departure;
+        if (span <= resolution || left.arrival == right.arrival) {
+            append(right);
+            pending.EraseAt(pending.GetLength() - 1);
+        } else {
+            pending.Append(evaluate(left.departure + span / 2));
+        }
+    }
+    return res;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "array_sequence.hpp"
+#include "search_workspace.hpp"
+#include "shortest_paths.hpp"
+
+struct Breakpoint {
+    int64_t time = 0;
+    int64_t duration = 0;
+};
+
+// Piecewise-linear travel-time functions keyed by (edge id, transport). Breakpoints of all
+// functions share two pooled arrays, times separate from durations so that the binary search only
+// touches the times. Functions are indexed by a hash map, so a few time-dependent arcs on high edge
+// ids cost nothing for the others. Outside its breakpoints a function stays constant. Arcs without a
+// function keep their static weight.
+class TravelTimeFunctions {
+public:
+    // Breakpoint times must strictly increase and durations be non-negative. The function must be
+    // FIFO (departing later never arrives earlier), i.e. every segment has slope >= -1.
+    // Replacing a function with one of a different size frees its old breakpoints; the pools are
+    // compacted once freed ones outnumber live ones, so repeated updates keep storage bounded.
+    void Set(size_t edge_id, Transport transport, const Sequence<Breakpoint>& breakpoints);
+
+    bool Contains(size_t edge_id, Transport transport) const;
+
+    // Travel time along arc in the given transport when departing at `departure`. O(log breakpoints).
+    int64_t GetTravelTime(const Arc& arc, Transport transport, int64_t departure) const;
+
+    // Breakpoints of all current functions.
+    size_t GetBreakpointCount() const;
+
+    // Breakpoints held in the pools, freed ones included; at most twice GetBreakpointCount().
+    size_t GetPooledCount() const;
+
+private:
+    struct Range {
+        size_t offset = 0;
+        size_t count = 0;
+    };
+
+    std::unordered_map<size_t, Range> ranges_;
+    ArraySequence<int64_t> times_;
+    ArraySequence<int64_t> durations_;
+    size_t freed_ = 0;
+
+    const Range* Find(size_t edge_id, Transport transport) const;
+
+    void Compact();
+};
+
+using TravelTimeFunctionsPtr = std::shared_ptr<const TravelTimeFunctions>;
+
+// Earliest arrival at vertex `to` when leaving `from` at `departure`, or kInf if unreachable.
+// Transfer costs are waiting times. The search stops as soon as the target is settled.
+int64_t FindEarliestArrival(const IGraph& graph, const TravelTimeFunctions& functions, size_t from, size_t to,
+                            int64_t departure, SearchWorkspace& workspace);
+
+// Time-dependent Dijkstra from one departure. Distances are travel times (arrival - departure).
+class TimeDependentDijkstra : public StateShortestPaths {
+public:
+    TimeDependentDijkstra(IGraphPtr graph, TravelTimeFunctionsPtr functions, size_t from, int64_t departure);
+
+    // kInf if unreachable.
+    int64_t GetArrivalTime(size_t to) const;
+
+private:
+    int64_t departure_;
+};
+
+struct ProfilePoint {
+    int64_t departure = 0;
+    int64_t arrival = kInf;
+};
+
+// Earliest-arrival profile from `from` to `to` over the departures [window_begin, window_end].
+// Intervals are bisected until both ends arrive at the same time, which FIFO makes exact, or the
+// interval is at most `resolution` long. Consecutive points are then merged while they stay collinear
+// with the sampled points between them. With resolution 1 linear interpolation of the result is exact
+// at every integer departure; a coarser resolution may interpolate across a kink inside its intervals.
+// Costs up to (window length / resolution) searches where the arrival keeps changing.
+ArraySequence<ProfilePoint> FindProfile(const IGraph& graph, const TravelTimeFunctions& functions, size_t from,
+                                        size_t to, int64_t window_begin, int64_t window_end, int64_t resolution = 1);
@@ -0,0 +1,130 @@
+#include "timetable.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+Timetable::Timetable(size_t stop_count, const Sequence<TransitRoute>& routes)
+    : stop_count_(stop_count),
+      route_stop_offsets_(routes.GetLength() + 1, 0),
+      trip_counts_(routes.GetLength(), 0),
+      time_offsets_(routes.GetLength() + 1, 0),
+      stop_route_offsets_(stop_count + 1, 0) {
+    const size_t route_count = routes.GetLength();
+    if (route_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::out_of_range("Too many routes");
+    }
+    for (size_t r = 0; r < route_count; ++r) {
+        const TransitRoute& route = routes.Get(r);
+        const size_t length = route.stops.GetLength();
+        if (length < 2) {
+            throw std::invalid_argument("Route must have at least two stops");
+        }
+        if (route.stop_times.GetLength() % length != 0) {
+            throw std::invalid_argument("Stop times do not match the route length");
+        }
+        for (size_t stop : route.stops) {
+            if (stop >= stop_count_) {
+                throw std::out_of_range("Stop is out of range");
+            }
+            ++stop_route_offsets_.GetBegin()[stop + 1];
+        }
+        route_stop_offsets_.Set(route_stop_offsets_.Get(r) + length, r + 1);
+        trip_counts_.Set(route.stop_times.GetLength() / length, r);
+        time_offsets_.Set(time_offsets_.Get(r) + route.stop_times.GetLength(), r + 1);
+    }
+
+    route_stops_ = DynamicArray<size_t>(route_stop_offsets_.Get(route_count));
+    times_ = DynamicArray<StopTime>(time_offsets_.Get(route_count));
+    for (size_t r = 0; r < route_count; ++r) {
+        const TransitRoute& route = routes.Get(r);
+        const size_t length = route.stops.GetLength();
+        const size_t trips = trip_counts_.Get(r);
+        std::copy(route.stops.begin(), route.stops.end(), route_stops_.GetBegin() + route_stop_offsets_.Get(r));
+
+        const StopTime* input = route.stop_times.begin();
+        for (size_t t = 0; t < trips; ++t) {
+            for (size_t j = 0; j < length; ++j) {
+                const StopTime& time = input[t * length + j];
+                if (time.departure < time.arrival || (j > 0 && time.arrival < input[t * length + j - 1].departure)) {
+                    throw std::invalid_argument("Trip times must not decrease along the route");
+                }
+            }
+        }
+        DynamicArray<size_t> order(trips);
+        for (size_t t = 0; t < trips; ++t) {
+            order.Set(t, t);
+        }
+        std::sort(order.GetBegin(), order.GetBegin() + trips, [&](size_t a, size_t b) {
+            return input[a * length].departure < input[b * length].departure;
+        });
+        StopTime* output = times_.GetBegin() + time_offsets_.Get(r);
+        for (size_t j = 0; j < length; ++j) {
+            for (size_t t = 0; t < trips; ++t) {
+                const StopTime& time = input[order.Get(t) * length + j];
+                if (t > 0 && (time.arrival < output[j * trips + t - 1].arrival ||
+                              time.departure < output[j * trips + t - 1].departure)) {
+                    throw std::invalid_argument("Trips of a route must not overtake each other");
+                }
+                output[j * trips + t] = time;
+            }
+        }
+    }
+
+    size_t* offsets = stop_route_offsets_.GetBegin();
+    for (size_t s = 0; s < stop_count_; ++s) {
+        offsets[s + 1] += offsets[s];
+    }
+    stop_routes_ = DynamicArray<RouteStop>(offsets[stop_count_]);
+    DynamicArray<size_t> cursor(offsets, stop_count_);
+    for (size_t r = 0; r < route_count; ++r) {
+        const std::span<const size_t> stops = GetStops(r);
+        for (size_t j = 0; j < stops.size(); ++j) {
+            stop_routes_.GetBegin()[cursor.GetBegin()[stops[j]]++] = {static_cast<uint32_t>(r), static_cast<uint32_t>(j)};
+        }
+    }
+}
+
+size_t Timetable::GetStopCount() const {
+    return stop_count_;
+}
+
+size_t Timetable::GetRouteCount() const {
+    return trip_counts_.GetSize();
+}
+
+size_t Timetable::GetTripCount(size_t route) const {
+    return trip_counts_.Get(route);
+}
+
+std::span<const size_t> Timetable::GetStops(size_t route) const {
+    const size_t* base = route_stops_.GetBegin();
+    return {base + route_stop_offsets_.Get(route), base + route_stop_offsets_.Get(route + 1)};
+}
+
+std::span<const StopTime> Timetable::GetStopTimes(size_t route, size_t index) const {
+    const size_t trips = trip_counts_.Get(route);
+    return {times_.GetBegin() + time_offsets_.Get(route) + index * trips, trips};
+}
+
+std::span<const RouteStop> Timetable::GetRoutes(size_t stop) const {
+    if (stop >= stop_count_) {
+        throw std::out_of_range("Stop is out of range");
+    }
+    const RouteStop* base = stop_routes_.GetBegin();
+    return {base + stop_route_offsets_.Get(stop), base + stop_route_offsets_.Get(stop + 1)};
+}
+
+size_t Timetable::FindEarliestTrip(size_t route, size_t index, int64_t time) const {
+    const std::span<const StopTime> times = GetStopTimes(route, index);
+    return std::lower_bound(times.begin(), times.end(), time,
+                            [](const StopTime& stop_time, int64_t t) { return stop_time.departure < t; }) -
+           times.begin();
+}
+
+size_t Timetable::GetMemoryUsage() const {
+    return sizeof(*this) + (route_stop_offsets_.GetSize() + route_stops_.GetSize() + trip_counts_.GetSize() +
+                            time_offsets_.GetSize() + stop_route_offsets_.GetSize()) *
+                               sizeof(size_t) +
+           times_.GetSize() * sizeof(StopTime) + stop_routes_.GetSize() * sizeof(RouteStop);
+}
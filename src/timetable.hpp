@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "array_sequence.hpp"
+#include "dynamic_array.hpp"
+
+struct StopTime {
+    int64_t arrival = 0;
+    int64_t departure = 0;
+};
+
+// Input form of one transit route: trips visit the same stops in the same order.
+// stop_times is trip-major: the j-th stop of trip t is stop_times[t * stops.GetLength() + j].
+struct TransitRoute {
+    ArraySequence<size_t> stops;
+    ArraySequence<StopTime> stop_times;
+};
+
+struct RouteStop {
+    uint32_t route = 0;
+    uint32_t index = 0;
+};
+
+// Immutable schedule in flat arrays. Stops are graph vertex ids.
+// Times of each route are stored stop-major: the times of all trips at one stop are contiguous
+// and sorted, so finding the earliest trip is a binary search over one run of memory.
+class Timetable {
+public:
+    // Trips are sorted by departure; they must not overtake each other along the route.
+    Timetable(size_t stop_count, const Sequence<TransitRoute>& routes);
+
+    size_t GetStopCount() const;
+
+    size_t GetRouteCount() const;
+
+    size_t GetTripCount(size_t route) const;
+
+    std::span<const size_t> GetStops(size_t route) const;
+
+    // Times of all trips of a route at its index-th stop, ordered by trip.
+    std::span<const StopTime> GetStopTimes(size_t route, size_t index) const;
+
+    // Routes serving a stop together with the stop's position on each of them.
+    std::span<const RouteStop> GetRoutes(size_t stop) const;
+
+    // First trip departing from the index-th stop of a route at or after `time`, or GetTripCount(route).
+    size_t FindEarliestTrip(size_t route, size_t index, int64_t time) const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+    size_t stop_count_;
+    DynamicArray<size_t> route_stop_offsets_;
+    DynamicArray<size_t> route_stops_;
+    DynamicArray<size_t> trip_counts_;
+    DynamicArray<size_t> time_offsets_;
+    DynamicArray<StopTime> times_;
+    DynamicArray<size_t> stop_route_offsets_;
+    DynamicArray<RouteStop> stop_routes_;
+};
+
+using TimetablePtr = std::shared_ptr<const Timetable>;
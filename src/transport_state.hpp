@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "igraph.hpp"
+
+// Solvers search over (vertex, transport) states: every vertex is split into kTransportCount states.
+
+constexpr int64_t kInf = 1'000'000'000'000'000'000;
+constexpr size_t kNoState = kInf;
+constexpr Transport kSourceTransport = Transport::Feet;
+
+constexpr size_t EncodeState(size_t vertex, Transport transport) {
+    return vertex * kTransportCount + ToTransportIndex(transport);
+}
+
+constexpr size_t DecodeVertex(size_t state) {
+    return state / kTransportCount;
+}
+
+constexpr Transport DecodeTransport(size_t state) {
+    return static_cast<Transport>(state % kTransportCount);
+}
+
+constexpr size_t GetStateCount(size_t vertex_count) {
+    return vertex_count * kTransportCount;
+}
+
+inline bool CombineTransfer(
+    const TransferMatrix& transfer, const AccumulatedPath& current, Transport from_transport, Transport to_transport,
+    AccumulatedPath& combined) {
+    const int64_t step_cost = transfer.GetCost(from_transport, to_transport);
+    if (step_cost >= kNoTransferCost) {
+        return false;
+    }
+    return current.Combine(step_cost, combined);
+}
@@ -0,0 +1,283 @@
+#include "versioned_graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+constexpr size_t kVertexBlockSize = 256;
+constexpr size_t kEdgeBlockSize = 1024;
+
+size_t GraphSnapshot::GetVertexCount() const {
+    return vertex_count_;
+}
+
+size_t GraphSnapshot::GetEdgeCount() const {
+    return edge_count_;
+}
+
+bool GraphSnapshot::IsDirected() const {
+    return directed_;
+}
+
+size_t GraphSnapshot::AddEdge(const Edge&) {
+    throw std::logic_error("Graph snapshots are read-only");
+}
+
+bool GraphSnapshot::HasEdge(size_t edge_id) const {
+    return edge_id < edge_ids_ && edge_blocks_.Get(edge_id / kEdgeBlockSize)->Get(edge_id % kEdgeBlockSize).alive;
+}
+
+Edge GraphSnapshot::GetEdge(size_t edge_id) const {
+    return GetRecord(edge_id).edge;
+}
+
+void GraphSnapshot::UpdateEdgeWeight(size_t, int64_t) {
+    throw std::logic_error("Graph snapshots are read-only");
+}
+
+void GraphSnapshot::RemoveEdge(size_t) {
+    throw std::logic_error("Graph snapshots are read-only");
+}
+
+void GraphSnapshot::ApplyUpdates(const Sequence<EdgeUpdate>&) {
+    throw std::logic_error("Graph snapshots are read-only");
+}
+
+uint64_t GraphSnapshot::GetVersion() const {
+    return version_;
+}
+
+VertexPtr GraphSnapshot::GetVertex(size_t v) const {
+    if (v >= vertex_count_) {
+        throw std::out_of_range("Vertex index is out of range");
+    }
+    return vertex_blocks_.Get(v / kVertexBlockSize)->Get(v % kVertexBlockSize);
+}
+
+Arcs GraphSnapshot::GetArcs(size_t v) const {
+    return GetVertex(v)->arcs;
+}
+
+const GraphSnapshot::EdgeRecord& GraphSnapshot::GetRecord(size_t edge_id) const {
+    if (!HasEdge(edge_id)) {
+        throw std::out_of_range("No edge with id " + std::to_string(edge_id));
+    }
+    return edge_blocks_.Get(edge_id / kEdgeBlockSize)->Get(edge_id % kEdgeBlockSize);
+}
+
+// The next version under construction. Starts as a shallow copy of the current one and copies a block,
+// vertex or adjacency list the first time it is written, so everything untouched stays shared.
+class VersionedGraph::Draft {
+public:
+    Draft(const GraphSnapshot& base, const ArraySequence<VertexPtr>& identities)
+        : next_(std::make_shared<GraphSnapshot>(base)),
+          identities_(identities),
+          vertex_blocks_owned_(base.vertex_blocks_.GetLength(), false),
+          edge_blocks_owned_(base.edge_blocks_.GetLength(), false) {
+    }
+
+    GraphSnapshot& Get() {
+        return *next_;
+    }
+
+    Vertex& MutableVertex(size_t v) {
+        if (v >= next_->vertex_count_) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+        const size_t block = v / kVertexBlockSize;
+        if (!vertex_blocks_owned_.Get(block)) {
+            next_->vertex_blocks_.Set(std::make_shared<GraphSnapshot::VertexBlock>(*next_->vertex_blocks_.Get(block)),
+                                      block);
+            vertex_blocks_owned_.Set(true, block);
+        }
+        VertexPtr& slot = next_->vertex_blocks_.Get(block)->begin()[v % kVertexBlockSize];
+        if (vertices_owned_.insert(v).second) {
+            auto copy = std::make_shared<Vertex>(v, slot->transfer);
+            copy->arcs = std::make_shared<ListSequence<Arc>>(*slot->arcs);
+            slot = std::move(copy);
+        }
+        return *slot;
+    }
+
+    GraphSnapshot::EdgeRecord& MutableRecord(size_t edge_id) {
+        next_->GetRecord(edge_id);
+        return OwnedRecord(edge_id);
+    }
+
+    size_t AddEdge(const Edge& edge) {
+        if (edge.u >= next_->vertex_count_ || edge.v >= next_->vertex_count_) {
+            throw std::out_of_range("Vertex index is out of range");
+        }
+        const size_t edge_id = next_->edge_ids_;
+        if (edge_id % kEdgeBlockSize == 0) {
+            next_->edge_blocks_.Append(std::make_shared<GraphSnapshot::EdgeBlock>(kEdgeBlockSize));
+            edge_blocks_owned_.Append(true);
+        }
+        ++next_->edge_ids_;
+        ++next_->edge_count_;
+        GraphSnapshot::EdgeRecord& record = OwnedRecord(edge_id);
+        record.edge = edge;
+        record.alive = true;
+
+        const VertexPtr& from = identities_.Get(edge.u);
+        const VertexPtr& to = identities_.Get(edge.v);
+        MutableVertex(edge.u).arcs->Append({from, to, edge.weight, edge_id, edge.modes});
+        if (!next_->directed_) {
+            MutableVertex(edge.v).arcs->Append({to, from, edge.weight, edge_id, edge.modes});
+        }
+        return edge_id;
+    }
+
+    void SetWeight(size_t edge_id, int64_t weight) {
+        GraphSnapshot::EdgeRecord& record = MutableRecord(edge_id);
+        record.edge.weight = weight;
+        for (size_t v : {record.edge.u, record.edge.v}) {
+            for (Arc& arc : *MutableVertex(v).arcs) {
+                if (arc.edge_id == edge_id) {
+                    arc.weight = weight;
+                }
+            }
+            if (next_->directed_) {
+                break;
+            }
+        }
+    }
+
+    void Remove(size_t edge_id) {
+        GraphSnapshot::EdgeRecord& record = MutableRecord(edge_id);
+        record.alive = false;
+        --next_->edge_count_;
+        for (size_t v : {record.edge.u, record.edge.v}) {
+            Vertex& vertex = MutableVertex(v);
+            auto arcs = std::make_shared<ListSequence<Arc>>();
+            for (const Arc& arc : *vertex.arcs) {
+                if (arc.edge_id != edge_id) {
+                    arcs->Append(arc);
+                }
+            }
+            vertex.arcs = std::move(arcs);
+            if (next_->directed_) {
+                break;
+            }
+        }
+    }
+
+    GraphSnapshotPtr Finish() {
+        ++next_->version_;
+        return std::move(next_);
+    }
+
+private:
+    GraphSnapshotPtr next_;
+    const ArraySequence<VertexPtr>& identities_;
+    ArraySequence<bool> vertex_blocks_owned_;
+    ArraySequence<bool> edge_blocks_owned_;
+    std::unordered_set<size_t> vertices_owned_;
+
+    GraphSnapshot::EdgeRecord& OwnedRecord(size_t edge_id) {
+        const size_t block = edge_id / kEdgeBlockSize;
+        if (!edge_blocks_owned_.Get(block)) {
+            next_->edge_blocks_.Set(std::make_shared<GraphSnapshot::EdgeBlock>(*next_->edge_blocks_.Get(block)), block);
+            edge_blocks_owned_.Set(true, block);
+        }
+        return next_->edge_blocks_.Get(block)->begin()[edge_id % kEdgeBlockSize];
+    }
+};
+
+VersionedGraph::VersionedGraph(size_t n, bool directed) : identities_(n) {
+    auto first = std::make_shared<GraphSnapshot>();
+    first->vertex_count_ = n;
+    first->directed_ = directed;
+    for (size_t begin = 0; begin < n; begin += kVertexBlockSize) {
+        auto block = std::make_shared<GraphSnapshot::VertexBlock>(std::min(kVertexBlockSize, n - begin));
+        for (size_t i = 0; i < block->GetLength(); ++i) {
+            block->Set(std::make_shared<Vertex>(begin + i), i);
+            identities_.Set(std::make_shared<Vertex>(begin + i), begin + i);
+        }
+        first->vertex_blocks_.Append(std::move(block));
+    }
+    current_.store(std::move(first));
+}
+
+VersionedGraph::VersionedGraph(size_t n, bool directed, const ArraySequence<Edge>& edges)
+    : VersionedGraph(n, directed) {
+    if (edges.GetLength() > 0) {
+        AddEdges(edges);
+    }
+}
+
+GraphSnapshotPtr VersionedGraph::GetSnapshot() const {
+    return current_.load();
+}
+
+uint64_t VersionedGraph::GetVersion() const {
+    return GetSnapshot()->GetVersion();
+}
+
+size_t VersionedGraph::GetVertexCount() const {
+    return identities_.GetLength();
+}
+
+bool VersionedGraph::IsDirected() const {
+    return GetSnapshot()->IsDirected();
+}
+
+template <typename Change>
+void VersionedGraph::Publish(Change&& change) {
+    std::lock_guard lock(write_mutex_);
+    // A failing change throws before anything is published.
+    Draft draft(*current_.load(), identities_);
+    change(draft);
+    current_.store(draft.Finish());
+}
+
+size_t VersionedGraph::AddEdge(const Edge& edge) {
+    size_t edge_id = 0;
+    Publish([&](Draft& draft) { edge_id = draft.AddEdge(edge); });
+    return edge_id;
+}
+
+size_t VersionedGraph::AddEdges(const ArraySequence<Edge>& edges) {
+    size_t first_id = 0;
+    Publish([&](Draft& draft) {
+        first_id = draft.Get().edge_ids_;
+        for (const Edge& edge : edges) {
+            draft.AddEdge(edge);
+        }
+    });
+    return first_id;
+}
+
+void VersionedGraph::UpdateEdgeWeight(size_t edge_id, int64_t weight) {
+    Publish([&](Draft& draft) { draft.SetWeight(edge_id, weight); });
+}
+
+void VersionedGraph::RemoveEdge(size_t edge_id) {
+    Publish([&](Draft& draft) { draft.Remove(edge_id); });
+}
+
+void VersionedGraph::ApplyUpdates(const Sequence<EdgeUpdate>& updates) {
+    Publish([&](Draft& draft) {
+        for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+            draft.Get().GetRecord(it->GetCurrentItem().edge_id);
+        }
+        for (auto it = updates.GetIterator(); it->HasNext(); it->Next()) {
+            const EdgeUpdate& update = it->GetCurrentItem();
+            if (!draft.Get().HasEdge(update.edge_id)) {
+                // Removed earlier in the same batch.
+                continue;
+            }
+            if (update.remove) {
+                draft.Remove(update.edge_id);
+            } else {
+                draft.SetWeight(update.edge_id, update.weight);
+            }
+        }
+    });
+}
+
+void VersionedGraph::SetTransfer(size_t v, const TransferMatrix& transfer) {
+    Publish([&](Draft& draft) { draft.MutableVertex(v).transfer = transfer; });
+}
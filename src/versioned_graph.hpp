@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "array_sequence.hpp"
+#include "igraph.hpp"
+
+// One immutable version of a VersionedGraph. Solvers take it like any IGraph; the mutating IGraph
+// methods throw std::logic_error. Vertices and edge records sit in fixed-size blocks shared with the
+// neighbouring versions, so a new version copies only the blocks and adjacency lists it touches.
+// Arc::from and Arc::vertex point to identity vertices that carry just the id (and are shared by all
+// versions), so a search continues through GetVertex(arc.vertex->id) as the solvers already do.
+class GraphSnapshot : public IGraph {
+public:
+    size_t GetVertexCount() const override;
+
+    size_t GetEdgeCount() const override;
+
+    bool IsDirected() const override;
+
+    size_t AddEdge(const Edge& edge) override;
+
+    bool HasEdge(size_t edge_id) const override;
+
+    Edge GetEdge(size_t edge_id) const override;
+
+    void UpdateEdgeWeight(size_t edge_id, int64_t weight) override;
+
+    void RemoveEdge(size_t edge_id) override;
+
+    void ApplyUpdates(const Sequence<EdgeUpdate>& updates) override;
+
+    uint64_t GetVersion() const override;
+
+    VertexPtr GetVertex(size_t v) const override;
+
+    Arcs GetArcs(size_t v) const override;
+
+private:
+    friend class VersionedGraph;
+
+    struct EdgeRecord {
+        Edge edge;
+        bool alive = false;
+    };
+
+    using VertexBlock = ArraySequence<VertexPtr>;
+    using EdgeBlock = ArraySequence<EdgeRecord>;
+
+    ArraySequence<std::shared_ptr<VertexBlock>> vertex_blocks_;
+    ArraySequence<std::shared_ptr<EdgeBlock>> edge_blocks_;
+    size_t vertex_count_ = 0;
+    // Ids handed out so far, removed edges included.
+    size_t edge_ids_ = 0;
+    size_t edge_count_ = 0;
+    bool directed_ = false;
+    uint64_t version_ = 0;
+
+    const EdgeRecord& GetRecord(size_t edge_id) const;
+};
+
+using GraphSnapshotPtr = std::shared_ptr<GraphSnapshot>;
+
+// Graph that is updated while queries keep running. Readers pin the current version with
+// GetSnapshot() and work on it without locks for as long as they hold it. Writers are serialised,
+// build the next version beside the current one and publish it with a single atomic store; a version
+// is freed when its last reader drops it. Every mutating call publishes exactly one version, so
+// batches (AddEdges, ApplyUpdates) are also the cheap way to stream many changes.
+class VersionedGraph {
+public:
+    VersionedGraph(size_t n, bool directed);
+
+    VersionedGraph(size_t n, bool directed, const ArraySequence<Edge>& edges);
+
+    GraphSnapshotPtr GetSnapshot() const;
+
+    uint64_t GetVersion() const;
+
+    size_t GetVertexCount() const;
+
+    bool IsDirected() const;
+
+    size_t AddEdge(const Edge& edge);
+
+    // Returns the id of the first edge; the rest follow in order.
+    size_t AddEdges(const ArraySequence<Edge>& edges);
+
+    void UpdateEdgeWeight(size_t edge_id, int64_t weight);
+
+    void RemoveEdge(size_t edge_id);
+
+    // Same contract as IGraph::ApplyUpdates.
+    void ApplyUpdates(const Sequence<EdgeUpdate>& updates);
+
+    void SetTransfer(size_t v, const TransferMatrix& transfer);
+
+private:
+    class Draft;
+
+    // Identity vertices the arcs of every version point to.
+    ArraySequence<VertexPtr> identities_;
+    std::mutex write_mutex_;
+    std::atomic<GraphSnapshotPtr> current_;
+
+    template <typename Change>
+    void Publish(Change&& change);
+};
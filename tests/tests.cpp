@@ -1,11 +1,51 @@
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stop_token>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "array_sequence.hpp"
+#include "async_queries.hpp"
+#include "compact_shortest_paths.hpp"
 #include "directed_graph.hpp"
+#include "edge_list_loader.hpp"
 #include "graph.hpp"
+#include "graph_generators.hpp"
+#include "graph_import.hpp"
+#include "graph_io.hpp"
+#include "graph_reordering.hpp"
+#include "incremental_shortest_paths.hpp"
+#include "isochrone.hpp"
+#include "k_shortest_paths.hpp"
 #include "list_sequence.hpp"
+#include "numa_graph.hpp"
+#include "pareto_search.hpp"
+#include "perf_counters.hpp"
+#include "query_server.hpp"
+#include "raptor.hpp"
+#include "resource_constrained.hpp"
 #include "shortest_paths.hpp"
+#include "shortest_paths_cache.hpp"
+#include "thread_pool.hpp"
+#include "time_dependent.hpp"
+#include "versioned_graph.hpp"
 
 template <typename T>
 std::vector<T> ToVector(const SequencePtr<T>& seq) {
@@ -38,6 +78,38 @@ std::vector<size_t> ArcFromVertices(const Arcs& arcs) {
     return res;
 }
 
+TEST_CASE("SequenceIterators") {
+    int items[] = {3, 1, 2};
+
+    ArraySequence<int> array(items, 3);
+    REQUIRE(std::vector<int>(array.begin(), array.end()) == std::vector<int>{3, 1, 2});
+    for (int& x : array) {
+        x *= 2;
+    }
+    REQUIRE(array.Get(2) == 4);
+
+    ListSequence<int> list(items, 3);
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>{3, 1, 2});
+    REQUIRE(std::distance(list.begin(), list.end()) == 3);
+    REQUIRE(*std::find(list.begin(), list.end(), 1) == 1);
+    for (int& x : list) {
+        ++x;
+    }
+    REQUIRE(list.GetLast() == 3);
+
+    const LinkedList<int> linked(items, 3);
+    int sum = 0;
+    for (int x : linked) {
+        sum += x;
+    }
+    REQUIRE(sum == 6);
+
+    ListSequence<int> empty;
+    REQUIRE(empty.begin() == empty.end());
+    ArraySequence<int> empty_array;
+    REQUIRE(empty_array.begin() == empty_array.end());
+}
+
 TEST_CASE("Undirected") {
     Graph g(3);
     g.AddEdge({0, 1, 7});
@@ -177,3 +249,1924 @@ TEST_CASE("TransportStatefulShortestPath") {
     REQUIRE(b_path[3].transport == Transport::Bus);
     REQUIRE(b_path[3].is_transfer == false);
 }
+
+TEST_CASE("CompactGraph") {
+    auto edges = std::make_shared<ListSequence<Edge>>();
+    edges->Append({0, 1, 4});
+    edges->Append({0, 2, 1});
+    edges->Append({2, 1, 2});
+    edges->Append({1, 3, 1});
+    edges->Append({2, 3, 5});
+
+    REQUIRE(sizeof(CompactGraph32::ArcType) == 8);
+    REQUIRE(sizeof(CompactGraph64::ArcType) == 12);
+
+    auto compact = std::make_shared<CompactGraph32>(4, *edges, true);
+    REQUIRE(compact->GetVertexCount() == 4);
+    REQUIRE(compact->GetEdgeCount() == 5);
+    REQUIRE(compact->GetArcs(0).size() == 2);
+    REQUIRE(compact->GetArcs(3).empty());
+
+    CompactDijkstra32 dijkstra(compact, 0);
+    REQUIRE(dijkstra.GetDistance(3) == 4);
+    REQUIRE(ToVector(dijkstra.GetShortestPath(3)) == std::vector<size_t>{0, 2, 1, 3});
+
+    auto undirected = std::make_shared<CompactGraph32>(4, *edges, false);
+    REQUIRE(undirected->GetArcCount() == 10);
+    REQUIRE(CompactDijkstra32(undirected, 3).GetDistance(0) == 4);
+
+    auto big_weight = std::make_shared<ListSequence<Edge>>();
+    big_weight->Append({0, 1, int64_t{1} << 40});
+    REQUIRE_THROWS_AS(CompactGraph32(2, *big_weight, true), std::out_of_range);
+    REQUIRE(CompactGraph64(2, *big_weight, true).GetArcs(0)[0].weight == int64_t{1} << 40);
+}
+
+TEST_CASE("CompactGraphMatchesGraph") {
+    auto edges = std::make_shared<ListSequence<Edge>>();
+    edges->Append({0, 1, 1});
+    edges->Append({1, 2, 1});
+    edges->Append({0, 2, 4});
+    edges->Append({2, 3, -3});
+    auto g = std::make_shared<DirectedGraph>(4, edges);
+    g->GetVertex(0)->transfer.SetCost(Transport::Feet, Transport::Bus, 0);
+
+    auto compact = std::make_shared<CompactGraph64>(CompactGraph64::FromGraph(*g));
+    FordBellman bellman(g, 0);
+    CompactFordBellman64 compact_bellman(compact, 0);
+    for (size_t v = 0; v < 4; ++v) {
+        REQUIRE(compact_bellman.GetDistance(v) == bellman.GetDistance(v));
+        REQUIRE(ToVector(compact_bellman.GetShortestPath(v)) == ToVector(bellman.GetShortestPath(v)));
+    }
+    auto steps = ToVector(compact_bellman.GetShortestPathWithTransfers(2));
+    REQUIRE(steps.size() == 4);
+    REQUIRE(steps[1].is_transfer);
+    REQUIRE(steps[1].transport == Transport::Bus);
+
+    g->AddEdge({3, 0, 1});
+    auto positive = std::make_shared<CompactGraph64>(CompactGraph64::FromGraph(*g));
+    REQUIRE_THROWS_AS(CompactDijkstra64(positive, 0), std::invalid_argument);
+}
+
+TEST_CASE("GraphReordering") {
+    auto edges = std::make_shared<ListSequence<Edge>>();
+    edges->Append({0, 4, 2});
+    edges->Append({4, 2, 1});
+    edges->Append({2, 5, 3});
+    edges->Append({5, 1, 1});
+    edges->Append({1, 3, 7});
+    edges->Append({0, 3, 20});
+    edges->Append({3, 3, 1});
+
+    for (bool directed : {false, true}) {
+        IGraphPtr g;
+        if (directed) {
+            g = std::make_shared<DirectedGraph>(6, edges);
+        } else {
+            g = std::make_shared<Graph>(6, edges);
+        }
+        g->GetVertex(4)->transfer.SetCost(Transport::Feet, Transport::Car, 0);
+
+        for (const VertexOrder& order : {BfsOrder(*g), ReverseCuthillMcKeeOrder(*g)}) {
+            for (size_t v = 0; v < 6; ++v) {
+                REQUIRE(order.ToOld(order.ToNew(v)) == v);
+            }
+            ReorderedGraph reordered = Reorder(*g, order);
+            REQUIRE(reordered.graph->GetEdgeCount() == g->GetEdgeCount());
+            REQUIRE(reordered.graph->IsDirected() == directed);
+
+            Dijkstra expected(g, 0);
+            auto finder = MakeReorderedFinder<Dijkstra>(reordered, 0);
+            for (size_t v = 0; v < 6; ++v) {
+                REQUIRE(finder->GetDistance(v) == expected.GetDistance(v));
+                REQUIRE(ToVector(finder->GetShortestPath(v)) == ToVector(expected.GetShortestPath(v)));
+            }
+            auto steps = ToVector(finder->GetShortestPathWithTransfers(3));
+            REQUIRE(steps.front().vertex == 0);
+            REQUIRE(steps.back().vertex == 3);
+        }
+    }
+
+    auto bfs = BfsOrder(*std::make_shared<DirectedGraph>(6, edges), 2);
+    REQUIRE(bfs.ToOld(0) == 2);
+    REQUIRE(bfs.ToOld(1) == 5);
+    REQUIRE(bfs.ToOld(2) == 1);
+}
+
+TEST_CASE("HilbertOrder") {
+    ListSequence<Coordinate> points;
+    points.Append({1, 1});
+    points.Append({0, 0});
+    points.Append({1, 0});
+    points.Append({0, 1});
+
+    VertexOrder order = HilbertOrder(points);
+    REQUIRE(order.ToOld(0) == 1);
+    REQUIRE(order.ToOld(1) == 3);
+    REQUIRE(order.ToOld(2) == 0);
+    REQUIRE(order.ToOld(3) == 2);
+
+    ArraySequence<size_t> broken(2, 0);
+    REQUIRE_THROWS_AS(VertexOrder(broken), std::invalid_argument);
+}
+
+TEST_CASE("EdgeUpdates") {
+    auto g = std::make_shared<Graph>(4);
+    const size_t a = g->AddEdge({0, 1, 1});
+    const size_t b = g->AddEdge({1, 2, 1});
+    const size_t c = g->AddEdge({0, 2, 5});
+    const size_t d = g->AddEdge({2, 3, 1});
+    REQUIRE(a == 0);
+    REQUIRE(d == 3);
+    REQUIRE(g->GetVersion() == 4);
+    REQUIRE(Dijkstra(g, 0).GetDistance(3) == 3);
+
+    g->UpdateEdgeWeight(b, 10);
+    REQUIRE(g->GetEdge(b).weight == 10);
+    REQUIRE(g->GetVersion() == 5);
+    REQUIRE(Dijkstra(g, 0).GetDistance(3) == 6);
+    REQUIRE(Dijkstra(g, 3).GetDistance(0) == 6);
+
+    g->RemoveEdge(c);
+    REQUIRE(!g->HasEdge(c));
+    REQUIRE(g->GetEdgeCount() == 3);
+    REQUIRE(ArcVertices(g->GetArcs(0)) == std::vector<size_t>{1});
+    REQUIRE(ArcVertices(g->GetArcs(2)) == std::vector<size_t>{1, 3});
+    REQUIRE(Dijkstra(g, 0).GetDistance(3) == 12);
+    REQUIRE_THROWS_AS(g->UpdateEdgeWeight(c, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(g->RemoveEdge(42), std::out_of_range);
+
+    ListSequence<EdgeUpdate> batch;
+    batch.Append({a, 2});
+    batch.Append({b, 3});
+    batch.Append({d, 0, true});
+    batch.Append({d, 7});
+    const uint64_t version = g->GetVersion();
+    g->ApplyUpdates(batch);
+    REQUIRE(g->GetVersion() == version + 1);
+    REQUIRE(Dijkstra(g, 0).GetDistance(2) == 5);
+    REQUIRE(Dijkstra(g, 0).GetShortestPath(3) == nullptr);
+    REQUIRE(g->GetEdgeCount() == 2);
+
+    ListSequence<EdgeUpdate> invalid;
+    invalid.Append({a, 100});
+    invalid.Append({c, 1});
+    REQUIRE_THROWS_AS(g->ApplyUpdates(invalid), std::out_of_range);
+    REQUIRE(g->GetEdge(a).weight == 2);
+    REQUIRE(g->GetVersion() == version + 1);
+
+    auto dg = std::make_shared<DirectedGraph>(2);
+    const size_t loop = dg->AddEdge({1, 1, 3});
+    const size_t arc = dg->AddEdge({0, 1, 4});
+    dg->RemoveEdge(loop);
+    REQUIRE(ArcVertices(dg->GetArcs(1)).empty());
+    REQUIRE(dg->GetEdge(arc).v == 1);
+    dg->AddEdge({1, 0, 1});
+    REQUIRE(ArcVertices(dg->GetArcs(1)) == std::vector<size_t>{0});
+}
+
+TEST_CASE("IncrementalShortestPaths") {
+    std::mt19937 rng(7);
+    for (bool directed : {false, true}) {
+        const size_t n = 40;
+        IGraphPtr g;
+        if (directed) {
+            g = std::make_shared<DirectedGraph>(n);
+        } else {
+            g = std::make_shared<Graph>(n);
+        }
+        std::uniform_int_distribution<size_t> vertex(0, n - 1);
+        std::uniform_int_distribution<int64_t> weight(0, 20);
+        for (size_t i = 0; i < 160; ++i) {
+            g->AddEdge({vertex(rng), vertex(rng), weight(rng)});
+        }
+        g->GetVertex(3)->transfer.SetCost(Transport::Feet, Transport::Car, 2);
+        g->GetVertex(7)->transfer.SetCost(Transport::Car, Transport::Feet, 1);
+
+        IncrementalShortestPaths incremental(g, 0);
+        for (size_t round = 0; round < 30; ++round) {
+            ListSequence<EdgeUpdate> batch;
+            for (size_t i = 0; i < 5; ++i) {
+                const size_t edge_id = std::uniform_int_distribution<size_t>(0, 159)(rng);
+                if (!g->HasEdge(edge_id)) {
+                    continue;
+                }
+                batch.Append({edge_id, weight(rng), rng() % 10 == 0});
+            }
+            incremental.ApplyUpdates(batch);
+            REQUIRE(incremental.GetGraphVersion() == g->GetVersion());
+
+            Dijkstra fresh(g, 0);
+            for (size_t v = 0; v < n; ++v) {
+                REQUIRE(incremental.GetDistance(v) == fresh.GetDistance(v));
+                REQUIRE((incremental.GetShortestPath(v) == nullptr) == (fresh.GetShortestPath(v) == nullptr));
+            }
+        }
+
+        const size_t added = g->AddEdge({0, n - 1, 0});
+        ArraySequence<size_t> changed(1, added);
+        incremental.Repair(changed);
+        REQUIRE(incremental.GetDistance(n - 1) == 0);
+        REQUIRE(ToVector(incremental.GetShortestPath(n - 1)) == std::vector<size_t>{0, n - 1});
+    }
+
+    auto g = std::make_shared<DirectedGraph>(3);
+    g->AddEdge({0, 1, 1});
+    const size_t tail = g->AddEdge({1, 2, 1});
+    IncrementalShortestPaths incremental(g, 0);
+    ListSequence<EdgeUpdate> negative;
+    negative.Append({0, 5});
+    negative.Append({tail, -1});
+    const uint64_t version = g->GetVersion();
+    REQUIRE_THROWS_AS(incremental.ApplyUpdates(negative), std::invalid_argument);
+    REQUIRE(g->GetVersion() == version);
+    REQUIRE(incremental.GetGraphVersion() == version);
+    REQUIRE(g->GetEdge(0).weight == 1);
+    REQUIRE(g->GetEdge(tail).weight == 1);
+    REQUIRE(incremental.GetDistance(2) == 2);
+
+    ArcModes cheaper_by_car;
+    cheaper_by_car.extra[ToTransportIndex(Transport::Car)] = -3;
+    const size_t shortcut = g->AddEdge({0, 2, 5, cheaper_by_car});
+    incremental.Repair(ArraySequence<size_t>(1, shortcut));
+    ListSequence<EdgeUpdate> negative_mode;
+    negative_mode.Append({shortcut, 2});
+    REQUIRE_THROWS_AS(incremental.ApplyUpdates(negative_mode), std::invalid_argument);
+    REQUIRE(g->GetEdge(shortcut).weight == 5);
+    REQUIRE(incremental.GetDistance(2) == 2);
+}
+
+TEST_CASE("ShortestPathsCache") {
+    auto g = std::make_shared<DirectedGraph>(4);
+    g->AddEdge({0, 1, 1});
+    const size_t middle = g->AddEdge({1, 2, 1});
+    g->AddEdge({2, 3, 1});
+
+    const size_t tree_bytes = Dijkstra(g, 0).GetMemoryUsage();
+    ShortestPathsCache cache(g, 2 * tree_bytes);
+
+    REQUIRE(cache.GetDistance(0, 3) == 3);
+    REQUIRE(cache.GetDistance(0, 2) == 2);
+    REQUIRE(ToVector(cache.GetShortestPath(0, 3)) == std::vector<size_t>{0, 1, 2, 3});
+    REQUIRE(cache.GetDistance(0, 3, Algorithm::FordBellman) == 3);
+    auto stats = cache.GetStats();
+    REQUIRE(stats.hits == 2);
+    REQUIRE(stats.misses == 2);
+    REQUIRE(stats.entries == 2);
+    REQUIRE(stats.bytes == 2 * tree_bytes);
+
+    REQUIRE(cache.GetDistance(1, 3) == 2);
+    stats = cache.GetStats();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.entries == 2);
+    REQUIRE(cache.GetDistance(0, 3, Algorithm::FordBellman) == 3);
+    REQUIRE(cache.GetStats().hits == 3);
+
+    g->UpdateEdgeWeight(middle, 10);
+    REQUIRE(cache.GetDistance(0, 3) == 12);
+    stats = cache.GetStats();
+    REQUIRE(stats.invalidations == 2);
+    REQUIRE(stats.entries == 1);
+
+    std::vector<std::thread> workers;
+    std::atomic<size_t> wrong = 0;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&cache, &wrong, t] {
+            for (size_t i = 0; i < 50; ++i) {
+                const size_t from = (i + t) % 2;
+                if (cache.GetDistance(from, from) != 0) {
+                    ++wrong;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    REQUIRE(wrong == 0);
+    stats = cache.GetStats();
+    REQUIRE(stats.hits + stats.misses == 207);
+    REQUIRE(stats.bytes <= stats.capacity_bytes);
+    REQUIRE(stats.GetHitRate() > 0.5);
+
+    ShortestPathsCache tiny(g, 1);
+    REQUIRE(tiny.GetDistance(0, 3) == 12);
+    REQUIRE(tiny.GetStats().entries == 0);
+}
+
+TEST_CASE("PathView") {
+    auto edges = std::make_shared<ListSequence<Edge>>();
+    edges->Append({0, 1, 1});
+    edges->Append({1, 2, 1});
+    edges->Append({0, 2, 4});
+    auto g = std::make_shared<DirectedGraph>(4, edges);
+    g->GetVertex(0)->transfer.SetCost(Transport::Feet, Transport::Bus, 0);
+
+    Dijkstra dijkstra(g, 0);
+    PathView view = dijkstra.GetPathView(2);
+    REQUIRE(!view.IsEmpty());
+    REQUIRE(view.GetLength() == 4);
+    REQUIRE(view.GetVertexCount() == 3);
+
+    std::vector<size_t> reversed_states;
+    std::vector<bool> transfers;
+    for (PathStep step : view) {
+        reversed_states.push_back(step.vertex);
+        transfers.push_back(step.is_transfer);
+    }
+    REQUIRE(reversed_states == std::vector<size_t>{2, 1, 0, 0});
+    REQUIRE(transfers == std::vector<bool>{false, false, true, false});
+
+    std::vector<size_t> reversed_vertices;
+    for (size_t vertex : view.Vertices()) {
+        reversed_vertices.push_back(vertex);
+    }
+    REQUIRE(reversed_vertices == std::vector<size_t>{2, 1, 0});
+
+    size_t vertices[3];
+    REQUIRE(view.FillVertices(vertices, 2) == 3);
+    REQUIRE(view.FillVertices(vertices, 3) == 3);
+    REQUIRE(std::vector<size_t>(vertices, vertices + 3) == std::vector<size_t>{0, 1, 2});
+
+    PathStep steps[4];
+    REQUIRE(view.FillSteps(steps, 4) == 4);
+    REQUIRE(steps[0].transport == Transport::Feet);
+    REQUIRE(steps[1].transport == Transport::Bus);
+    REQUIRE(steps[1].is_transfer);
+    REQUIRE(steps[3].vertex == 2);
+
+    REQUIRE(dijkstra.GetPathView(3).IsEmpty());
+    REQUIRE(dijkstra.GetPathView(3).GetLength() == 0);
+    REQUIRE(dijkstra.GetPathView(0).GetVertexCount() == 1);
+
+    auto compact = std::make_shared<CompactGraph32>(CompactGraph32::FromGraph(*g));
+    CompactDijkstra32 compact_dijkstra(compact, 0);
+    REQUIRE(compact_dijkstra.GetPathView(2).GetLength() == 4);
+    REQUIRE(compact_dijkstra.GetPathView(3).IsEmpty());
+}
+
+TEST_CASE("ShortestPathTree") {
+    auto edges = std::make_shared<ListSequence<Edge>>();
+    edges->Append({0, 1, 1});
+    edges->Append({1, 2, 1});
+    edges->Append({1, 3, 1});
+    edges->Append({3, 4, 1});
+    edges->Append({0, 5, 1});
+    auto g = std::make_shared<DirectedGraph>(7, edges);
+
+    Dijkstra dijkstra(g, 0);
+    ShortestPathTree tree = dijkstra.GetShortestPathTree();
+    const size_t root = tree.GetRoot();
+    REQUIRE(tree.GetSubtreeSize(root) == tree.GetStateCount());
+    REQUIRE(tree.GetSubtree(root).size() == tree.GetStateCount());
+    REQUIRE(tree.GetEnter(root) == 0);
+    REQUIRE(!tree.Contains(3 * 6));
+
+    for (size_t target = 0; target < 6; ++target) {
+        auto path = ToVector(dijkstra.GetShortestPath(target));
+        for (size_t via = 0; via < 7; ++via) {
+            const bool on_path = std::find(path.begin(), path.end(), via) != path.end();
+            REQUIRE(tree.RoutesThrough(target, via) == on_path);
+        }
+    }
+    REQUIRE(!tree.RoutesThrough(6, 0));
+
+    auto through_one = ToVector(tree.GetTargetsThrough(1));
+    std::sort(through_one.begin(), through_one.end());
+    REQUIRE(through_one == std::vector<size_t>{1, 2, 3, 4});
+    REQUIRE(ToVector(tree.GetTargetsThrough(5)) == std::vector<size_t>{5});
+    REQUIRE(tree.GetTargetsThrough(6)->GetLength() == 0);
+
+    size_t children = 0;
+    for (size_t state : tree.GetSubtree(root)) {
+        children += tree.GetChildren(state).size();
+        for (size_t child : tree.GetChildren(state)) {
+            REQUIRE(tree.IsInSubtree(state, child));
+            REQUIRE(!tree.IsInSubtree(child, state));
+        }
+    }
+    REQUIRE(children + 1 == tree.GetStateCount());
+
+    g->GetVertex(1)->transfer.SetCost(Transport::Feet, Transport::Car, 0);
+    Dijkstra with_transfer(g, 0);
+    auto via_one = ToVector(with_transfer.GetShortestPathTree().GetTargetsThrough(1));
+    std::sort(via_one.begin(), via_one.end());
+    REQUIRE(via_one == std::vector<size_t>{1, 2, 3, 4});
+}
+
+TEST_CASE("ExploreWithinBudget") {
+    std::mt19937 rng(11);
+    const size_t n = 60;
+    auto g = std::make_shared<Graph>(n);
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_int_distribution<int64_t> weight(1, 9);
+    for (size_t i = 0; i < 150; ++i) {
+        g->AddEdge({vertex(rng), vertex(rng), weight(rng)});
+    }
+    for (size_t v = 0; v < n; v += 5) {
+        g->GetVertex(v)->transfer.SetCost(Transport::Feet, Transport::Bus, 1);
+    }
+
+    const int64_t budget = 12;
+    ListSequence<size_t> origins;
+    for (size_t from = 0; from < 8; ++from) {
+        origins.Append(from);
+    }
+    ArraySequence<ReachedStates> all = ExploreWithinBudget(*g, origins, budget, 4);
+    REQUIRE(all.GetLength() == 8);
+
+    SearchWorkspace workspace;
+    for (size_t from = 0; from < 8; ++from) {
+        ReachedStates reached = ExploreWithinBudget(*g, from, budget, workspace);
+        Dijkstra dijkstra(g, from);
+        std::vector<int64_t> best(n, -1);
+        int64_t last = 0;
+        for (const ReachedState& state : *reached) {
+            REQUIRE(state.cost <= budget);
+            REQUIRE(state.cost >= last);
+            last = state.cost;
+            if (best[state.vertex] == -1) {
+                best[state.vertex] = state.cost;
+            }
+        }
+        for (size_t v = 0; v < n; ++v) {
+            const int64_t expected = dijkstra.GetDistance(v);
+            REQUIRE(best[v] == (expected <= budget ? expected : -1));
+        }
+        REQUIRE(workspace.labels.GetSize() < GetStateCount(n));
+
+        const ReachedStates& parallel = all.Get(from);
+        REQUIRE(parallel->GetLength() == reached->GetLength());
+        for (size_t i = 0; i < reached->GetLength(); ++i) {
+            REQUIRE(parallel->Get(i).cost == reached->Get(i).cost);
+        }
+    }
+
+    REQUIRE(ExploreWithinBudget(*g, 0, -1)->GetLength() == 0);
+    REQUIRE(ExploreWithinBudget(*g, 0, 0)->GetLength() >= 1);
+    REQUIRE_THROWS_AS(ExploreWithinBudget(*g, n, 5), std::out_of_range);
+}
+
+TEST_CASE("StateTable") {
+    StateTable table;
+    for (size_t state = 0; state < 1000; state += 3) {
+        table.FindOrInsert(state).distance = static_cast<int64_t>(state);
+    }
+    REQUIRE(table.GetSize() == 334);
+    REQUIRE(table.GetDistance(999) == 999);
+    REQUIRE(table.GetDistance(1) == kInf);
+    REQUIRE(table.Find(2) == nullptr);
+    table.Clear();
+    REQUIRE(table.GetSize() == 0);
+    REQUIRE(table.Find(999) == nullptr);
+}
+
+TEST_CASE("YenKShortestPaths") {
+    std::mt19937 rng(5);
+    const size_t n = 7;
+    auto g = std::make_shared<DirectedGraph>(n);
+    std::uniform_int_distribution<int64_t> weight(1, 6);
+    std::bernoulli_distribution has_edge(0.35);
+    for (size_t u = 0; u < n; ++u) {
+        for (size_t v = 0; v < n; ++v) {
+            if (u != v && has_edge(rng)) {
+                g->AddEdge({u, v, weight(rng)});
+            }
+        }
+    }
+    g->GetVertex(2)->transfer.SetCost(Transport::Feet, Transport::Car, 1);
+    g->GetVertex(4)->transfer.SetCost(Transport::Car, Transport::Bus, 2);
+
+    // Costs of all loopless state paths from 0 to target, enumerated exhaustively.
+    const size_t target = n - 1;
+    std::vector<int64_t> expected;
+    std::vector<bool> on_path(GetStateCount(n), false);
+    std::function<void(size_t, int64_t)> enumerate = [&](size_t state, int64_t cost) {
+        if (DecodeVertex(state) == target) {
+            expected.push_back(cost);
+            return;
+        }
+        on_path[state] = true;
+        VertexPtr vertex = g->GetVertex(DecodeVertex(state));
+        for (Transport next : kAllTransports) {
+            const int64_t step = vertex->transfer.GetCost(DecodeTransport(state), next);
+            const size_t to = EncodeState(vertex->id, next);
+            if (step < kNoTransferCost && !on_path[to]) {
+                enumerate(to, cost + step);
+            }
+        }
+        for (const Arc& arc : *vertex->arcs) {
+            const size_t to = EncodeState(arc.vertex->id, DecodeTransport(state));
+            if (!on_path[to]) {
+                enumerate(to, cost + arc.weight);
+            }
+        }
+        on_path[state] = false;
+    };
+    enumerate(EncodeState(0, kSourceTransport), 0);
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(expected.size() >= 3);
+
+    YenKShortestPaths yen(g, 4);
+    const size_t k = std::min<size_t>(expected.size() + 2, 25);
+    RankedPaths paths = yen.Find(0, target, k);
+    REQUIRE(paths->GetLength() == std::min(k, expected.size()));
+    REQUIRE(paths->Get(0).cost == Dijkstra(g, 0).GetDistance(target));
+    for (size_t i = 0; i < paths->GetLength(); ++i) {
+        const RankedPath& path = paths->Get(i);
+        REQUIRE(path.cost == expected[i]);
+        REQUIRE(path.steps->Get(0).vertex == 0);
+        REQUIRE(path.steps->GetLast().vertex == target);
+        for (size_t j = 0; j < i; ++j) {
+            const PathSteps& other = paths->Get(j).steps;
+            bool same = other->GetLength() == path.steps->GetLength();
+            for (size_t s = 0; same && s < other->GetLength(); ++s) {
+                same = other->Get(s).vertex == path.steps->Get(s).vertex &&
+                       other->Get(s).transport == path.steps->Get(s).transport;
+            }
+            REQUIRE(!same);
+        }
+    }
+
+    // The same object answers further queries with its reused workspaces.
+    REQUIRE(yen.Find(0, target, 1)->Get(0).cost == expected[0]);
+    REQUIRE(yen.Find(0, target, 0)->GetLength() == 0);
+    REQUIRE(yen.Find(3, 3, 4)->GetLength() == 1);
+    REQUIRE_THROWS_AS(yen.Find(0, n, 2), std::out_of_range);
+}
+
+static ArraySequence<Breakpoint> Breakpoints(const std::vector<Breakpoint>& points) {
+    return ArraySequence<Breakpoint>(points.data(), points.size());
+}
+
+// Linear interpolation between two profile points; kInf when either end is unreachable.
+static int64_t ProfileArrival(const ProfilePoint& a, const ProfilePoint& b, int64_t departure) {
+    if (a.arrival == kInf || b.arrival == kInf) {
+        return departure == a.departure ? a.arrival : departure == b.departure ? b.arrival : kInf;
+    }
+    const int64_t numerator = (b.arrival - a.arrival) * (departure - a.departure);
+    REQUIRE(numerator % (b.departure - a.departure) == 0);
+    return a.arrival + numerator / (b.departure - a.departure);
+}
+
+TEST_CASE("TimeDependentSearch") {
+    SECTION("travel time functions") {
+        auto g = std::make_shared<DirectedGraph>(2);
+        const size_t edge = g->AddEdge({0, 1, 7});
+        const Arc arc = g->GetVertex(0)->arcs->Get(0);
+        TravelTimeFunctions functions;
+        REQUIRE(functions.GetTravelTime(arc, Transport::Car, 3) == 7);
+        functions.Set(edge, Transport::Car, Breakpoints({{0, 10}, {10, 20}, {20, 12}}));
+        REQUIRE(functions.Contains(edge, Transport::Car));
+        REQUIRE(!functions.Contains(edge, Transport::Bus));
+        REQUIRE(functions.GetTravelTime(arc, Transport::Car, -5) == 10);
+        REQUIRE(functions.GetTravelTime(arc, Transport::Car, 5) == 15);
+        REQUIRE(functions.GetTravelTime(arc, Transport::Car, 15) == 16);
+        REQUIRE(functions.GetTravelTime(arc, Transport::Car, 99) == 12);
+        REQUIRE(functions.GetTravelTime(arc, Transport::Bus, 5) == 7);
+        REQUIRE(functions.GetBreakpointCount() == 3);
+        functions.Set(edge, Transport::Car, Breakpoints({{0, 1}, {10, 2}, {20, 3}}));
+        REQUIRE(functions.GetBreakpointCount() == 3);
+        REQUIRE_THROWS_AS(functions.Set(edge, Transport::Car, Breakpoints({{0, 20}, {5, 10}})),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(functions.Set(edge, Transport::Car, Breakpoints({{5, 1}, {5, 2}})),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(functions.Set(edge, Transport::Car, Breakpoints({})), std::invalid_argument);
+
+        // A live feed resizing its profiles keeps the pools bounded and the other functions intact.
+        const size_t far_edge = size_t{1} << 40;
+        functions.Set(far_edge, Transport::Bus, Breakpoints({{0, 4}}));
+        for (int64_t round = 0; round < 200; ++round) {
+            ArraySequence<Breakpoint> points;
+            for (int64_t t = 0; t <= round % 7; ++t) {
+                points.Append({t * 10, round + t});
+            }
+            functions.Set(edge, Transport::Car, points);
+            REQUIRE(functions.GetPooledCount() <= 2 * functions.GetBreakpointCount());
+            REQUIRE(functions.GetTravelTime(arc, Transport::Car, 0) == round);
+        }
+        REQUIRE(functions.GetBreakpointCount() == 1 + 199 % 7 + 1);
+        REQUIRE(functions.Contains(far_edge, Transport::Bus));
+        REQUIRE_FALSE(functions.Contains(far_edge - 1, Transport::Bus));
+        Arc far_arc = arc;
+        far_arc.edge_id = far_edge;
+        REQUIRE(functions.GetTravelTime(far_arc, Transport::Bus, 100) == 4);
+    }
+
+    SECTION("kink hidden between collinear samples") {
+        // Arrivals (0, 100), (40, 100), (60, 120), (100, 120): the midpoint lies on the chord of the ends.
+        auto path = std::make_shared<DirectedGraph>(2);
+        const size_t edge = path->AddEdge({0, 1, 1000});
+        TravelTimeFunctions functions;
+        for (Transport transport : kAllTransports) {
+            functions.Set(edge, transport, Breakpoints({{0, 100}, {40, 60}, {60, 60}, {100, 20}}));
+        }
+        SearchWorkspace workspace;
+        const ArraySequence<ProfilePoint> profile = FindProfile(*path, functions, 0, 1, 0, 100);
+        REQUIRE(profile.GetLength() == 4);
+        REQUIRE(profile.Get(1).departure == 40);
+        REQUIRE(profile.Get(2).arrival == 120);
+        size_t segment = 0;
+        for (int64_t departure = 0; departure <= 100; ++departure) {
+            while (profile.Get(segment + 1).departure < departure) {
+                ++segment;
+            }
+            REQUIRE(ProfileArrival(profile.Get(segment), profile.Get(segment + 1), departure) ==
+                    FindEarliestArrival(*path, functions, 0, 1, departure, workspace));
+        }
+    }
+
+    std::mt19937 rng(21);
+    const size_t n = 40;
+    auto g = std::make_shared<Graph>(n);
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_int_distribution<int64_t> weight(1, 20);
+    ArraySequence<size_t> edges;
+    for (size_t i = 0; i < 120; ++i) {
+        edges.Append(g->AddEdge({vertex(rng), vertex(rng), weight(rng)}));
+    }
+    for (size_t v = 0; v < n; v += 3) {
+        g->GetVertex(v)->transfer.SetCost(Transport::Feet, Transport::Car, 2);
+    }
+
+    SECTION("static functions match Dijkstra") {
+        auto functions = std::make_shared<TravelTimeFunctions>();
+        TimeDependentDijkstra td(g, functions, 0, 100);
+        Dijkstra dijkstra(g, 0);
+        for (size_t v = 0; v < n; ++v) {
+            REQUIRE(td.GetDistance(v) == dijkstra.GetDistance(v));
+            if (dijkstra.GetDistance(v) != kInf) {
+                REQUIRE(td.GetArrivalTime(v) == 100 + dijkstra.GetDistance(v));
+            }
+        }
+    }
+
+    SECTION("profile") {
+        auto functions = std::make_shared<TravelTimeFunctions>();
+        std::uniform_int_distribution<int64_t> duration(1, 30);
+        for (size_t edge : edges) {
+            ArraySequence<Breakpoint> points;
+            int64_t last = duration(rng);
+            for (int64_t t = 0; t <= 200; t += 25) {
+                last = std::max<int64_t>(1, last + duration(rng) - 15);
+                points.Append({t, last});
+            }
+            functions->Set(edge, Transport::Car, points);
+        }
+        SearchWorkspace workspace;
+        const size_t to = n - 1;
+        const ArraySequence<ProfilePoint> profile = FindProfile(*g, *functions, 0, to, 0, 200);
+        REQUIRE(profile.Get(0).departure == 0);
+        REQUIRE(profile.GetLast().departure == 200);
+        for (size_t i = 0; i < profile.GetLength(); ++i) {
+            const ProfilePoint& point = profile.Get(i);
+            REQUIRE(point.arrival == FindEarliestArrival(*g, *functions, 0, to, point.departure, workspace));
+            if (i > 0) {
+                REQUIRE(profile.Get(i - 1).departure < point.departure);
+                REQUIRE(profile.Get(i - 1).arrival <= point.arrival);
+            }
+        }
+        for (int64_t departure = 0; departure <= 200; departure += 7) {
+            TimeDependentDijkstra td(g, functions, 0, departure);
+            REQUIRE(td.GetArrivalTime(to) == FindEarliestArrival(*g, *functions, 0, to, departure, workspace));
+        }
+        size_t segment = 0;
+        for (int64_t departure = 0; departure <= 200; ++departure) {
+            while (profile.Get(segment + 1).departure < departure) {
+                ++segment;
+            }
+            REQUIRE(ProfileArrival(profile.Get(segment), profile.Get(segment + 1), departure) ==
+                    FindEarliestArrival(*g, *functions, 0, to, departure, workspace));
+        }
+        REQUIRE(FindProfile(*g, *functions, 0, to, 5, 5).GetLength() == 1);
+        REQUIRE_THROWS_AS(FindProfile(*g, *functions, 0, to, 5, 4), std::invalid_argument);
+    }
+}
+
+TEST_CASE("ArcModes") {
+    REQUIRE(sizeof(ArcModes) == 16);
+
+    SECTION("restricted edges") {
+        auto g = std::make_shared<DirectedGraph>(3);
+        g->AddEdge({0, 1, 1, ArcModes::Only(TransportBit(Transport::Bus))});
+        g->AddEdge({0, 1, 10, ArcModes::Only(TransportBit(Transport::Feet))});
+        ArcModes slow_car;
+        slow_car.extra[ToTransportIndex(Transport::Car)] = 5;
+        g->AddEdge({1, 2, 1, slow_car});
+        REQUIRE(g->GetEdge(0).modes.mask == TransportBit(Transport::Bus));
+        REQUIRE(g->GetEdge(2).GetWeight(Transport::Car) == 6);
+
+        REQUIRE(Dijkstra(g, 0).GetDistance(1) == 10);
+        g->GetVertex(0)->transfer.SetCost(Transport::Feet, Transport::Bus, 2);
+        Dijkstra dijkstra(g, 0);
+        REQUIRE(dijkstra.GetDistance(1) == 3);
+        REQUIRE(dijkstra.GetShortestPathWithTransfers(1)->GetLast().transport == Transport::Bus);
+        g->GetVertex(0)->transfer.SetCost(Transport::Feet, Transport::Car, 0);
+        REQUIRE(Dijkstra(g, 0).GetDistance(2) == 4);
+        REQUIRE_THROWS_AS(CompactGraph64::FromGraph(*g), std::invalid_argument);
+    }
+
+    std::mt19937 rng(37);
+    const size_t n = 50;
+    auto g = std::make_shared<Graph>(n);
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_int_distribution<int64_t> weight(1, 9);
+    std::uniform_int_distribution<int> mask(1, static_cast<int>(kAllTransportsMask));
+    std::uniform_int_distribution<int32_t> extra(0, 4);
+    for (size_t i = 0; i < 160; ++i) {
+        ArcModes modes = ArcModes::Only(static_cast<TransportMask>(mask(rng)));
+        for (int32_t& e : modes.extra) {
+            e = extra(rng);
+        }
+        g->AddEdge({vertex(rng), vertex(rng), weight(rng), modes});
+    }
+    for (size_t v = 0; v < n; v += 2) {
+        g->GetVertex(v)->transfer = TransferMatrix::Uniform(1);
+    }
+
+    Dijkstra dijkstra(g, 0);
+    FordBellman ford_bellman(g, 0);
+    IncrementalShortestPaths incremental(g, 0);
+    TimeDependentDijkstra td(g, std::make_shared<TravelTimeFunctions>(), 0, 0);
+    YenKShortestPaths yen(g, 2);
+    std::vector<int64_t> budget(n, -1);
+    for (const ReachedState& state : *ExploreWithinBudget(*g, 0, 1000)) {
+        if (budget[state.vertex] == -1) {
+            budget[state.vertex] = state.cost;
+        }
+    }
+    for (size_t v = 0; v < n; ++v) {
+        const int64_t expected = dijkstra.GetDistance(v);
+        REQUIRE(ford_bellman.GetDistance(v) == expected);
+        REQUIRE(incremental.GetDistance(v) == expected);
+        REQUIRE(td.GetDistance(v) == expected);
+        REQUIRE(budget[v] == (expected == kInf ? -1 : expected));
+        if (expected != kInf) {
+            REQUIRE(yen.Find(0, v, 1)->Get(0).cost == expected);
+        }
+    }
+
+    ArraySequence<EdgeUpdate> updates;
+    updates.Append({3, 1});
+    updates.Append({7, 0, true});
+    incremental.ApplyUpdates(updates);
+    Dijkstra updated(g, 0);
+    for (size_t v = 0; v < n; ++v) {
+        REQUIRE(incremental.GetDistance(v) == updated.GetDistance(v));
+    }
+}
+
+static TransitRoute MakeRoute(const std::vector<size_t>& stops, const std::vector<StopTime>& times) {
+    return {ArraySequence<size_t>(stops.data(), stops.size()), ArraySequence<StopTime>(times.data(), times.size())};
+}
+
+TEST_CASE("Raptor") {
+    SECTION("timetable") {
+        ArraySequence<TransitRoute> routes;
+        routes.Append(MakeRoute({0, 1, 2}, {{20, 20}, {25, 26}, {30, 30}, {10, 10}, {15, 16}, {20, 20}}));
+        const Timetable timetable(4, routes);
+        REQUIRE(timetable.GetTripCount(0) == 2);
+        REQUIRE(timetable.GetStopTimes(0, 1)[0].departure == 16);
+        REQUIRE(timetable.GetStopTimes(0, 1)[1].departure == 26);
+        REQUIRE(timetable.FindEarliestTrip(0, 1, 17) == 1);
+        REQUIRE(timetable.FindEarliestTrip(0, 1, 27) == 2);
+        REQUIRE(timetable.GetRoutes(2).size() == 1);
+        REQUIRE(timetable.GetRoutes(3).empty());
+
+        ArraySequence<TransitRoute> overtaking;
+        overtaking.Append(MakeRoute({0, 1}, {{10, 10}, {30, 30}, {12, 12}, {20, 20}}));
+        REQUIRE_THROWS_AS(Timetable(2, overtaking), std::invalid_argument);
+        ArraySequence<TransitRoute> backwards;
+        backwards.Append(MakeRoute({0, 1}, {{10, 10}, {5, 5}}));
+        REQUIRE_THROWS_AS(Timetable(2, backwards), std::invalid_argument);
+    }
+
+    SECTION("transfer with walking") {
+        auto streets = std::make_shared<Graph>(6);
+        streets->AddEdge({3, 4, 5});
+        streets->AddEdge({0, 2, 100});
+        streets->AddEdge({2, 5, 1, ArcModes::Only(TransportBit(Transport::Car))});
+        ArraySequence<TransitRoute> routes;
+        routes.Append(MakeRoute({0, 1, 2}, {{10, 10}, {14, 14}, {18, 18}, {20, 20}, {24, 24}, {28, 28}}));
+        routes.Append(MakeRoute({2, 3}, {{25, 25}, {30, 30}, {40, 40}, {45, 45}}));
+        Raptor raptor(std::make_shared<Timetable>(6, routes), streets);
+
+        const TransitJourney journey = raptor.Query(0, 4, 0);
+        REQUIRE(journey.arrival == 35);
+        REQUIRE(journey.rides == 2);
+        REQUIRE(journey.legs.GetLength() == 3);
+        REQUIRE(journey.legs.Get(0).route == 0);
+        REQUIRE(journey.legs.Get(0).departure == 10);
+        REQUIRE(journey.legs.Get(1).from == 2);
+        REQUIRE(journey.legs.Get(1).departure == 25);
+        REQUIRE(journey.legs.Get(2).route == kWalkLeg);
+        REQUIRE(journey.legs.Get(2).to == 4);
+
+        REQUIRE(raptor.Query(0, 4, 15).arrival == 50);
+        REQUIRE(raptor.Query(0, 2, 50).arrival == 150);
+        REQUIRE(raptor.Query(0, 2, 50).rides == 0);
+        REQUIRE(raptor.Query(0, 5, 0).arrival == kInf);
+        REQUIRE(raptor.Query(1, 1, 7).legs.GetLength() == 0);
+        REQUIRE_THROWS_AS(raptor.Query(0, 6, 0), std::out_of_range);
+    }
+
+    SECTION("matches fixed point") {
+        std::mt19937 rng(38);
+        const size_t n = 30;
+        auto streets = std::make_shared<Graph>(n);
+        std::uniform_int_distribution<size_t> vertex(0, n - 1);
+        std::uniform_int_distribution<int64_t> walk(5, 40);
+        for (size_t i = 0; i < 25; ++i) {
+            streets->AddEdge({vertex(rng), vertex(rng), walk(rng)});
+        }
+        ArraySequence<TransitRoute> routes;
+        std::uniform_int_distribution<int64_t> hop(1, 10);
+        for (size_t r = 0; r < 8; ++r) {
+            std::vector<size_t> stops;
+            for (size_t j = 0; j < 5; ++j) {
+                stops.push_back(vertex(rng));
+            }
+            std::vector<int64_t> hops;
+            for (size_t j = 0; j < stops.size(); ++j) {
+                hops.push_back(hop(rng));
+            }
+            std::vector<StopTime> times;
+            for (int64_t start = 0; start < 200; start += 15 + static_cast<int64_t>(r)) {
+                int64_t t = start;
+                for (size_t j = 0; j < stops.size(); ++j) {
+                    times.push_back({t, t + 1});
+                    t += 1 + hops[j];
+                }
+            }
+            routes.Append(MakeRoute(stops, times));
+        }
+        auto timetable = std::make_shared<Timetable>(n, routes);
+        Raptor raptor(timetable, streets, 30);
+
+        for (size_t from = 0; from < 5; ++from) {
+            const int64_t departure = 7 * static_cast<int64_t>(from);
+            // Relax walks and rides until nothing improves.
+            std::vector<int64_t> best(n, kInf);
+            best[from] = departure;
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (size_t v = 0; v < n; ++v) {
+                    for (const Arc& arc : *streets->GetVertex(v)->arcs) {
+                        if (best[v] != kInf && best[v] + arc.weight < best[arc.vertex->id]) {
+                            best[arc.vertex->id] = best[v] + arc.weight;
+                            changed = true;
+                        }
+                    }
+                }
+                for (size_t r = 0; r < timetable->GetRouteCount(); ++r) {
+                    const std::span<const size_t> stops = timetable->GetStops(r);
+                    for (size_t t = 0; t < timetable->GetTripCount(r); ++t) {
+                        bool boarded = false;
+                        for (size_t j = 0; j < stops.size(); ++j) {
+                            const StopTime time = timetable->GetStopTimes(r, j)[t];
+                            if (boarded && time.arrival < best[stops[j]]) {
+                                best[stops[j]] = time.arrival;
+                                changed = true;
+                            }
+                            boarded = boarded || best[stops[j]] <= time.departure;
+                        }
+                    }
+                }
+            }
+            for (size_t to = 0; to < n; ++to) {
+                const TransitJourney journey = raptor.Query(from, to, departure);
+                REQUIRE(journey.arrival == best[to]);
+                if (journey.arrival == kInf) {
+                    continue;
+                }
+                size_t at = from;
+                int64_t time = departure;
+                for (const TransitLeg& leg : journey.legs) {
+                    REQUIRE(leg.from == at);
+                    REQUIRE(leg.departure >= time);
+                    at = leg.to;
+                    time = leg.arrival;
+                }
+                REQUIRE(at == to);
+                REQUIRE(time == journey.arrival);
+            }
+        }
+    }
+}
+
+TEST_CASE("ParetoSearch") {
+    std::mt19937 rng(39);
+    const size_t n = 8;
+    auto g = std::make_shared<DirectedGraph>(n);
+    std::uniform_int_distribution<int64_t> weight(1, 9);
+    std::uniform_int_distribution<int> mask(1, static_cast<int>(kAllTransportsMask));
+    std::bernoulli_distribution has_edge(0.3);
+    for (size_t u = 0; u < n; ++u) {
+        for (size_t v = 0; v < n; ++v) {
+            if (u != v && has_edge(rng)) {
+                g->AddEdge({u, v, weight(rng), ArcModes::Only(static_cast<TransportMask>(mask(rng)))});
+            }
+        }
+        g->GetVertex(u)->transfer = TransferMatrix::Uniform(static_cast<int64_t>(u % 3));
+    }
+
+    using Criteria = std::tuple<int64_t, size_t, int64_t>;
+    auto front = [](std::vector<Criteria> all) {
+        std::sort(all.begin(), all.end());
+        all.erase(std::unique(all.begin(), all.end()), all.end());
+        std::vector<Criteria> res;
+        for (const Criteria& c : all) {
+            bool dominated = false;
+            for (const Criteria& other : all) {
+                dominated = dominated || (other != c && std::get<0>(other) <= std::get<0>(c) &&
+                                          std::get<1>(other) <= std::get<1>(c) && std::get<2>(other) <= std::get<2>(c));
+            }
+            if (!dominated) {
+                res.push_back(c);
+            }
+        }
+        return res;
+    };
+    // Criteria of all loopless state paths, with arc count as the third criterion when asked.
+    auto enumerate = [&](size_t target, bool hops) {
+        std::vector<Criteria> all;
+        std::vector<bool> on_path(GetStateCount(n), false);
+        std::function<void(size_t, Criteria)> visit = [&](size_t state, Criteria c) {
+            if (DecodeVertex(state) == target) {
+                all.push_back(c);
+                return;
+            }
+            on_path[state] = true;
+            VertexPtr vertex = g->GetVertex(DecodeVertex(state));
+            const Transport transport = DecodeTransport(state);
+            for (Transport next : kAllTransports) {
+                const size_t to = EncodeState(vertex->id, next);
+                if (next != transport && !on_path[to]) {
+                    visit(to, {std::get<0>(c) + vertex->transfer.GetCost(transport, next), std::get<1>(c) + 1,
+                               std::get<2>(c)});
+                }
+            }
+            for (const Arc& arc : *vertex->arcs) {
+                const size_t to = EncodeState(arc.vertex->id, transport);
+                if (arc.Allows(transport) && !on_path[to]) {
+                    visit(to, {std::get<0>(c) + arc.GetWeight(transport), std::get<1>(c), std::get<2>(c) + (hops ? 1 : 0)});
+                }
+            }
+            on_path[state] = false;
+        };
+        visit(EncodeState(0, kSourceTransport), {0, 0, 0});
+        return front(all);
+    };
+    auto criteria = [](const ParetoPaths& paths) {
+        std::vector<Criteria> res;
+        for (const ParetoPath& path : *paths) {
+            res.push_back({path.cost, path.transfers, path.extra});
+        }
+        return res;
+    };
+
+    ParetoSearch search(g);
+    ParetoOptions options;
+    options.criterion = [](const Arc&, Transport) { return int64_t{1}; };
+    ParetoSearch with_hops(g, options);
+    for (size_t to = 1; to < n; ++to) {
+        const ParetoPaths paths = search.Find(0, to);
+        REQUIRE(criteria(paths) == enumerate(to, false));
+        REQUIRE(criteria(with_hops.Find(0, to)) == enumerate(to, true));
+        if (paths->GetLength() == 0) {
+            continue;
+        }
+        REQUIRE(paths->Get(0).cost == Dijkstra(g, 0).GetDistance(to));
+        for (const ParetoPath& path : *paths) {
+            size_t transfers = 0;
+            for (size_t i = 0; i < path.steps->GetLength(); ++i) {
+                transfers += path.steps->Get(i).is_transfer ? 1 : 0;
+            }
+            REQUIRE(transfers == path.transfers);
+            REQUIRE(path.steps->Get(0).vertex == 0);
+            REQUIRE(path.steps->GetLast().vertex == to);
+        }
+    }
+
+    ParetoOptions no_transfers;
+    no_transfers.max_transfers = 0;
+    ParetoSearch walking(g, no_transfers);
+    for (size_t to = 1; to < n; ++to) {
+        for (const ParetoPath& path : *walking.Find(0, to)) {
+            REQUIRE(path.transfers == 0);
+        }
+    }
+    REQUIRE(search.Find(2, 2)->GetLength() == 1);
+    REQUIRE(search.GetLabelCount() == 1);
+    REQUIRE_THROWS_AS(search.Find(0, n), std::out_of_range);
+}
+
+TEST_CASE("ResourceConstrainedShortestPaths") {
+    std::mt19937 rng(40);
+    const size_t n = 8;
+    auto g = std::make_shared<Graph>(n);
+    auto resources = std::make_shared<EdgeResources>(2);
+    std::uniform_int_distribution<int64_t> weight(1, 9);
+    std::uniform_int_distribution<int64_t> amount(0, 6);
+    std::bernoulli_distribution has_edge(0.3);
+    for (size_t u = 0; u < n; ++u) {
+        for (size_t v = u + 1; v < n; ++v) {
+            if (has_edge(rng)) {
+                const size_t edge = g->AddEdge({u, v, weight(rng)});
+                resources->Set(edge, 0, amount(rng));
+                resources->Set(edge, 1, amount(rng));
+            }
+        }
+        g->GetVertex(u)->transfer = TransferMatrix::Uniform(1);
+    }
+    REQUIRE(resources->Get(1000, 1) == 0);
+    REQUIRE_THROWS_AS(resources->Set(0, 2, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(resources->Set(0, 0, -1), std::invalid_argument);
+
+    // Cheapest cost over all loopless state paths within the limits.
+    auto brute_force = [&](size_t target, int64_t limit0, int64_t limit1) {
+        int64_t best = kInf;
+        std::vector<bool> on_path(GetStateCount(n), false);
+        std::function<void(size_t, int64_t, int64_t, int64_t)> visit = [&](size_t state, int64_t cost, int64_t r0,
+                                                                           int64_t r1) {
+            if (r0 > limit0 || r1 > limit1) {
+                return;
+            }
+            if (DecodeVertex(state) == target) {
+                best = std::min(best, cost);
+                return;
+            }
+            on_path[state] = true;
+            VertexPtr vertex = g->GetVertex(DecodeVertex(state));
+            const Transport transport = DecodeTransport(state);
+            for (Transport next : kAllTransports) {
+                const size_t to = EncodeState(vertex->id, next);
+                if (next != transport && !on_path[to]) {
+                    visit(to, cost + 1, r0, r1);
+                }
+            }
+            for (const Arc& arc : *vertex->arcs) {
+                const size_t to = EncodeState(arc.vertex->id, transport);
+                if (!on_path[to]) {
+                    visit(to, cost + arc.weight, r0 + resources->Get(arc.edge_id, 0),
+                          r1 + resources->Get(arc.edge_id, 1));
+                }
+            }
+            on_path[state] = false;
+        };
+        visit(EncodeState(0, kSourceTransport), 0, 0, 0);
+        return best;
+    };
+
+    ResourceConstrainedShortestPaths solver(g, resources);
+    Dijkstra dijkstra(g, 0);
+    for (size_t to = 1; to < n; ++to) {
+        ArraySequence<int64_t> unlimited(2, 1000);
+        REQUIRE(solver.Find(0, to, unlimited).cost == dijkstra.GetDistance(to));
+        for (int64_t limit0 : {0, 3, 8}) {
+            for (int64_t limit1 : {2, 6, 20}) {
+                ArraySequence<int64_t> limits;
+                limits.Append(limit0);
+                limits.Append(limit1);
+                const ResourcePath path = solver.Find(0, to, limits);
+                REQUIRE(path.cost == brute_force(to, limit0, limit1));
+                if (path.cost == kInf) {
+                    REQUIRE(path.steps == nullptr);
+                    continue;
+                }
+                REQUIRE(path.resources.Get(0) <= limit0);
+                REQUIRE(path.resources.Get(1) <= limit1);
+                REQUIRE(path.steps->Get(0).vertex == 0);
+                REQUIRE(path.steps->GetLast().vertex == to);
+            }
+        }
+    }
+    REQUIRE_THROWS_AS(solver.Find(0, 1, ArraySequence<int64_t>(1, 5)), std::invalid_argument);
+    REQUIRE_THROWS_AS(solver.Find(0, 1, ArraySequence<int64_t>(2, -1)), std::invalid_argument);
+}
+
+TEST_CASE("SolverStats") {
+    std::mt19937 rng(41);
+    const size_t n = 40;
+    auto g = std::make_shared<DirectedGraph>(n);
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_int_distribution<int64_t> weight(1, 9);
+    for (size_t i = 0; i < 120; ++i) {
+        g->AddEdge({vertex(rng), vertex(rng), weight(rng)});
+    }
+    for (size_t v = 0; v < n; v += 4) {
+        g->GetVertex(v)->transfer.SetCost(Transport::Feet, Transport::Car, 2);
+    }
+
+    Dijkstra dijkstra(g, 0);
+    FordBellman ford_bellman(g, 0);
+    IncrementalShortestPaths incremental(g, 0);
+    const SolverStats& stats = dijkstra.GetStats();
+    if constexpr (!kSolverStatsEnabled) {
+        REQUIRE(stats.settled_states == 0);
+        REQUIRE(stats.relaxed_arcs == 0);
+        REQUIRE(ford_bellman.GetStats().bellman_ford_passes == 0);
+        REQUIRE(stats.GetPhaseNs(SolverPhase::Search) == 0);
+        return;
+    }
+
+    const ShortestPathTree tree = dijkstra.GetShortestPathTree();
+    size_t reachable = 0;
+    uint64_t arcs = 0;
+    uint64_t transfers = 0;
+    for (size_t state = 0; state < GetStateCount(n); ++state) {
+        if (tree.Contains(state)) {
+            ++reachable;
+            VertexPtr v = g->GetVertex(DecodeVertex(state));
+            arcs += v->arcs->GetLength();
+            for (Transport next : kAllTransports) {
+                transfers += v->transfer.GetCost(DecodeTransport(state), next) < kNoTransferCost ? 1 : 0;
+            }
+        }
+    }
+    REQUIRE(stats.settled_states == reachable);
+    REQUIRE(stats.queue_pops == reachable);
+    REQUIRE(stats.relaxed_arcs == arcs);
+    REQUIRE(stats.transfer_relaxations == transfers);
+    REQUIRE(stats.successful_relaxations >= reachable - 1);
+    REQUIRE(stats.peak_memory_bytes >= dijkstra.GetMemoryUsage());
+
+    const SolverStats& fb = ford_bellman.GetStats();
+    REQUIRE(fb.bellman_ford_passes >= 1);
+    REQUIRE(fb.relaxed_arcs >= arcs);
+    REQUIRE(fb.settled_states == 0);
+
+    REQUIRE(incremental.GetStats().settled_states >= reachable);
+    REQUIRE(incremental.GetStats().queue_pushes >= incremental.GetStats().settled_states);
+    ArraySequence<EdgeUpdate> updates;
+    updates.Append({0, 1});
+    incremental.ApplyUpdates(updates);
+    REQUIRE(incremental.GetStats().settled_states == incremental.GetLastRepairSize());
+    REQUIRE(incremental.GetStats().queue_pops >= incremental.GetStats().settled_states);
+}
+
+TEST_CASE("PerfCounters") {
+    PerfCounters counters;
+    counters.Start();
+    volatile int64_t sum = 0;
+    for (int i = 0; i < 100000; ++i) {
+        sum = sum + i;
+    }
+    const PerfSample sample = counters.Stop();
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        REQUIRE(sample.values[i] >= kPerfUnavailable);
+        REQUIRE((!sample.scaled[i] || sample.values[i] != kPerfUnavailable));
+    }
+    if (sample.Get(PerfEvent::Instructions) != kPerfUnavailable) {
+        REQUIRE(sample.Get(PerfEvent::Instructions) > 100000);
+    }
+    REQUIRE(counters.IsAvailable() == (std::count(sample.values.begin(), sample.values.end(), kPerfUnavailable) <
+                                       static_cast<std::ptrdiff_t>(kPerfEventCount)));
+    REQUIRE(std::string(PerfCounters::GetName(PerfEvent::DtlbMisses)) == "dtlb_misses");
+}
+
+static void RequireSameGraph(const IGraph& a, const IGraph& b) {
+    REQUIRE(a.GetVertexCount() == b.GetVertexCount());
+    REQUIRE(a.GetEdgeCount() == b.GetEdgeCount());
+    size_t mismatches = 0;
+    for (size_t v = 0; v < a.GetVertexCount(); ++v) {
+        mismatches += ArcVertices(a.GetArcs(v)) != ArcVertices(b.GetArcs(v));
+    }
+    for (size_t id = 0; id < a.GetEdgeCount(); ++id) {
+        const Edge x = a.GetEdge(id);
+        const Edge y = b.GetEdge(id);
+        mismatches += x.u != y.u || x.v != y.v || x.weight != y.weight;
+    }
+    REQUIRE(mismatches == 0);
+}
+
+static bool SameEdges(const Sequence<Edge>& a, const Sequence<Edge>& b) {
+    if (a.GetLength() != b.GetLength()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.GetLength(); ++i) {
+        if (a.Get(i).u != b.Get(i).u || a.Get(i).v != b.Get(i).v || a.Get(i).weight != b.Get(i).weight) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string ParseError(const std::string& text, const EdgeListOptions& options = {}) {
+    try {
+        ParseEdgeList(text, options);
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return "";
+}
+
+TEST_CASE("EdgeListLoader") {
+    const std::string text =
+        "# road dump\n"
+        "from,to,weight\n"
+        "0,1,5\r\n"
+        "1 2\n"
+        "\n"
+        "% comment\n"
+        "  2\t3  -4\n"
+        "3, 0, +7\n"
+        "[transfers]\n"
+        "1 0 2 inf  1 0 -  3 3 0\n";
+
+    const EdgeList list = ParseEdgeList(text);
+    REQUIRE(list.vertex_count == 4);
+    REQUIRE(list.edges.GetLength() == 4);
+    REQUIRE(list.edges.Get(1).weight == 1);
+    REQUIRE(list.edges.Get(2).u == 2);
+    REQUIRE(list.edges.Get(2).weight == -4);
+    REQUIRE(list.edges.Get(3).weight == 7);
+    REQUIRE(list.transfers.GetLength() == 1);
+    REQUIRE(list.transfers.Get(0).vertex == 1);
+    REQUIRE(list.transfers.Get(0).transfer.GetCost(Transport::Bus, Transport::Car) == 2);
+    REQUIRE(list.transfers.Get(0).transfer.GetCost(Transport::Bus, Transport::Feet) == kNoTransferCost);
+    REQUIRE(list.transfers.Get(0).transfer.GetCost(Transport::Car, Transport::Feet) == kNoTransferCost);
+    REQUIRE(list.transfers.Get(0).transfer.GetCost(Transport::Feet, Transport::Bus) == 3);
+
+    std::istringstream in(text);
+    const EdgeList streamed = ReadEdgeList(in, {.vertex_count = 6});
+    REQUIRE(streamed.vertex_count == 6);
+    REQUIRE(streamed.edges.GetLength() == 4);
+    REQUIRE(streamed.transfers.GetLength() == 1);
+
+    IGraphPtr graph = BuildGraph(list, true);
+    REQUIRE(graph->IsDirected());
+    REQUIRE(graph->GetVertex(1)->transfer.GetCost(Transport::Feet, Transport::Bus) == 3);
+    REQUIRE(graph->GetVertex(0)->transfer.GetCost(Transport::Feet, Transport::Bus) == kNoTransferCost);
+
+    REQUIRE(ParseError("0 1\n1 x\n").find("line 2") != std::string::npos);
+    REQUIRE(ParseError("# c\n0 1 2 3\n").find("line 2") != std::string::npos);
+    REQUIRE(ParseError("0 1\n[nodes]\n").find("line 2") != std::string::npos);
+    REQUIRE(ParseError("0 1\n[transfers]\n0 1 2\n").find("line 3") != std::string::npos);
+    REQUIRE(ParseError("0 1\n2 5\n", {.vertex_count = 4}).find("line 2") != std::string::npos);
+    REQUIRE(ParseEdgeList("").edges.GetLength() == 0);
+    REQUIRE(ParseEdgeList("u v\n").vertex_count == 0);
+
+    // Several megabytes force parallel chunks; the result must match sequential parsing and construction.
+    std::mt19937 rng(43);
+    const size_t n = 5000;
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_int_distribution<int> weight(1, 1000);
+    std::string big = "u,v,w\n";
+    auto edges = std::make_shared<ArraySequence<Edge>>();
+    for (size_t i = 0; i < 300000; ++i) {
+        const Edge edge(vertex(rng), vertex(rng), weight(rng));
+        edges->Append(edge);
+        big += std::to_string(edge.u) + (i % 2 == 0 ? "," : " ") + std::to_string(edge.v) + " " +
+               std::to_string(edge.weight) + (i % 1000 == 0 ? "\n# checkpoint\n" : "\n");
+    }
+    const EdgeList parallel = ParseEdgeList(big, {.threads = 4});
+    std::istringstream big_in(big);
+    const EdgeList sequential = ReadEdgeList(big_in);
+    REQUIRE(SameEdges(parallel.edges, *edges));
+    REQUIRE(SameEdges(sequential.edges, *edges));
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "lab3_edge_list_test.txt";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << big;
+    }
+    const EdgeList loaded = LoadEdgeList(path.string(), {.threads = 3});
+    std::filesystem::remove(path);
+    REQUIRE(loaded.vertex_count == parallel.vertex_count);
+    REQUIRE(SameEdges(loaded.edges, *edges));
+
+    RequireSameGraph(*BuildGraph(loaded, false, 4), Graph(loaded.vertex_count, edges));
+    RequireSameGraph(*BuildGraph(loaded, true, 3), DirectedGraph(loaded.vertex_count, edges));
+    REQUIRE_THROWS_AS(LoadEdgeList(path.string()), std::invalid_argument);
+
+    // Self loops and skewed degrees: the bucketed build must keep sequential arc order for any split.
+    const size_t small_n = 50;
+    auto skewed = std::make_shared<ArraySequence<Edge>>();
+    for (size_t i = 0; i < 600; ++i) {
+        const size_t u = i % 3 == 0 ? 0 : rng() % small_n;
+        skewed->Append({u, i % 7 == 0 ? u : rng() % small_n, static_cast<int64_t>(i)});
+    }
+    for (size_t threads : {1, 2, 3, 7, 64}) {
+        std::shared_ptr<Graph> undirected = Graph::Build(small_n, *skewed, threads);
+        RequireSameGraph(*undirected, Graph(small_n, skewed));
+        RequireSameGraph(*DirectedGraph::Build(small_n, *skewed, threads), DirectedGraph(small_n, skewed));
+        ListSequence<EdgeUpdate> removal;
+        removal.Append({0, 0, true});
+        undirected->ApplyUpdates(removal);
+        Graph reference(small_n, skewed);
+        reference.ApplyUpdates(removal);
+        for (size_t v = 0; v < small_n; ++v) {
+            REQUIRE(ArcVertices(undirected->GetArcs(v)) == ArcVertices(reference.GetArcs(v)));
+        }
+    }
+}
+
+TEST_CASE("GraphImport") {
+    std::istringstream gr(
+        "c 9th DIMACS challenge sample\n"
+        "p sp 4 5\n"
+        "a 1 2 10\r\n"
+        "a 2 3 5\n"
+        "c interleaved comment\n"
+        "a 3 4 1\n"
+        "a 1 4 20\n"
+        "a 4 1 2\n");
+    std::istringstream co(
+        "p aux sp co 4\n"
+        "v 1 -73530767 41085396\n"
+        "v 2 -73530538 41086098\n"
+        "v 4 -73519366 41048796\n");
+    const GraphData dimacs = ReadDimacs(gr, &co);
+    REQUIRE(dimacs.graph->IsDirected());
+    REQUIRE(dimacs.graph->GetVertexCount() == 4);
+    REQUIRE(dimacs.graph->GetEdgeCount() == 5);
+    REQUIRE(dimacs.graph->GetEdge(1).u == 1);
+    REQUIRE(dimacs.graph->GetEdge(1).v == 2);
+    REQUIRE(dimacs.coordinates.GetLength() == 4);
+    REQUIRE(dimacs.coordinates.Get(0).x == -73.530767);
+    REQUIRE(dimacs.coordinates.Get(2).y == 0);
+    REQUIRE(dimacs.graph->GetVertex(3)->transfer.GetCost(Transport::Feet, Transport::Car) == 0);
+    REQUIRE(dimacs.graph->GetVertex(3)->transfer.GetCost(Transport::Bus, Transport::Car) == kNoTransferCost);
+    REQUIRE(Dijkstra(dimacs.graph, 0).GetDistance(3) == 16);
+
+    auto dimacs_error = [](const std::string& text) {
+        std::istringstream in(text);
+        try {
+            ReadDimacs(in);
+        } catch (const std::invalid_argument& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    REQUIRE(dimacs_error("a 1 2 3\n").find("line 1") != std::string::npos);
+    REQUIRE(dimacs_error("p sp 2 1\na 1 3 1\n").find("line 2") != std::string::npos);
+    REQUIRE(dimacs_error("p sp 2 2\na 1 2 1\n").find("declares 2 arcs") != std::string::npos);
+    REQUIRE(dimacs_error("p sp 2 1\na 1 2 1\na 2 1 1\n").find("line 3") != std::string::npos);
+    REQUIRE(dimacs_error("p sp 2 4000000000000\na 1 2 1\n").find("declares 4000000000000 arcs but has 1") !=
+            std::string::npos);
+
+    std::istringstream osm(
+        "u,v,key,osmid,oneway,length,u_lon,u_lat,v_lon,v_lat\n"
+        "9000000001,9000000002,0,\"[11, 12]\",True,12.6,30.1,59.9,30.2,59.8\n"
+        "9000000002,42,0,13,False,7.4,30.2,59.8,30.3,59.7\n"
+        "# dropped segment\n"
+        "42,9000000001,0,14,True,100,30.3,59.7,30.1,59.9\n");
+    const GraphData roads = ReadOsmEdges(osm, {.weight_scale = 10});
+    REQUIRE(roads.graph->GetVertexCount() == 3);
+    REQUIRE(roads.graph->GetEdgeCount() == 4);
+    REQUIRE(roads.external_ids.Get(2) == 42);
+    REQUIRE(roads.external_ids.Get(0) == 9000000001);
+    REQUIRE(roads.graph->GetEdge(0).weight == 126);
+    REQUIRE(roads.graph->GetEdge(2).u == 2);
+    REQUIRE(roads.graph->GetEdge(2).v == 1);
+    REQUIRE(roads.graph->GetEdge(3).weight == 1000);
+    REQUIRE(roads.coordinates.Get(2).x == 30.3);
+    REQUIRE(roads.coordinates.Get(1).y == 59.8);
+    // Empty cells keep their column instead of shifting the rest left.
+    std::istringstream sparse_osm(
+        "u,v,name,maxspeed,length,oneway\n"
+        "1,2,,,5,False\n"
+        "2,3,Main St,,7 , True\n"
+        "3,1,\"\",50,9,\n");
+    const GraphData sparse = ReadOsmEdges(sparse_osm);
+    REQUIRE(sparse.graph->GetEdgeCount() == 4);
+    REQUIRE(sparse.graph->GetEdge(0).weight == 5);
+    REQUIRE(sparse.graph->GetEdge(1).v == 0);
+    REQUIRE(sparse.graph->GetEdge(2).weight == 7);
+    REQUIRE(sparse.graph->GetEdge(3).weight == 9);
+    std::istringstream short_osm("u,v,name,length\n1,2,,5\n");
+    REQUIRE(ReadOsmEdges(short_osm).graph->GetEdge(0).weight == 5);
+    std::istringstream bad_osm("source target\n1 2\n3\n");
+    REQUIRE_THROWS_AS(ReadOsmEdges(bad_osm), std::invalid_argument);
+
+    // Round trip through the binary format keeps removed-edge renumbering, modes and transfers.
+    auto graph = std::make_shared<Graph>(4);
+    graph->AddEdge({0, 1, 3});
+    graph->AddEdge({1, 2, 4, ArcModes::Only(TransportBit(Transport::Car))});
+    graph->AddEdge({2, 3, 5});
+    graph->AddEdge({3, 0, -1});
+    graph->RemoveEdge(0);
+    graph->GetVertex(2)->transfer = TransferMatrix::Uniform(7);
+    GraphData data{graph, {}, {}};
+    std::stringstream buffer;
+    WriteGraphBinary(data, buffer);
+    const GraphData loaded = ReadGraphBinary(buffer, 2);
+    REQUIRE_FALSE(loaded.graph->IsDirected());
+    REQUIRE(loaded.graph->GetEdgeCount() == 3);
+    REQUIRE(loaded.graph->GetEdge(0).weight == 4);
+    REQUIRE(loaded.graph->GetEdge(0).modes.mask == TransportBit(Transport::Car));
+    REQUIRE(loaded.graph->GetEdge(2).weight == -1);
+    REQUIRE(loaded.graph->GetVertex(2)->transfer.GetCost(Transport::Bus, Transport::Feet) == 7);
+    REQUIRE(loaded.graph->GetVertex(1)->transfer.GetCost(Transport::Bus, Transport::Feet) == kNoTransferCost);
+    REQUIRE(loaded.coordinates.GetLength() == 0);
+    REQUIRE(ArcVertices(loaded.graph->GetArcs(2)) == std::vector<size_t>{1, 3});
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "lab3_roads_test.lab3";
+    SaveGraphBinary(roads, path.string());
+    REQUIRE(IsGraphBinary(path.string()));
+    const GraphData reloaded = LoadGraphBinary(path.string());
+    std::filesystem::remove(path);
+    REQUIRE(reloaded.graph->IsDirected());
+    REQUIRE(reloaded.external_ids.Get(0) == 9000000001);
+    REQUIRE(reloaded.coordinates.Get(2).x == 30.3);
+    REQUIRE(ArcVertices(reloaded.graph->GetArcs(1)) == ArcVertices(roads.graph->GetArcs(1)));
+    REQUIRE(reloaded.graph->GetVertex(0)->transfer.GetCost(Transport::Car, Transport::Feet) == 0);
+
+    std::stringstream truncated(buffer.str().substr(0, 60));
+    REQUIRE_THROWS_AS(ReadGraphBinary(truncated), std::invalid_argument);
+
+    // Counts read from a truncated or corrupt file are rejected before anything of their size is allocated.
+    const std::string bytes = buffer.str();
+    const size_t edge_count_offset = 24;
+    const size_t transfer_count_offset = 32 + 8 + 9 * 8;
+    auto patched = [&](size_t offset, uint64_t value) {
+        std::string copy = bytes;
+        std::memcpy(copy.data() + offset, &value, sizeof(value));
+        return copy;
+    };
+    for (const std::string& corrupt :
+         {bytes.substr(0, bytes.size() - 1), patched(edge_count_offset, uint64_t{1} << 40),
+          patched(transfer_count_offset, uint64_t{1} << 50), patched(16, uint64_t{1} << 33),
+          patched(edge_count_offset, std::numeric_limits<uint64_t>::max())}) {
+        std::stringstream in(corrupt);
+        REQUIRE_THROWS_AS(ReadGraphBinary(in), std::invalid_argument);
+    }
+    const std::filesystem::path cut = std::filesystem::temp_directory_path() / "lab3_truncated_test.lab3";
+    {
+        std::ofstream out(cut, std::ios::binary);
+        out << patched(edge_count_offset, uint64_t{1} << 40);
+    }
+    REQUIRE(IsGraphBinary(cut.string()));
+    REQUIRE_THROWS_WITH(LoadGraphBinary(cut.string()), "Binary graph is truncated");
+    std::filesystem::remove(cut);
+}
+
+TEST_CASE("GraphGenerators") {
+    auto pair_set = [](const EdgeList& list) {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (const Edge& edge : list.edges) {
+            pairs.emplace_back(edge.u, edge.v);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    };
+
+    for (bool directed : {false, true}) {
+        // Sparse and dense requests (the latter goes through the complement) give distinct pairs.
+        for (size_t m : {size_t{300}, size_t{1150}}) {
+            const EdgeList list = GenerateUniform(50, m, directed, {.seed = 7, .min_weight = 2, .max_weight = 4});
+            REQUIRE(list.edges.GetLength() == m);
+            const auto pairs = pair_set(list);
+            REQUIRE(std::adjacent_find(pairs.begin(), pairs.end()) == pairs.end());
+            size_t bad = 0;
+            for (const Edge& edge : list.edges) {
+                bad += edge.u == edge.v || edge.u >= 50 || edge.v >= 50 || (!directed && edge.u > edge.v) ||
+                       edge.weight < 2 || edge.weight > 4;
+            }
+            REQUIRE(bad == 0);
+        }
+    }
+    REQUIRE(GenerateUniform(50, 1225, false).edges.GetLength() == 1225);
+    REQUIRE_THROWS_AS(GenerateUniform(50, 1226, false), std::invalid_argument);
+    // No u * n + v keys any more: huge vertex counts are fine.
+    const EdgeList huge = GenerateUniform(size_t{1} << 40, 1000, true, {.seed = 1});
+    REQUIRE(huge.edges.GetLength() == 1000);
+
+    // Output depends on the seed only, not on the thread count.
+    const EdgeList one = GenerateRmat(12, 200000, {}, {.seed = 3, .threads = 1});
+    const EdgeList four = GenerateRmat(12, 200000, {}, {.seed = 3, .threads = 4});
+    const EdgeList other = GenerateRmat(12, 200000, {}, {.seed = 4, .threads = 4});
+    REQUIRE(one.vertex_count == 4096);
+    REQUIRE(SameEdges(one.edges, four.edges));
+    REQUIRE_FALSE(SameEdges(one.edges, other.edges));
+    size_t low_quadrant = 0;
+    for (const Edge& edge : one.edges) {
+        low_quadrant += edge.u < 2048 && edge.v < 2048;
+    }
+    REQUIRE(low_quadrant > one.edges.GetLength() / 2);
+    REQUIRE_THROWS_AS(GenerateRmat(4, 10, {0.5, 0, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS(GenerateRmat(4, 10, {1, 0, 0}), std::invalid_argument);
+    const EdgeList skewed = GenerateRmat(4, 1000, {0.5, 0, 0.01});
+    for (const Edge& edge : skewed.edges) {
+        REQUIRE(edge.u != edge.v);
+    }
+
+    const EdgeList grid = GenerateGrid(30, 40, 0);
+    REQUIRE(grid.vertex_count == 1200);
+    REQUIRE(grid.edges.GetLength() == 29 * 40 + 30 * 39);
+    REQUIRE(GridCoordinates(30, 40).Get(41).x == 1);
+    REQUIRE(GridCoordinates(30, 40).Get(41).y == 1);
+    const EdgeList sparse_grid = GenerateGrid(30, 40, 0.5, {.seed = 2});
+    REQUIRE(sparse_grid.edges.GetLength() < grid.edges.GetLength() * 3 / 4);
+
+    const EdgeList ba = GenerateBarabasiAlbert(20000, 3, {.seed = 5, .threads = 3});
+    REQUIRE(SameEdges(ba.edges, GenerateBarabasiAlbert(20000, 3, {.seed = 5, .threads = 1}).edges));
+    std::vector<size_t> degree(ba.vertex_count);
+    size_t later_targets = 0;
+    for (const Edge& edge : ba.edges) {
+        later_targets += edge.v >= edge.u;
+        ++degree[edge.u];
+        ++degree[edge.v];
+    }
+    REQUIRE(later_targets == 0);
+    // Preferential attachment: early vertices become hubs far above the mean degree of 6.
+    REQUIRE(*std::max_element(degree.begin(), degree.end()) > 100);
+
+    MultimodalParams params;
+    params.rows = 12;
+    params.cols = 12;
+    params.bus_lines = 3;
+    params.stop_spacing = 3;
+    const EdgeList city = GenerateMultimodal(params, {.seed = 9});
+    REQUIRE(city.transfers.GetLength() >= 3 * 4);
+    IGraphPtr graph = BuildGenerated(city, false, {.base = TransferMatrix::Diagonal(0)}, {.seed = 9});
+    size_t bus_arcs = 0;
+    for (size_t id = 0; id < graph->GetEdgeCount(); ++id) {
+        const Edge edge = graph->GetEdge(id);
+        if (edge.Allows(Transport::Bus)) {
+            ++bus_arcs;
+            REQUIRE_FALSE(edge.Allows(Transport::Car));
+        } else {
+            REQUIRE(edge.GetWeight(Transport::Feet) == 4 * edge.GetWeight(Transport::Car));
+        }
+    }
+    REQUIRE(bus_arcs == city.transfers.GetLength() - 3);
+    const size_t stop = city.transfers.Get(0).vertex;
+    REQUIRE(graph->GetVertex(stop)->transfer.GetCost(Transport::Feet, Transport::Bus) >= 1);
+    REQUIRE(Dijkstra(graph, 0).GetDistance(params.rows * params.cols - 1) < kInf);
+
+    TransferProfile profile;
+    profile.change_probability = 1;
+    profile.min_cost = 3;
+    profile.max_cost = 3;
+    IGraphPtr uniform = BuildGenerated(GenerateUniform(100, 300, true), true, profile);
+    REQUIRE(uniform->GetVertex(17)->transfer.GetCost(Transport::Car, Transport::Bus) == 3);
+    REQUIRE(uniform->GetVertex(17)->transfer.GetCost(Transport::Car, Transport::Car) == 0);
+}
+
+TEST_CASE("QueryServer") {
+    ThreadPool pool(3);
+    std::vector<int> squares(1000);
+    pool.ParallelFor(squares.size(), [&](size_t i) { squares[i] = static_cast<int>(i * i); });
+    REQUIRE(squares[999] == 999 * 999);
+    REQUIRE_THROWS_AS(pool.ParallelFor(100, [](size_t i) {
+        if (i == 42) {
+            throw std::runtime_error("boom");
+        }
+    }),
+                      std::runtime_error);
+
+    // Nested calls from every worker at once: helpers queued behind the blocked workers must not be waited for.
+    std::atomic<size_t> nested_sum = 0;
+    std::vector<std::future<void>> outer;
+    for (size_t task = 0; task < 6; ++task) {
+        auto done = std::make_shared<std::promise<void>>();
+        outer.push_back(done->get_future());
+        pool.Post([&pool, &nested_sum, done] {
+            pool.ParallelFor(50, [&](size_t i) { nested_sum += i; });
+            done->set_value();
+        });
+    }
+    for (auto& future : outer) {
+        REQUIRE(future.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    }
+    REQUIRE(nested_sum == 6 * (49 * 50 / 2));
+
+    IGraphPtr graph = BuildGenerated(GenerateGrid(20, 20), false);
+    QueryServer server(graph, {.threads = 2, .max_batch = 8});
+    const int64_t expected = Dijkstra(graph, 3).GetDistance(250);
+    REQUIRE(server.Handle("dist 3 250") == "ok " + std::to_string(expected));
+    REQUIRE(server.Handle("  path 5 5 ") == "ok 0 5");
+    std::string long_path = "ok " + std::to_string(Dijkstra(graph, 3).GetDistance(397));
+    for (size_t vertex : ToVector(Dijkstra(graph, 3).GetShortestPath(397))) {
+        long_path += " " + std::to_string(vertex);
+    }
+    REQUIRE(server.Handle("path 3 397") == long_path);
+    REQUIRE(server.Handle("ping") == "ok pong");
+    REQUIRE(server.Handle("info") == "ok n=400 m=" + std::to_string(graph->GetEdgeCount()) + " directed=0");
+    REQUIRE(server.Handle("matrix 0,1 0,1,2").find("ok 0,") == 0);
+    REQUIRE(server.Handle("dist 3").rfind("err ", 0) == 0);
+    REQUIRE(server.Handle("dist 3 400").rfind("err ", 0) == 0);
+    REQUIRE(server.Handle("fly 1 2") == "err unknown command 'fly'");
+    REQUIRE(server.GetStats().errors == 3);
+
+    // A disconnected vertex answers inf, a path lists its vertices.
+    IGraphPtr islands = std::make_shared<Graph>(3);
+    islands->AddEdge({0, 1, 4});
+    QueryServer small(islands, {.threads = 1});
+    REQUIRE(small.Handle("dist 0 2") == "ok inf");
+    REQUIRE(small.Handle("path 1 0") == "ok 4 1 0");
+
+    // Pipelined stream: one response per non-blank line, in order, nothing after quit.
+    std::istringstream in("dist 0 1\n\nping\r\nbogus\nmatrix 0,2 1\nquit\ndist 0 1\n");
+    std::ostringstream out;
+    small.Serve(in, out);
+    REQUIRE(out.str() == "ok 4\nok pong\nerr unknown command 'bogus'\nok 4;inf\nok bye\n");
+
+    const std::string socket_path = (std::filesystem::temp_directory_path() / "lab3_query_test.sock").string();
+    std::thread serving([&] { server.ServeUnixSocket(socket_path); });
+    LoadReport report;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        try {
+            report = RunLoad(socket_path, {.requests = 500, .connections = 3, .pipeline = 8, .matrix_percent = 10});
+            break;
+        } catch (const std::runtime_error&) {
+            // The listener is not up yet.
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    server.Stop();
+    serving.join();
+    REQUIRE(report.requests == 500);
+    REQUIRE(report.errors == 0);
+    REQUIRE(report.p50 <= report.p99);
+    REQUIRE(report.p99 <= report.max);
+    REQUIRE(server.GetStats().connections >= 4);
+    REQUIRE_FALSE(std::filesystem::exists(socket_path));
+
+    ArraySequence<double> samples;
+    for (int i = 1; i <= 100; ++i) {
+        samples.Append(i);
+    }
+    REQUIRE(Percentile(samples, 0.5) == 50);
+    REQUIRE(Percentile(samples, 0.99) == 99);
+    REQUIRE(Percentile(samples, 1) == 100);
+}
+
+// Minimal eager coroutine type for driving co_await in tests.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {
+        }
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+DetachedTask AwaitDistance(AsyncQueryEngine& engine, size_t from, size_t to, std::promise<int64_t>& out) {
+    ArraySequence<size_t> targets(1, to);
+    try {
+        const AsyncQueryResult result = co_await engine.Query(from, targets);
+        out.set_value(result.distances.Get(0));
+    } catch (...) {
+        out.set_exception(std::current_exception());
+    }
+}
+
+TEST_CASE("AsyncQueries") {
+    IGraphPtr graph = BuildGenerated(GenerateUniform(300, 1500, true, {.seed = 11}), true);
+    AsyncQueryEngine engine(graph, 2);
+    ArraySequence<size_t> targets;
+    for (size_t v = 0; v < 300; v += 7) {
+        targets.Append(v);
+    }
+
+    std::future<AsyncQueryResult> dist = engine.Submit(4, targets);
+    AsyncQueryOptions paths_options;
+    paths_options.with_paths = true;
+    std::future<AsyncQueryResult> path = engine.Submit(4, targets, paths_options);
+    const AsyncQueryResult result = dist.get();
+    REQUIRE(result.IsComplete());
+    REQUIRE(result.answered == targets.GetLength());
+    const Dijkstra reference(graph, 4);
+    size_t mismatches = 0;
+    const AsyncQueryResult with_paths = path.get();
+    for (size_t i = 0; i < targets.GetLength(); ++i) {
+        mismatches += result.distances.Get(i) != reference.GetDistance(targets.Get(i));
+        mismatches += (with_paths.paths.Get(i) == nullptr) != (result.distances.Get(i) == kInf);
+    }
+    REQUIRE(mismatches == 0);
+
+    // Stopped queries are not solved.
+    std::stop_source source;
+    source.request_stop();
+    const AsyncQueryResult cancelled = engine.Submit(5, targets, {.cancel = {source.get_token()}}).get();
+    REQUIRE(cancelled.stopped == StopReason::Cancelled);
+    REQUIRE(cancelled.answered == 0);
+    const CacheStats before = engine.GetCacheStats();
+    const AsyncQueryResult late =
+        engine.Submit(6, targets, {.cancel = CancellationToken::WithTimeout(std::chrono::seconds(-1))}).get();
+    REQUIRE(late.stopped == StopReason::DeadlineExceeded);
+    REQUIRE_FALSE(late.IsComplete());
+    REQUIRE(engine.GetCacheStats().misses == before.misses);
+
+    // Errors reach the future, the callback and the awaiting coroutine.
+    REQUIRE_THROWS_AS(engine.Submit(300, targets).get(), std::out_of_range);
+    std::promise<bool> failed;
+    engine.Submit(0, ArraySequence<size_t>(1, size_t{1000}), {},
+                  [&](AsyncQueryResult r) { failed.set_value(r.error != nullptr); });
+    REQUIRE(failed.get_future().get());
+
+    std::promise<int64_t> awaited;
+    AwaitDistance(engine, 4, 21, awaited);
+    REQUIRE(awaited.get_future().get() == reference.GetDistance(21));
+    std::promise<int64_t> awaited_error;
+    AwaitDistance(engine, 4, 1000, awaited_error);
+    REQUIRE_THROWS_AS(awaited_error.get_future().get(), std::out_of_range);
+}
+
+TEST_CASE("SolverCancellation") {
+    // Reversed chain: every Bellman-Ford pass moves the frontier by one vertex only.
+    const size_t n = 3000;
+    auto chain = std::make_shared<DirectedGraph>(n);
+    for (size_t v = 0; v + 1 < n; ++v) {
+        chain->AddEdge({v + 1, v, 1});
+    }
+
+    std::stop_source source;
+    source.request_stop();
+    const CancellationToken cancelled{source.get_token()};
+    const Dijkstra stopped(chain, n - 1, cancelled);
+    REQUIRE(stopped.GetStopReason() == StopReason::Cancelled);
+    REQUIRE_FALSE(stopped.IsComplete());
+    REQUIRE(stopped.GetDistance(n - 1) == 0);
+    REQUIRE(stopped.GetDistance(0) == kInf);
+    REQUIRE(Dijkstra(chain, n - 1).IsComplete());
+
+    const auto start = std::chrono::steady_clock::now();
+    const FordBellman runaway(chain, n - 1, CancellationToken::WithTimeout(std::chrono::milliseconds(5)));
+    REQUIRE(runaway.GetStopReason() == StopReason::DeadlineExceeded);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    // The work done so far is kept: the frontier vertices already have their exact distances.
+    REQUIRE(runaway.GetDistance(n - 2) == 1);
+    REQUIRE(runaway.GetShortestPath(n - 2) != nullptr);
+
+    auto compact = std::make_shared<CompactGraph64>(CompactGraph64::FromGraph(*chain));
+    REQUIRE(CompactDijkstra64(compact, n - 1, cancelled).GetStopReason() == StopReason::Cancelled);
+    REQUIRE(CompactFordBellman64(compact, n - 1, cancelled).GetStopReason() == StopReason::Cancelled);
+    REQUIRE(CompactDijkstra64(compact, n - 1).GetDistance(0) == static_cast<int64_t>(n - 1));
+
+    // Aborted trees are handed out but never cached.
+    ShortestPathsCache cache(chain, size_t{1} << 24);
+    REQUIRE_FALSE(cache.Get(n - 1, Algorithm::Dijkstra, cancelled)->IsComplete());
+    REQUIRE(cache.Get(n - 1)->IsComplete());
+    REQUIRE(cache.GetStats().misses == 2);
+
+    AsyncQueryEngine engine(chain, 1);
+    AsyncQueryOptions options;
+    options.algorithm = Algorithm::FordBellman;
+    options.cancel = CancellationToken::WithTimeout(std::chrono::milliseconds(5));
+    const AsyncQueryResult result = engine.Submit(n - 1, ArraySequence<size_t>(1, size_t{0}), options).get();
+    REQUIRE(result.stopped == StopReason::DeadlineExceeded);
+    REQUIRE(result.answered == 0);
+
+    QueryServer server(chain, {.threads = 1, .algorithm = Algorithm::FordBellman,
+                               .query_timeout = std::chrono::milliseconds(5)});
+    REQUIRE(server.Handle("dist 2999 0") == "err deadline exceeded");
+    REQUIRE(server.GetStats().timeouts == 1);
+}
+
+TEST_CASE("VersionedGraph") {
+    const EdgeList grid = GenerateGrid(20, 20);
+    VersionedGraph versioned(grid.vertex_count, false, grid.edges);
+    const GraphSnapshotPtr first = versioned.GetSnapshot();
+    REQUIRE(first->GetVersion() == 1);
+    REQUIRE(first->GetEdgeCount() == grid.edges.GetLength());
+    RequireSameGraph(*first, *Graph::Build(grid.vertex_count, grid.edges));
+    REQUIRE_THROWS_AS(first->AddEdge({0, 1}), std::logic_error);
+
+    // A new version copies only what it touches; the old one is unchanged.
+    const size_t edge = 5;
+    const Edge before = first->GetEdge(edge);
+    versioned.UpdateEdgeWeight(edge, 100);
+    const GraphSnapshotPtr second = versioned.GetSnapshot();
+    REQUIRE(second->GetVersion() == 2);
+    REQUIRE(first->GetEdge(edge).weight == before.weight);
+    REQUIRE(second->GetEdge(edge).weight == 100);
+    REQUIRE(first->GetVertex(before.u) != second->GetVertex(before.u));
+    REQUIRE(first->GetVertex(399) == second->GetVertex(399));
+    REQUIRE(Dijkstra(first, before.u).GetDistance(before.v) == before.weight);
+    REQUIRE(Dijkstra(second, before.u).GetDistance(before.v) > before.weight);
+
+    const size_t extra = versioned.AddEdge({0, 399, 1});
+    versioned.RemoveEdge(edge);
+    const GraphSnapshotPtr third = versioned.GetSnapshot();
+    REQUIRE_FALSE(third->HasEdge(edge));
+    REQUIRE(second->HasEdge(edge));
+    REQUIRE(Dijkstra(third, 399).GetDistance(0) == 1);
+    REQUIRE(third->GetEdgeCount() == grid.edges.GetLength());
+    REQUIRE_THROWS_AS(versioned.RemoveEdge(edge), std::out_of_range);
+    REQUIRE(versioned.GetVersion() == 4);
+    ArraySequence<EdgeUpdate> updates;
+    updates.Append({extra, 0, true});
+    updates.Append({edge, 3});
+    REQUIRE_THROWS_AS(versioned.ApplyUpdates(updates), std::out_of_range);
+    REQUIRE(versioned.GetSnapshot()->HasEdge(extra));
+
+    // Readers race a writer that sets every weight to k in one version: a snapshot must never mix
+    // two versions, so the corner-to-corner distance is always 38 * k.
+    versioned.RemoveEdge(extra);
+    versioned.AddEdge(before);
+    auto set_all = [&](int64_t k) {
+        ArraySequence<EdgeUpdate> all;
+        for (size_t id = 0; id < versioned.GetSnapshot()->GetEdgeCount() + 2; ++id) {
+            if (versioned.GetSnapshot()->HasEdge(id)) {
+                all.Append({id, k});
+            }
+        }
+        versioned.ApplyUpdates(all);
+    };
+    set_all(1);
+    std::atomic<bool> done = false;
+    std::atomic<size_t> torn = 0;
+    std::atomic<size_t> queries = 0;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            while (!done || queries == 0) {
+                const GraphSnapshotPtr snapshot = versioned.GetSnapshot();
+                const int64_t k = snapshot->GetEdge(0).weight;
+                torn += Dijkstra(snapshot, 0).GetDistance(399) != 38 * k;
+                ++queries;
+            }
+        });
+    }
+    for (int64_t k = 2; k <= 30; ++k) {
+        set_all(k);
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(torn == 0);
+    REQUIRE(queries > 0);
+    REQUIRE(Dijkstra(versioned.GetSnapshot(), 0).GetDistance(399) == 38 * 30);
+}
+
+TEST_CASE("NumaPlacement") {
+    const ArraySequence<size_t> cpus = ParseCpuList("0-3,8,10-11\n");
+    REQUIRE(cpus.GetLength() == 7);
+    REQUIRE(cpus.Get(4) == 8);
+    REQUIRE(cpus.Get(6) == 11);
+    REQUIRE(ParseCpuList("").GetLength() == 0);
+    REQUIRE_THROWS_AS(ParseCpuList("3-1"), std::invalid_argument);
+
+    const NumaTopology detected = DetectNumaTopology();
+    REQUIRE(detected.GetNodeCount() >= 1);
+    REQUIRE(detected.node_ids.GetLength() == detected.GetNodeCount());
+    REQUIRE(detected.GetCpuCount() >= 1);
+
+    // Two fake nodes of two CPUs: workers fill node 0 first.
+    NumaTopology two;
+    two.node_ids.Append(0);
+    two.node_ids.Append(1);
+    two.node_cpus.Append(ParseCpuList("0-1"));
+    two.node_cpus.Append(ParseCpuList("2-3"));
+    REQUIRE(two.GetWorkerNode(1) == 0);
+    REQUIRE(two.GetWorkerNode(2) == 1);
+    REQUIRE(two.GetWorkerNode(4) == 0);
+
+    IGraphPtr graph = BuildGenerated(GenerateUniform(400, 2400, true, {.seed = 8}), true);
+    auto compact = std::make_shared<const CompactGraph64>(CompactGraph64::FromGraph(*graph));
+    ArraySequence<size_t> sources;
+    for (size_t s = 0; s < 400; s += 13) {
+        sources.Append(s);
+    }
+    std::vector<int64_t> expected(sources.GetLength() * 5);
+    for (size_t i = 0; i < sources.GetLength(); ++i) {
+        const CompactDijkstra64 finder(compact, sources.Get(i));
+        for (size_t t = 0; t < 5; ++t) {
+            expected[i * 5 + t] = finder.GetDistance(t * 97);
+        }
+    }
+
+    const NumaPlacement placements[] = {NumaPlacement::Shared, NumaPlacement::Interleave, NumaPlacement::Replicate};
+    for (NumaPlacement placement : placements) {
+        for (const NumaTopology& topology : {detected, two}) {
+            const NumaGraphReplicas<uint32_t, int64_t> replicas(compact, placement, topology);
+            REQUIRE(replicas.GetReplicaCount() ==
+                    (placement == NumaPlacement::Replicate ? topology.GetNodeCount() : size_t{1}));
+            REQUIRE(replicas.GetForNode(topology.GetNodeCount() - 1)->GetArcCount() == compact->GetArcCount());
+            std::vector<int64_t> got(expected.size());
+            ForEachSource(replicas, sources, {.threads = 3}, [&](size_t i, const CompactDijkstra64& finder) {
+                for (size_t t = 0; t < 5; ++t) {
+                    got[i * 5 + t] = finder.GetDistance(t * 97);
+                }
+            });
+            REQUIRE(got == expected);
+        }
+    }
+
+    // Recycled buffers give the same answers as fresh ones.
+    CompactDijkstra64 first(compact, 5);
+    const int64_t distance = first.GetDistance(300);
+    CompactDijkstra64 second(compact, 7, first.TakeBuffers());
+    CompactDijkstra64 third(compact, 5, second.TakeBuffers());
+    REQUIRE(third.GetDistance(300) == distance);
+    REQUIRE(third.GetDistance(5) == 0);
+
+    const NumaGraphReplicas<uint32_t, int64_t> shared(compact, NumaPlacement::Shared, detected);
+    REQUIRE_THROWS_AS(ForEachSource(shared, ArraySequence<size_t>(2, size_t{400}), {},
+                                    [](size_t, const CompactDijkstra64&) {}),
+                      std::out_of_range);
+}